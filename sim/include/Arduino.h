@@ -0,0 +1,198 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Minimal Arduino core surface for the native simulation build.
+// Only what the firmware sources actually use is provided; time is driven by
+// the virtual clock in SimPlatform, UARTs are in-memory byte queues.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <deque>
+#include <string>
+
+#define SERIAL_8N1 0x800001c
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+// Sketch entry points (main.cpp)
+void setup();
+void loop();
+
+//========================= String =========================
+class String {
+private:
+  std::string str;
+
+public:
+  String() {}
+  String(const char* s) : str(s ? s : "") {}
+  String(const std::string& s) : str(s) {}
+  String(char c) : str(1, c) {}
+  String(int v) : str(std::to_string(v)) {}
+  String(unsigned int v) : str(std::to_string(v)) {}
+  String(long v) : str(std::to_string(v)) {}
+  String(unsigned long v) : str(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { setFloat(v, decimals); }
+  String(double v, unsigned int decimals = 2) { setFloat(v, decimals); }
+  
+  const char* c_str() const { return str.c_str(); }
+  unsigned int length() const { return str.length(); }
+  bool reserve(unsigned int size) { str.reserve(size); return true; }
+  bool isEmpty() const { return str.empty(); }
+  char operator[](unsigned int idx) const { return idx < str.length() ? str[idx] : 0; }
+  
+  bool concat(const char* s) { if (s) str += s; return true; }
+  bool concat(const String& s) { str += s.str; return true; }
+  bool concat(char c) { str += c; return true; }
+  
+  String& operator+=(const String& s) { str += s.str; return *this; }
+  String& operator+=(const char* s) { if (s) str += s; return *this; }
+  String& operator+=(char c) { str += c; return *this; }
+  
+  bool operator==(const String& s) const { return str == s.str; }
+  bool operator==(const char* s) const { return str == (s ? s : ""); }
+  bool operator!=(const String& s) const { return !(*this == s); }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  
+  friend String operator+(const String& a, const String& b) { return String(a.str + b.str); }
+  friend String operator+(const String& a, const char* b) { return String(a.str + (b ? b : "")); }
+  friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.str); }
+
+private:
+  void setFloat(double v, unsigned int decimals) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    str = buf;
+  }
+};
+
+// ArduinoJson's String adapters refer to this type
+class StringSumHelper : public String {
+public:
+  using String::String;
+};
+
+//========================= Print / Stream =========================
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  
+  size_t println() { return write('\n'); }
+  size_t println(const char* s) { return print(s) + println(); }
+  size_t println(const String& s) { return print(s) + println(); }
+  size_t println(int v) { return print(v) + println(); }
+  
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    return write((const uint8_t*)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+  }
+  
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+//========================= HardwareSerial =========================
+// In-memory UART: the firmware reads from rxQueue and writes to txQueue,
+// the simulation driver fills/drains them from the other side.
+class HardwareSerial : public Stream {
+private:
+  std::deque<uint8_t> rxQueue;
+  std::deque<uint8_t> txQueue;
+  unsigned long baud;
+  bool echoToStdout;
+  bool captureTx;
+
+public:
+  explicit HardwareSerial(bool echo = false, bool capture = true)
+    : baud(0), echoToStdout(echo), captureTx(capture) {}
+  
+  void begin(unsigned long baudRate, uint32_t config = SERIAL_8N1,
+             int8_t rxPin = -1, int8_t txPin = -1) {
+    (void)config; (void)rxPin; (void)txPin;
+    baud = baudRate;
+  }
+  void end() {}
+  unsigned long baudRate() const { return baud; }
+  operator bool() const { return true; }
+  
+  int available() override { return (int)rxQueue.size(); }
+  int read() override {
+    if (rxQueue.empty()) return -1;
+    uint8_t c = rxQueue.front();
+    rxQueue.pop_front();
+    return c;
+  }
+  int peek() override { return rxQueue.empty() ? -1 : rxQueue.front(); }
+  
+  using Print::write;
+  size_t write(uint8_t c) override {
+    if (echoToStdout) fputc(c, stdout);
+    if (captureTx) txQueue.push_back(c);
+    return 1;
+  }
+  int availableForWrite() { return 4096; }  // Never full: the driver drains it every iteration
+  
+  // Simulation side
+  void setEcho(bool echo) { echoToStdout = echo; }
+  void setCapture(bool capture) { captureTx = capture; }
+  void injectRx(const uint8_t* data, size_t len) { rxQueue.insert(rxQueue.end(), data, data + len); }
+  size_t rxPending() const { return rxQueue.size(); }
+  size_t txPending() const { return txQueue.size(); }
+  int takeTx() {
+    if (txQueue.empty()) return -1;
+    uint8_t c = txQueue.front();
+    txQueue.pop_front();
+    return c;
+  }
+};
+
+extern HardwareSerial Serial;   // USB log
+extern HardwareSerial Serial1;  // Meshtastic
+extern HardwareSerial Serial2;  // LD2450
+
+//========================= ESP =========================
+// Heap figures come from the allocation tracker in SimPlatform
+class EspClass {
+public:
+  uint32_t getHeapSize();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+};
+
+extern EspClass ESP;
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,93 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+// In-memory NVS for the native simulation build. Mirrors the ESP32
+// Preferences semantics the firmware relies on: opening a namespace
+// read-only fails if it was never written.
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class Preferences {
+private:
+  typedef std::map<std::string, std::string> Namespace;
+  static std::map<std::string, Namespace>& storage();
+  
+  Namespace* ns;
+  bool readOnly;
+  
+  size_t putRaw(const char* key, const void* value, size_t len) {
+    if (!ns || readOnly) return 0;
+    (*ns)[key].assign((const char*)value, len);
+    return len;
+  }
+  
+  template <typename T>
+  T getRaw(const char* key, T defaultValue) {
+    if (!ns) return defaultValue;
+    Namespace::const_iterator it = ns->find(key);
+    if (it == ns->end() || it->second.size() != sizeof(T)) return defaultValue;
+    T value;
+    memcpy(&value, it->second.data(), sizeof(T));
+    return value;
+  }
+
+public:
+  Preferences() : ns(nullptr), readOnly(false) {}
+  
+  bool begin(const char* name, bool readOnlyMode = false) {
+    std::map<std::string, Namespace>& all = storage();
+    if (readOnlyMode && all.find(name) == all.end()) return false;
+    ns = &all[name];
+    readOnly = readOnlyMode;
+    return true;
+  }
+  void end() { ns = nullptr; }
+  
+  bool clear() { if (!ns || readOnly) return false; ns->clear(); return true; }
+  bool remove(const char* key) { return ns && !readOnly && ns->erase(key) > 0; }
+  bool isKey(const char* key) { return ns && ns->find(key) != ns->end(); }
+  
+  size_t putInt(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putUInt(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putULong(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putBool(const char* key, bool value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putFloat(const char* key, float value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putBytes(const char* key, const void* value, size_t len) { return putRaw(key, value, len); }
+  size_t putString(const char* key, const char* value) { return putRaw(key, value, strlen(value)); }
+  size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+  
+  int32_t getInt(const char* key, int32_t defaultValue = 0) { return getRaw(key, defaultValue); }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return getRaw(key, defaultValue); }
+  uint32_t getULong(const char* key, uint32_t defaultValue = 0) { return getRaw(key, defaultValue); }
+  bool getBool(const char* key, bool defaultValue = false) { return getRaw(key, defaultValue); }
+  float getFloat(const char* key, float defaultValue = 0) { return getRaw(key, defaultValue); }
+  
+  size_t getBytesLength(const char* key) {
+    if (!ns) return 0;
+    Namespace::const_iterator it = ns->find(key);
+    return it == ns->end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!ns) return 0;
+    Namespace::const_iterator it = ns->find(key);
+    if (it == ns->end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  String getString(const char* key, const String& defaultValue = String()) {
+    if (!ns) return defaultValue;
+    Namespace::const_iterator it = ns->find(key);
+    return it == ns->end() ? defaultValue : String(it->second);
+  }
+  size_t getString(const char* key, char* value, size_t maxLen) {
+    if (!ns || maxLen == 0) return 0;
+    Namespace::const_iterator it = ns->find(key);
+    if (it == ns->end() || it->second.size() + 1 > maxLen) return 0;
+    memcpy(value, it->second.c_str(), it->second.size() + 1);
+    return it->second.size() + 1;
+  }
+};
+
+#endif // SIM_PREFERENCES_H
@@ -0,0 +1,37 @@
+#ifndef SIM_PLATFORM_H
+#define SIM_PLATFORM_H
+
+// Control surface of the native simulation platform, used by the
+// simulation driver (never by firmware code).
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sim {
+
+// Virtual clock - advances only through delay() or advanceMs()
+unsigned long nowMs();
+void advanceMs(unsigned long ms);
+
+// Heap usage as seen through operator new/delete
+struct HeapStats {
+  size_t currentBytes;
+  size_t peakBytes;
+  unsigned long allocations;
+};
+
+HeapStats heapStats();
+
+// Deliver one BLE advertisement to the firmware's scan handler, as the BLE
+// host task would (no-op until the firmware started scanning)
+void injectBleAdvertisement(uint64_t address, int rssi);
+
+// Bytes held by the in-memory flash file system
+size_t flashUsedBytes();
+
+// Simulated heap size reported through ESP.getHeapSize()
+static constexpr uint32_t SIM_HEAP_SIZE = 320 * 1024;
+
+}  // namespace Sim
+
+#endif // SIM_PLATFORM_H
@@ -0,0 +1,131 @@
+#ifndef SIM_U8G2LIB_H
+#define SIM_U8G2LIB_H
+
+// Headless 128x64 monochrome framebuffer standing in for the SH1106 driver
+// in the native simulation build. Uses the same page layout as U8g2
+// (8 pages of 128 bytes, LSB = top row) so buffer-level code behaves alike.
+// Glyphs are rendered as filled cells of the font's nominal size.
+
+#include <Arduino.h>
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+// drawCircle()/drawDisc() quadrant options
+#define U8G2_DRAW_UPPER_RIGHT 0x01
+#define U8G2_DRAW_UPPER_LEFT 0x02
+#define U8G2_DRAW_LOWER_LEFT 0x04
+#define U8G2_DRAW_LOWER_RIGHT 0x08
+#define U8G2_DRAW_ALL 0x0F
+
+// Font descriptor: { glyph width, glyph height (ascent) }
+extern const uint8_t u8g2_font_t0_22_tr[];
+extern const uint8_t u8g2_font_t0_17_tr[];
+extern const uint8_t u8g2_font_t0_12_tr[];
+extern const uint8_t u8g2_font_6x10_tr[];
+extern const uint8_t u8g2_font_5x7_tr[];
+extern const uint8_t u8g2_font_tom_thumb_4x6_tr[];
+
+class U8G2 {
+public:
+  static const int WIDTH = 128;
+  static const int HEIGHT = 64;
+
+private:
+  uint8_t buffer[WIDTH * HEIGHT / 8];
+  const uint8_t* font;
+  uint8_t drawColor;
+  uint8_t contrast;
+
+public:
+  U8G2() : font(u8g2_font_t0_12_tr), drawColor(1), contrast(255) {
+    memset(buffer, 0, sizeof(buffer));
+  }
+  virtual ~U8G2() {}
+  
+  bool begin() { clearBuffer(); return true; }
+  void setContrast(uint8_t value) { contrast = value; }
+  void setDrawColor(uint8_t color) { drawColor = color; }
+  void setFont(const uint8_t* f) { font = f; }
+  void clearBuffer() { memset(buffer, 0, sizeof(buffer)); }
+  void sendBuffer() {
+    sendCount()++;
+    delay(pushCostMs());
+  }
+  
+  uint8_t* getBufferPtr() { return buffer; }
+  uint8_t getBufferTileWidth() const { return WIDTH / 8; }
+  uint8_t getBufferTileHeight() const { return HEIGHT / 8; }
+  
+  void drawPixel(int x, int y) {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+    uint8_t mask = (uint8_t)(1 << (y & 7));
+    uint8_t& cell = buffer[(y >> 3) * WIDTH + x];
+    if (drawColor == 1) cell |= mask;
+    else if (drawColor == 0) cell &= (uint8_t)~mask;
+    else cell ^= mask;
+  }
+  void drawHLine(int x, int y, int w) { for (int i = 0; i < w; i++) drawPixel(x + i, y); }
+  void drawVLine(int x, int y, int h) { for (int i = 0; i < h; i++) drawPixel(x, y + i); }
+  void drawLine(int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+      drawPixel(x0, y0);
+      if (x0 == x1 && y0 == y1) break;
+      int e2 = 2 * err;
+      if (e2 >= dy) { err += dy; x0 += sx; }
+      if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+  }
+  void drawBox(int x, int y, int w, int h) { for (int i = 0; i < h; i++) drawHLine(x, y + i, w); }
+  void drawFrame(int x, int y, int w, int h) {
+    drawHLine(x, y, w); drawHLine(x, y + h - 1, w);
+    drawVLine(x, y, h); drawVLine(x + w - 1, y, h);
+  }
+  void drawCircle(int x0, int y0, int r, uint8_t opt = 0) {
+    (void)opt;
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+      drawPixel(x0 + x, y0 + y); drawPixel(x0 + y, y0 + x);
+      drawPixel(x0 - y, y0 + x); drawPixel(x0 - x, y0 + y);
+      drawPixel(x0 - x, y0 - y); drawPixel(x0 - y, y0 - x);
+      drawPixel(x0 + y, y0 - x); drawPixel(x0 + x, y0 - y);
+      y++;
+      if (err < 0) err += 2 * y + 1;
+      else { x--; err += 2 * (y - x) + 1; }
+    }
+  }
+  void drawDisc(int x0, int y0, int r, uint8_t opt = 0) {
+    (void)opt;
+    for (int y = -r; y <= r; y++)
+      for (int x = -r; x <= r; x++)
+        if (x * x + y * y <= r * r) drawPixel(x0 + x, y0 + y);
+  }
+  
+  int getStrWidth(const char* s) const { return (int)strlen(s) * font[0]; }
+  int drawStr(int x, int y, const char* s) {
+    // y is the baseline, as in U8g2
+    int w = font[0], h = font[1];
+    for (; *s; s++, x += w) {
+      if (*s != ' ') drawBox(x, y - h + 1, w - 1, h);
+    }
+    return x;
+  }
+  
+  // Simulation side - buffer pushes across all displays
+  static unsigned long& sendCount() { static unsigned long count = 0; return count; }
+  // Virtual time one buffer push takes (software I2C is slow on the device)
+  static unsigned long& pushCostMs() { static unsigned long cost = 0; return cost; }
+  uint8_t getContrast() const { return contrast; }
+};
+
+class U8G2_SH1106_128X64_NONAME_F_SW_I2C : public U8G2 {
+public:
+  U8G2_SH1106_128X64_NONAME_F_SW_I2C(int rotation, int clock, int data, int reset) {
+    (void)rotation; (void)clock; (void)data; (void)reset;
+  }
+};
+
+#endif // SIM_U8G2LIB_H
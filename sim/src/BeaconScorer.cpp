@@ -0,0 +1,126 @@
+#include "BeaconScorer.h"
+#include "MeshPayload.h"
+#include "SimPlatform.h"
+#include <Preferences.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+
+const uint64_t BEACON_BASE = 0xC0FFEE000000ULL;
+const int BEACON_POOL = 6;                     // Walks cycle through these
+const uint64_t BYSTANDER = BEACON_BASE + 0x100;
+const double BYSTANDER_DISTANCE_M = 7.0;       // Behind a wall, never on radar
+const int ADVERTISE_PERMILLE = 500;            // 5 Hz against 10 Hz frames
+const double RSSI_SIGMA_DB = 4.0;
+
+// Default path loss model of the firmware (tx_power, env_factor, dist_corr)
+const double TX_POWER = -59.0;
+const double ENV_FACTOR = 2.7;
+const double CORRECTION = -0.5;
+
+}  // namespace
+
+BeaconScorer::BeaconScorer()
+  : rngState(0xbeac0), walks(0), presentFrames(0), correctFrames(0), wrongFrames(0), payloads(0) {
+  for (int i = 0; i < SLOTS; i++) {
+    reported[i] = 0;
+    carried[i] = 0;
+    present[i] = false;
+    namedThisWalk[i] = false;
+    walkStart[i] = 0;
+  }
+}
+
+void BeaconScorer::provision() {
+  uint8_t macs[(BEACON_POOL + 1) * 6];
+  for (int i = 0; i <= BEACON_POOL; i++) {
+    uint64_t mac = i < BEACON_POOL ? BEACON_BASE + i : BYSTANDER;
+    for (int b = 0; b < 6; b++) {
+      macs[i * 6 + b] = (uint8_t)(mac >> (8 * (5 - b)));
+    }
+  }
+  Preferences prefs;
+  prefs.begin("ble_config", false);
+  prefs.putBytes("mac_list", macs, sizeof(macs));
+  prefs.end();
+}
+
+uint32_t BeaconScorer::next() {
+  rngState = rngState * 1664525u + 1013904223u;
+  return rngState >> 8;
+}
+
+void BeaconScorer::advertise(uint64_t address, double distanceM) {
+  if ((int)(next() % 1000) >= ADVERTISE_PERMILLE) return;
+  
+  // Inverse of the firmware's model, then approximately Gaussian noise
+  double modelM = std::max(distanceM - CORRECTION, 0.1);
+  double rssi = TX_POWER - 10.0 * ENV_FACTOR * log10(modelM);
+  double noise = 0;
+  for (int i = 0; i < 12; i++) {
+    noise += (next() % 10000) / 10000.0;
+  }
+  rssi += (noise - 6.0) * RSSI_SIGMA_DB;
+  Sim::injectBleAdvertisement(address, (int)lround(rssi));
+}
+
+void BeaconScorer::onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs) {
+  advertise(BYSTANDER, BYSTANDER_DISTANCE_M);
+  
+  for (int i = 0; i < SLOTS; i++) {
+    if (truth.present[i] && !present[i]) {
+      carried[i] = BEACON_BASE + (walks++ % BEACON_POOL);
+      walkStart[i] = tMs;
+      namedThisWalk[i] = false;
+    }
+    present[i] = truth.present[i];
+    if (!present[i]) continue;
+    
+    advertise(carried[i], truth.distanceCm[i] / 100.0);
+    presentFrames++;
+    if (reported[i] == carried[i]) {
+      correctFrames++;
+      if (!namedThisWalk[i]) {
+        namedThisWalk[i] = true;
+        nameLatencies.push_back(tMs - walkStart[i]);
+      }
+    } else if (reported[i] != 0) {
+      wrongFrames++;
+    }
+  }
+}
+
+void BeaconScorer::onPayload(const uint8_t* payload, size_t len) {
+  if (len < MESH_PAYLOAD_HEADER_SIZE + 1 || payload[0] != MESH_PAYLOAD_VERSION ||
+      payload[1] != MSG_IDENTITY) {
+    return;
+  }
+  payloads++;
+  
+  int count = payload[2];
+  size_t pos = 3;
+  for (int i = 0; i < count && i < SLOTS && pos + 7 <= len; i++, pos += 7) {
+    uint64_t mac = 0;
+    for (int b = 0; b < 6; b++) {
+      mac = (mac << 8) | payload[pos + 1 + b];
+    }
+    reported[i] = mac;
+  }
+}
+
+void BeaconScorer::printReport() const {
+  std::vector<unsigned long> sorted = nameLatencies;
+  std::sort(sorted.begin(), sorted.end());
+  double pct = presentFrames ? 100.0 / presentFrames : 0.0;
+  
+  printf("--- Beacon Identity ---\n");
+  printf("Walks:             %u (%zu named, %lu identity payloads)\n", walks, sorted.size(), payloads);
+  printf("Target frames:     %.1f%% named correctly, %.1f%% wrongly, %.1f%% anonymous\n",
+         correctFrames * pct, wrongFrames * pct, (presentFrames - correctFrames - wrongFrames) * pct);
+  if (!sorted.empty()) {
+    printf("Time to name:      median %.1f s, p90 %.1f s\n",
+           sorted[sorted.size() / 2] / 1000.0, sorted[sorted.size() * 9 / 10] / 1000.0);
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef BEACON_SCORER_H
+#define BEACON_SCORER_H
+
+// Plays the workers' BLE beacons and scores the firmware's MSG_IDENTITY
+// payloads against them. Every walk carries its own beacon from a small
+// rotating pool, advertising at 5 Hz with an RSSI derived from the true
+// distance plus Gaussian noise; one extra whitelisted beacon stays out of
+// the radar's view the whole time. Each radar frame a present target counts
+// as named correctly, named wrongly or still anonymous.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "TrajectoryGenerator.h"
+
+class BeaconScorer {
+public:
+  BeaconScorer();
+  
+  // Store the beacon whitelist in NVS; call before setup()
+  static void provision();
+  
+  // Advertise the beacons for this frame and score the reported identities
+  void onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs);
+  
+  // Apply a mesh payload delivered from the firmware (MSG_IDENTITY only)
+  void onPayload(const uint8_t* payload, size_t len);
+  
+  void printReport() const;
+
+private:
+  static constexpr int SLOTS = TrajectoryGenerator::MAX_TARGETS;
+  
+  uint32_t rngState;
+  uint64_t reported[SLOTS];       // Latest identity from the firmware
+  uint64_t carried[SLOTS];        // Beacon of the walk in each slot
+  bool present[SLOTS];
+  bool namedThisWalk[SLOTS];
+  unsigned long walkStart[SLOTS];
+  unsigned walks;
+  
+  unsigned long presentFrames;
+  unsigned long correctFrames;
+  unsigned long wrongFrames;
+  unsigned long payloads;
+  std::vector<unsigned long> nameLatencies;
+  
+  uint32_t next();
+  void advertise(uint64_t address, double distanceM);
+};
+
+#endif // BEACON_SCORER_H
@@ -0,0 +1,114 @@
+#include "FragmentPeer.h"
+#include <string.h>
+#include "Crc16.h"
+#include "MeshFragment.h"
+#include "MeshtasticProto.h"
+
+FragmentPeer::FragmentPeer(MeshRadioSim& radio, uint32_t node, uint8_t channel)
+  : radio(radio), node(node), channel(channel), outId(0x4100), outCrc(0), acked(false), lastSendMs(0),
+    inId(0), inReceived(0), dropMask(0), replyDone(false), stats() {
+}
+
+void FragmentPeer::send(const std::string& text, uint8_t withheldMask, unsigned long nowMs) {
+  outMessage.assign(text.begin(), text.end());
+  outId++;
+  outCrc = crc16(outMessage.data(), outMessage.size());
+  acked = false;
+  
+  uint8_t all = (uint8_t)((1u << fragmentCount(outMessage.size())) - 1);
+  stats.fragmentsWithheld += __builtin_popcount(withheldMask & all);
+  sendFragments(all & ~withheldMask);
+  lastSendMs = nowMs;
+}
+
+void FragmentPeer::poll(unsigned long nowMs) {
+  if (outMessage.empty() || acked || nowMs - lastSendMs <= FRAG_REPLY_WAIT_MS) return;
+  sendFragments((uint8_t)(1u << (fragmentCount(outMessage.size()) - 1)));
+  lastSendMs = nowMs;
+}
+
+void FragmentPeer::sendFragments(uint8_t mask) {
+  uint8_t payload[MeshProto::MAX_DATA_PAYLOAD];
+  for (uint8_t i = 0; i < FRAG_MAX_COUNT; i++) {
+    if (!(mask & (1u << i))) continue;
+    size_t len = encodeFragment(payload, sizeof(payload), outId, i, outMessage.data(), outMessage.size(), outCrc);
+    if (len == 0) continue;
+    radio.injectPayload(payload, len, node, channel);
+    stats.fragmentsSent++;
+  }
+}
+
+void FragmentPeer::sendNack(uint16_t id, uint8_t count, uint8_t missing) {
+  uint8_t payload[FRAG_NACK_SIZE];
+  size_t len = encodeFragmentNack(payload, sizeof(payload), id, count, missing);
+  radio.injectPayload(payload, len, node, channel);
+  stats.nacksSent++;
+}
+
+void FragmentPeer::expectReply(uint8_t mask) {
+  dropMask = mask;
+  inReceived = 0;
+  replyDone = false;
+  replyText.clear();
+}
+
+void FragmentPeer::onDelivered(const MeshRadioSim::Delivered& packet, unsigned long nowMs) {
+  if (packet.to != node || packet.port != MeshProto::PORT_PRIVATE) return;
+  const uint8_t* data = packet.payload.data();
+  size_t len = packet.payload.size();
+  
+  // Gateway's answer to our fragments
+  uint16_t id;
+  uint8_t count;
+  uint8_t missing;
+  if (decodeFragmentNack(data, len, id, count, missing)) {
+    if (id != outId || acked) return;
+    if (missing == 0) {
+      acked = true;
+    } else {
+      stats.nacksReceived++;
+      sendFragments(missing);
+      lastSendMs = nowMs;
+    }
+    return;
+  }
+  
+  // Fragment of a reply
+  FragmentHeader header;
+  const uint8_t* slice;
+  size_t sliceLen;
+  if (!decodeFragment(data, len, header, slice, sliceLen)) return;
+  stats.fragmentsReceived++;
+  if (dropMask & (1u << header.index)) {
+    dropMask &= ~(1u << header.index);
+    stats.fragmentsDropped++;
+    return;
+  }
+  
+  uint8_t all = (uint8_t)((1u << header.count) - 1);
+  if (replyDone && header.id == inId) {
+    sendNack(inId, header.count, 0);  // Our ACK was lost
+    return;
+  }
+  if (header.id != inId || inMessage.size() != header.length) {
+    inId = header.id;
+    inMessage.assign(header.length, 0);
+    inReceived = 0;
+    replyDone = false;
+  }
+  memcpy(inMessage.data() + (size_t)header.index * FRAG_DATA_SIZE, slice, sliceLen);
+  inReceived |= (uint8_t)(1u << header.index);
+  
+  if (inReceived == all) {
+    if (crc16(inMessage.data(), inMessage.size()) == header.crc) {
+      replyDone = true;
+      replyText.assign(inMessage.begin(), inMessage.end());
+      sendNack(inId, header.count, 0);
+    } else {
+      inReceived = 0;
+      sendNack(inId, header.count, all);
+    }
+  } else if (header.index == header.count - 1) {
+    sendNack(inId, header.count, all & ~inReceived);
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef FRAGMENT_PEER_H
+#define FRAGMENT_PEER_H
+
+// Far end of the gateway's fragment layer (MeshFragment.h): a mesh node that
+// sends long commands as MSG_FRAGMENT packets and reassembles the gateway's
+// long replies, answering them with MSG_FRAGMENT_NACK the way the firmware
+// does. Chosen fragments can be lost on their first trip in either
+// direction, so the selective re-requests are exercised too; with --loss
+// the radio drops more of them at random.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MeshRadioSim.h"
+
+class FragmentPeer {
+public:
+  struct Stats {
+    unsigned long fragmentsSent;     // To the gateway, including resends
+    unsigned long fragmentsWithheld; // Lost on purpose on their first trip
+    unsigned long nacksReceived;     // Requests for missing fragments
+    unsigned long fragmentsReceived; // From the gateway, including resends
+    unsigned long fragmentsDropped;
+    unsigned long nacksSent;
+  };
+  
+  FragmentPeer(MeshRadioSim& radio, uint32_t node, uint8_t channel);
+  
+  // Send text to the gateway in fragments; the ones in withheldMask are
+  // left out until the gateway asks for them
+  void send(const std::string& text, uint8_t withheldMask, unsigned long nowMs);
+  bool sendAcked() const { return acked; }
+  
+  // Repeat the last fragment when the gateway did not answer in time
+  void poll(unsigned long nowMs);
+  
+  // Fragments of the next reply in dropMask get lost on their first arrival
+  void expectReply(uint8_t dropMask);
+  bool replyComplete() const { return replyDone; }
+  const std::string& reply() const { return replyText; }
+  
+  // Feed every packet the gateway put on the air
+  void onDelivered(const MeshRadioSim::Delivered& packet, unsigned long nowMs);
+  
+  const Stats& getStats() const { return stats; }
+
+private:
+  MeshRadioSim& radio;
+  uint32_t node;
+  uint8_t channel;
+  
+  std::vector<uint8_t> outMessage;
+  uint16_t outId;
+  uint16_t outCrc;
+  bool acked;
+  unsigned long lastSendMs;
+  
+  std::vector<uint8_t> inMessage;
+  uint16_t inId;
+  uint8_t inReceived;
+  uint8_t dropMask;
+  bool replyDone;
+  std::string replyText;
+  
+  Stats stats;
+  
+  void sendFragments(uint8_t mask);
+  void sendNack(uint16_t id, uint8_t count, uint8_t missing);
+};
+
+#endif // FRAGMENT_PEER_H
@@ -0,0 +1,257 @@
+#include "MeshRadioSim.h"
+#include <Arduino.h>
+#include <math.h>
+#include "MeshtasticProto.h"
+
+using namespace MeshProto;
+
+namespace {
+
+// Meshtastic LongFast preset: SF11, 250 kHz, CR 4/5, 16 symbol preamble
+const int LORA_SF = 11;
+const double LORA_BW_HZ = 250000.0;
+const int LORA_CR = 1;
+const int LORA_PREAMBLE = 16;
+const int MESH_HEADER_BYTES = 16;  // On-air mesh header in front of the encrypted Data
+
+const int ROUTING_ERROR_MAX_RETRANSMIT = 5;
+
+}  // namespace
+
+MeshRadioSim::MeshRadioSim()
+  : nodeNum(0x5a6e0001), lossPermille(0), offline(false), queueSize(16), rngState(7), lastNowMs(0) {
+  stats = Stats();
+}
+
+double MeshRadioSim::loraAirtimeMs(size_t packetBytes) {
+  double symbolMs = (double)(1UL << LORA_SF) / LORA_BW_HZ * 1000.0;
+  int lowDataRate = symbolMs > 16.0 ? 1 : 0;
+  double numerator = 8.0 * packetBytes - 4.0 * LORA_SF + 28 + 16;
+  double payloadSymbols = 8 + fmax(ceil(numerator / (4.0 * (LORA_SF - 2 * lowDataRate))) * (LORA_CR + 4), 0);
+  return (LORA_PREAMBLE + 4.25 + payloadSymbols) * symbolMs;
+}
+
+void MeshRadioSim::sendFromRadio(const uint8_t* buf, size_t len) {
+  uint8_t header[FRAME_HEADER_SIZE];
+  writeFrameHeader(header, len);
+  Serial1.injectRx(header, sizeof(header));
+  Serial1.injectRx(buf, len);
+}
+
+void MeshRadioSim::sendQueueStatus(int32_t res, uint32_t packetId) {
+  uint8_t inner[32];
+  Writer qs(inner, sizeof(inner));
+  qs.uint32Field(QueueStatusField::RES, (uint32_t)res);
+  qs.uint32Field(QueueStatusField::FREE, queueSize - (uint32_t)queue.size());
+  qs.uint32Field(QueueStatusField::MAXLEN, queueSize);
+  qs.uint32Field(QueueStatusField::MESH_PACKET_ID, packetId);
+  
+  uint8_t outer[48];
+  Writer fr(outer, sizeof(outer));
+  fr.bytesField(FromRadioField::QUEUE_STATUS, inner, qs.size());
+  sendFromRadio(outer, fr.size());
+}
+
+void MeshRadioSim::sendRouting(uint32_t requestId, int errorReason) {
+  uint8_t routing[8];
+  Writer rt(routing, sizeof(routing));
+  rt.uint32Field(RoutingField::ERROR_REASON, (uint32_t)errorReason);
+  
+  uint8_t data[32];
+  Writer d(data, sizeof(data));
+  d.uint32Field(DataField::PORTNUM, PORT_ROUTING);
+  d.bytesField(DataField::PAYLOAD, routing, rt.size());
+  d.fixed32Field(DataField::REQUEST_ID, requestId);
+  
+  uint8_t packet[64];
+  Writer p(packet, sizeof(packet));
+  p.fixed32Field(MeshPacketField::FROM, nodeNum);
+  p.fixed32Field(MeshPacketField::TO, nodeNum);
+  p.bytesField(MeshPacketField::DECODED, data, d.size());
+  
+  uint8_t outer[80];
+  Writer fr(outer, sizeof(outer));
+  fr.bytesField(FromRadioField::PACKET, packet, p.size());
+  sendFromRadio(outer, fr.size());
+}
+
+void MeshRadioSim::injectText(const char* text, uint32_t fromNode, uint8_t channel) {
+  inject(PORT_TEXT_MESSAGE, (const uint8_t*)text, strlen(text), fromNode, channel);
+}
+
+void MeshRadioSim::injectPayload(const uint8_t* data, size_t len, uint32_t fromNode, uint8_t channel) {
+  inject(PORT_PRIVATE, data, len, fromNode, channel);
+}
+
+void MeshRadioSim::inject(uint16_t port, const uint8_t* payload, size_t len, uint32_t fromNode,
+                          uint8_t channel) {
+  uint8_t data[MAX_DATA_PAYLOAD + 16];
+  Writer d(data, sizeof(data));
+  d.uint32Field(DataField::PORTNUM, port);
+  d.bytesField(DataField::PAYLOAD, payload, len);
+  
+  uint8_t packet[MAX_DATA_PAYLOAD + 48];
+  Writer p(packet, sizeof(packet));
+  p.fixed32Field(MeshPacketField::FROM, fromNode);
+  p.fixed32Field(MeshPacketField::TO, nodeNum);
+  if (channel) p.uint32Field(MeshPacketField::CHANNEL, channel);
+  p.bytesField(MeshPacketField::DECODED, data, d.size());
+  
+  uint8_t outer[MAX_FRAME_PAYLOAD];
+  Writer fr(outer, sizeof(outer));
+  fr.bytesField(FromRadioField::PACKET, packet, p.size());
+  if (fr.ok()) sendFromRadio(outer, fr.size());
+}
+
+void MeshRadioSim::handlePacket(const uint8_t* buf, size_t len, unsigned long nowMs) {
+  OnAir entry = {};
+  
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    const uint8_t* sub;
+    size_t subLen;
+    if (field == MeshPacketField::TO && type == WT_FIXED32) {
+      entry.delivered.to = r.fixed32();
+    } else if (field == MeshPacketField::CHANNEL && type == WT_VARINT) {
+      entry.delivered.channel = (uint8_t)r.varint();
+    } else if (field == MeshPacketField::ID && type == WT_FIXED32) {
+      entry.id = r.fixed32();
+    } else if (field == MeshPacketField::WANT_ACK && type == WT_VARINT) {
+      entry.wantAck = r.varint() != 0;
+    } else if (field == MeshPacketField::DECODED && type == WT_LEN && r.bytes(sub, subLen)) {
+      Reader d(sub, subLen);
+      uint32_t f;
+      WireType t;
+      while (d.next(f, t)) {
+        const uint8_t* payload;
+        size_t payloadLen;
+        if (f == DataField::PORTNUM && t == WT_VARINT) {
+          entry.delivered.port = (uint16_t)d.varint();
+        } else if (f == DataField::PAYLOAD && t == WT_LEN && d.bytes(payload, payloadLen)) {
+          entry.delivered.payload.assign(payload, payload + payloadLen);
+        } else {
+          d.skip(t);
+        }
+      }
+    } else {
+      r.skip(type);
+    }
+  }
+  
+  if (!r.ok()) {
+    stats.frameErrors++;
+    return;
+  }
+  
+  if (queue.size() >= queueSize) {
+    stats.queueRejects++;
+    sendQueueStatus(-1, entry.id);
+    return;
+  }
+  
+  // Packets go on air back to back
+  double airtime = loraAirtimeMs(entry.delivered.payload.size() + MESH_HEADER_BYTES + 4);
+  unsigned long startMs = queue.empty() ? nowMs : queue.back().doneMs;
+  entry.delivered.queuedMs = nowMs;
+  entry.doneMs = startMs + (unsigned long)ceil(airtime);
+  entry.delivered.id = entry.id;
+  
+  stats.packets++;
+  stats.payloadBytes += entry.delivered.payload.size();
+  stats.airtimeMs += airtime;
+  if (entry.delivered.payload.size() > stats.maxPayload) stats.maxPayload = entry.delivered.payload.size();
+  
+  queue.push_back(entry);
+  sendQueueStatus(0, entry.id);
+}
+
+void MeshRadioSim::handleToRadio(const uint8_t* buf, size_t len, unsigned long nowMs) {
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    const uint8_t* sub;
+    size_t subLen;
+    if (field == ToRadioField::PACKET && type == WT_LEN && r.bytes(sub, subLen)) {
+      handlePacket(sub, subLen, nowMs);
+    } else if (field == ToRadioField::WANT_CONFIG_ID && type == WT_VARINT) {
+      uint32_t nonce = (uint32_t)r.varint();
+      stats.handshakes++;
+      
+      uint8_t info[16];
+      Writer mi(info, sizeof(info));
+      mi.uint32Field(MyNodeInfoField::MY_NODE_NUM, nodeNum);
+      uint8_t outer[32];
+      Writer fr(outer, sizeof(outer));
+      fr.bytesField(FromRadioField::MY_INFO, info, mi.size());
+      sendFromRadio(outer, fr.size());
+      
+      Writer done(outer, sizeof(outer));
+      done.uint32Field(FromRadioField::CONFIG_COMPLETE_ID, nonce);
+      sendFromRadio(outer, done.size());
+    } else if (field == ToRadioField::HEARTBEAT) {
+      stats.heartbeats++;
+      r.skip(type);
+    } else {
+      r.skip(type);
+    }
+  }
+  if (!r.ok()) stats.frameErrors++;
+}
+
+void MeshRadioSim::poll(unsigned long nowMs, std::vector<Delivered>& out) {
+  lastNowMs = nowMs;
+  
+  // Parse ToRadio frames written by the gateway
+  int c;
+  while ((c = Serial1.takeTx()) >= 0) {
+    if (offline) {
+      stats.offlineBytes++;
+      continue;
+    }
+    rxBuf.push_back((uint8_t)c);
+  }
+  if (offline) {
+    rxBuf.clear();
+    queue.clear();  // Queued packets die with the node, without a Routing reply
+    return;
+  }
+  
+  size_t pos = 0;
+  while (rxBuf.size() - pos >= FRAME_HEADER_SIZE) {
+    if (rxBuf[pos] != FRAME_START1 || rxBuf[pos + 1] != FRAME_START2) {
+      pos++;
+      stats.frameErrors++;
+      continue;
+    }
+    size_t len = ((size_t)rxBuf[pos + 2] << 8) | rxBuf[pos + 3];
+    if (rxBuf.size() - pos < FRAME_HEADER_SIZE + len) break;
+    handleToRadio(rxBuf.data() + pos + FRAME_HEADER_SIZE, len, nowMs);
+    pos += FRAME_HEADER_SIZE + len;
+  }
+  rxBuf.erase(rxBuf.begin(), rxBuf.begin() + pos);
+  
+  // Finish transmissions whose airtime has elapsed
+  while (!queue.empty() && queue.front().doneMs <= nowMs) {
+    OnAir& entry = queue.front();
+    entry.delivered.tMs = entry.doneMs;
+    
+    rngState = rngState * 1664525u + 1013904223u;
+    bool lost = lossPermille > 0 && (int)((rngState >> 8) % 1000) < lossPermille;
+    
+    if (entry.wantAck) {
+      if (lost) {
+        stats.naks++;
+        sendRouting(entry.id, ROUTING_ERROR_MAX_RETRANSMIT);
+      } else {
+        stats.acks++;
+        sendRouting(entry.id, 0);
+      }
+    }
+    if (!lost) out.push_back(entry.delivered);
+    queue.pop_front();
+    sendQueueStatus(0, 0);
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef MESH_RADIO_SIM_H
+#define MESH_RADIO_SIM_H
+
+// Loopback stand-in for a Meshtastic node on the gateway's UART1.
+//
+// Speaks the serial client API: answers the want_config handshake, reports
+// queue status for every packet, "transmits" packets one at a time using
+// LongFast airtime on the virtual clock and returns Routing ACKs (or NAKs at
+// a configurable loss rate) for want_ack packets. Can also inject commands
+// as incoming text messages and binary payloads from other nodes.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+class MeshRadioSim {
+public:
+  struct Delivered {
+    uint32_t id;
+    uint32_t to;
+    uint8_t channel;
+    uint16_t port;
+    std::vector<uint8_t> payload;
+    unsigned long queuedMs;  // Handed to the radio
+    unsigned long tMs;       // Received at the far end
+  };
+  
+  struct Stats {
+    unsigned long packets;
+    unsigned long payloadBytes;
+    unsigned long acks;
+    unsigned long naks;
+    unsigned long queueRejects;
+    unsigned long handshakes;
+    unsigned long heartbeats;
+    unsigned long frameErrors;
+    unsigned long offlineBytes;
+    size_t maxPayload;
+    double airtimeMs;
+  };
+  
+  MeshRadioSim();
+  
+  void setNodeNum(uint32_t node) { nodeNum = node; }
+  void setLossPermille(int permille) { lossPermille = permille; }
+  void setQueueSize(uint32_t size) { queueSize = size; }
+  
+  // Unplugged node: gateway output is lost and nothing is answered
+  void setOffline(bool unplugged) { offline = unplugged; }
+  
+  // Consume UART1 output and advance on-air packets up to nowMs
+  // Newly delivered packets are appended to out
+  void poll(unsigned long nowMs, std::vector<Delivered>& out);
+  
+  // Deliver a text message to the gateway as if received from the mesh
+  void injectText(const char* text, uint32_t fromNode, uint8_t channel);
+  
+  // Deliver a binary payload on the gateway's private port (fragments)
+  void injectPayload(const uint8_t* data, size_t len, uint32_t fromNode, uint8_t channel);
+  
+  const Stats& getStats() const { return stats; }
+  
+  static double loraAirtimeMs(size_t packetBytes);
+
+private:
+  struct OnAir {
+    uint32_t id;
+    bool wantAck;
+    unsigned long doneMs;
+    Delivered delivered;
+  };
+  
+  uint32_t nodeNum;
+  int lossPermille;
+  bool offline;
+  uint32_t queueSize;
+  uint32_t rngState;
+  std::deque<OnAir> queue;
+  std::vector<uint8_t> rxBuf;
+  unsigned long lastNowMs;
+  Stats stats;
+  
+  void handleToRadio(const uint8_t* buf, size_t len, unsigned long nowMs);
+  void handlePacket(const uint8_t* buf, size_t len, unsigned long nowMs);
+  void sendFromRadio(const uint8_t* buf, size_t len);
+  void sendQueueStatus(int32_t res, uint32_t packetId);
+  void sendRouting(uint32_t requestId, int errorReason);
+  void inject(uint16_t port, const uint8_t* payload, size_t len, uint32_t fromNode, uint8_t channel);
+};
+
+#endif // MESH_RADIO_SIM_H
@@ -0,0 +1,222 @@
+#include "PresenceScorer.h"
+#include "MeshPayload.h"
+#include <stdio.h>
+#include <string.h>
+
+PresenceScorer::PresenceScorer()
+  : summaryMode(false), alertDistanceCm(0), ticks(0), agreeTicks(0), truthEntries(0), truthExits(0),
+    detectedEntries(0), detectedExits(0), falseEntries(0), falseExits(0),
+    entryLatencySumMs(0), exitLatencySumMs(0), maxEntryLatencyMs(0),
+    eventBatches(0), eventsReceived(0), eventAlerts(0), eventGaps(0), eventDuplicates(0), nextEventSeq(1),
+    eventAgeSumMs(0), maxEventAgeMs(0),
+    lastFrameMs(0), truthPersonMs(0), truthMaxSimultaneous(0), truthSafetyEntries(0),
+    alertMessages(0), summaries(0), summaryEntries(0), summaryAlerts(0),
+    summaryPersonDs(0), summaryMaxSimultaneous(0) {
+  for (int i = 0; i < SLOTS; i++) {
+    reported[i] = false;
+    truthPresent[i] = false;
+    truthSince[i] = 0;
+    pendingEntry[i] = false;
+    pendingExit[i] = false;
+    truthInSafety[i] = false;
+  }
+}
+
+void PresenceScorer::setSummaryMode(bool enabled, int alertCm) {
+  summaryMode = enabled;
+  alertDistanceCm = alertCm;
+}
+
+static uint16_t readU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void PresenceScorer::onSummary(const uint8_t* payload, size_t len) {
+  if (len < 18) return;
+  int count = payload[17];
+  if (len < 18 + (size_t)count * 5) return;
+  
+  summaries++;
+  summaryEntries += readU16(payload + 8);
+  summaryAlerts += readU16(payload + 14);
+  if (payload[16] > summaryMaxSimultaneous) summaryMaxSimultaneous = payload[16];
+  for (int i = 0; i < count; i++) {
+    summaryPersonDs += readU16(payload + 18 + i * 5);
+  }
+}
+
+static uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool readVarint(const uint8_t* payload, size_t len, size_t& pos, uint32_t& value) {
+  value = 0;
+  for (int shift = 0; pos < len && shift < 35; shift += 7) {
+    uint8_t b = payload[pos++];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+void PresenceScorer::onEvents(const uint8_t* payload, size_t len, unsigned long tMs) {
+  if (len < 15) return;
+  uint16_t eventBoot = readU16(payload + 2);
+  uint32_t seq = readU32(payload + 4);
+  uint16_t currentBoot = readU16(payload + 8);
+  uint32_t currentUptime = readU32(payload + 10);
+  int count = payload[14];
+  
+  eventBatches++;
+  if (seq > nextEventSeq) eventGaps += seq - nextEventSeq;
+  
+  size_t pos = 15;
+  uint32_t uptime = 0;
+  for (int i = 0; i < count; i++, seq++) {
+    uint32_t time, distance;
+    if (!readVarint(payload, len, pos, time) || pos >= len) return;
+    uint8_t kindTarget = payload[pos++];
+    if (!readVarint(payload, len, pos, distance)) return;
+    uptime = i == 0 ? time : uptime + time;
+    
+    if (seq < nextEventSeq) {
+      eventDuplicates++;
+      continue;
+    }
+    nextEventSeq = seq + 1;
+    eventsReceived++;
+    if (eventBoot == currentBoot) {
+      unsigned long age = currentUptime - uptime;
+      eventAgeSumMs += age;
+      if (age > maxEventAgeMs) maxEventAgeMs = age;
+    }
+    
+    int kind = kindTarget >> 2;
+    int slot = kindTarget & 0x03;
+    if (kind == 2) {
+      eventAlerts++;
+    } else if (slot < SLOTS) {
+      applyReport(slot, kind == 1, tMs);
+    }
+  }
+}
+
+void PresenceScorer::applyReport(int slot, bool present, unsigned long tMs) {
+  if (present == reported[slot]) return;
+  reported[slot] = present;
+  
+  if (present) {
+    if (pendingEntry[slot]) {
+      unsigned long latency = tMs - truthSince[slot];
+      detectedEntries++;
+      entryLatencySumMs += latency;
+      if (latency > maxEntryLatencyMs) maxEntryLatencyMs = latency;
+      pendingEntry[slot] = false;
+    } else {
+      falseEntries++;
+    }
+  } else {
+    if (pendingExit[slot]) {
+      detectedExits++;
+      exitLatencySumMs += tMs - truthSince[slot];
+      pendingExit[slot] = false;
+    } else {
+      falseExits++;
+    }
+  }
+}
+
+void PresenceScorer::onPayload(const uint8_t* payload, size_t len, unsigned long tMs) {
+  if (len < MESH_PAYLOAD_HEADER_SIZE + 2 || payload[0] != MESH_PAYLOAD_VERSION) {
+    return;
+  }
+  
+  if (payload[1] == MSG_SUMMARY) {
+    onSummary(payload, len);
+    return;
+  }
+  if (payload[1] == MSG_EVENTS) {
+    onEvents(payload, len, tMs);
+    return;
+  }
+  if (payload[1] != MSG_PRESENCE) {
+    return;
+  }
+  if (summaryMode) {
+    alertMessages++;
+    return;
+  }
+  
+  uint8_t presentMask = payload[2];
+  int count = payload[3] < SLOTS ? payload[3] : SLOTS;
+  for (int i = 0; i < count; i++) {
+    applyReport(i, (presentMask >> i) & 1, tMs);
+  }
+}
+
+void PresenceScorer::onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs) {
+  unsigned long dt = tMs - lastFrameMs;
+  lastFrameMs = tMs;
+  int simultaneous = 0;
+  
+  for (int i = 0; i < SLOTS; i++) {
+    if (truth.present[i]) {
+      simultaneous++;
+      truthPersonMs += dt;
+    }
+    
+    bool inSafety = truth.present[i] && alertDistanceCm > 0 && truth.distanceCm[i] <= alertDistanceCm;
+    if (inSafety && !truthInSafety[i]) truthSafetyEntries++;
+    truthInSafety[i] = inSafety;
+    
+    if (truth.present[i] != truthPresent[i]) {
+      truthPresent[i] = truth.present[i];
+      truthSince[i] = tMs;
+      if (truthPresent[i]) {
+        truthEntries++;
+        pendingEntry[i] = !reported[i];
+        pendingExit[i] = false;
+      } else {
+        truthExits++;
+        pendingExit[i] = reported[i];
+        pendingEntry[i] = false;
+      }
+    }
+    
+    ticks++;
+    if (reported[i] == truthPresent[i]) agreeTicks++;
+  }
+  
+  if (simultaneous > truthMaxSimultaneous) truthMaxSimultaneous = simultaneous;
+}
+
+void PresenceScorer::printReport() const {
+  if (summaryMode) {
+    printf("--- Occupancy Summaries vs Ground Truth ---\n");
+    printf("Summaries:         %lu\n", summaries);
+    printf("Entries:           %lu true, %lu reported\n", truthEntries, summaryEntries);
+    printf("Occupied:          %.0f person-s true, %.0f reported\n",
+           truthPersonMs / 1000.0, summaryPersonDs / 10.0);
+    printf("Max simultaneous:  %d true, %d reported\n", truthMaxSimultaneous, summaryMaxSimultaneous);
+    printf("Safety entries:    %lu true (<= %d cm), %lu counted, %lu alerts sent\n",
+           truthSafetyEntries, alertDistanceCm, summaryAlerts, alertMessages);
+    return;
+  }
+  
+  printf("--- Ground Truth Match ---\n");
+  printf("Slot agreement:    %.2f%% of slot-frames\n", ticks ? 100.0 * agreeTicks / ticks : 0.0);
+  printf("Entries:           %lu true, %lu detected, %lu spurious\n",
+         truthEntries, detectedEntries, falseEntries);
+  printf("Exits:             %lu true, %lu detected, %lu spurious\n",
+         truthExits, detectedExits, falseExits);
+  printf("Entry latency:     avg %.0f ms, max %lu ms\n",
+         detectedEntries ? (double)entryLatencySumMs / detectedEntries : 0.0, maxEntryLatencyMs);
+  printf("Exit latency:      avg %.0f ms\n",
+         detectedExits ? (double)exitLatencySumMs / detectedExits : 0.0);
+  if (eventBatches > 0) {
+    printf("Journal:           %lu events (%lu alerts) in %lu batches, %lu missing, %lu duplicates\n",
+           eventsReceived, eventAlerts, eventBatches, eventGaps, eventDuplicates);
+    printf("Event age:         avg %.0f ms, max %lu ms at delivery\n",
+           eventsReceived ? (double)eventAgeSumMs / eventsReceived : 0.0, maxEventAgeMs);
+  }
+}
@@ -0,0 +1,79 @@
+#ifndef PRESENCE_SCORER_H
+#define PRESENCE_SCORER_H
+
+// Scores the firmware's reported presence (from its mesh payloads) against
+// the generator's ground truth, one radar frame at a time. Journaled events
+// (MSG_EVENTS) are applied when their batch arrives and also checked for
+// sequence gaps and duplicates. In summary mode the occupancy summaries are
+// compared against the truth totals instead.
+
+#include "TrajectoryGenerator.h"
+
+class PresenceScorer {
+public:
+  PresenceScorer();
+  
+  // Score MSG_SUMMARY totals instead of per-event presence
+  void setSummaryMode(bool enabled, int alertDistanceCm);
+  
+  // Apply a mesh payload delivered from the firmware
+  void onPayload(const uint8_t* payload, size_t len, unsigned long tMs);
+  
+  // Account one frame of ground truth
+  void onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs);
+  
+  void printReport() const;
+
+private:
+  static constexpr int SLOTS = TrajectoryGenerator::MAX_TARGETS;
+  
+  bool summaryMode;
+  int alertDistanceCm;
+  
+  bool reported[SLOTS];
+  bool truthPresent[SLOTS];
+  unsigned long truthSince[SLOTS];
+  bool pendingEntry[SLOTS];
+  bool pendingExit[SLOTS];
+  
+  unsigned long ticks;
+  unsigned long agreeTicks;
+  unsigned long truthEntries;
+  unsigned long truthExits;
+  unsigned long detectedEntries;
+  unsigned long detectedExits;
+  unsigned long falseEntries;
+  unsigned long falseExits;
+  unsigned long long entryLatencySumMs;
+  unsigned long long exitLatencySumMs;
+  unsigned long maxEntryLatencyMs;
+  
+  // Event journal batches
+  unsigned long eventBatches;
+  unsigned long eventsReceived;
+  unsigned long eventAlerts;
+  unsigned long eventGaps;
+  unsigned long eventDuplicates;
+  uint32_t nextEventSeq;
+  unsigned long long eventAgeSumMs;
+  unsigned long maxEventAgeMs;
+  
+  // Summary mode
+  bool truthInSafety[SLOTS];
+  unsigned long lastFrameMs;
+  unsigned long long truthPersonMs;
+  int truthMaxSimultaneous;
+  unsigned long truthSafetyEntries;
+  unsigned long alertMessages;
+  unsigned long summaries;
+  unsigned long summaryEntries;
+  unsigned long summaryAlerts;
+  unsigned long long summaryPersonDs;
+  int summaryMaxSimultaneous;
+  
+  void onSummary(const uint8_t* payload, size_t len);
+  void onEvents(const uint8_t* payload, size_t len, unsigned long tMs);
+  void applyReport(int slot, bool present, unsigned long tMs);
+};
+
+#endif // PRESENCE_SCORER_H
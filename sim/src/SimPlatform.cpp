@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <U8g2lib.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <new>
+#include "SimPlatform.h"
+#include "Hal.h"
+
+//========================= Virtual clock =========================
+static unsigned long virtualMs = 0;
+
+unsigned long Sim::nowMs() {
+  return virtualMs;
+}
+
+void Sim::advanceMs(unsigned long ms) {
+  virtualMs += ms;
+}
+
+unsigned long millis() {
+  return virtualMs;
+}
+
+unsigned long micros() {
+  return virtualMs * 1000UL;
+}
+
+void delay(unsigned long ms) {
+  virtualMs += ms;
+}
+
+void yield() {}
+
+//========================= Hal (native) =========================
+HardwareSerial Serial(false, false);  // USB log - discarded unless echo enabled
+HardwareSerial Serial1;               // Meshtastic
+HardwareSerial Serial2;               // LD2450
+
+unsigned long Hal::millis() {
+  return ::millis();
+}
+
+unsigned long Hal::micros() {
+  return ::micros();
+}
+
+void Hal::delay(unsigned long ms) {
+  ::delay(ms);
+}
+
+HardwareSerial& Hal::radarUart() {
+  return Serial2;
+}
+
+HardwareSerial& Hal::meshUart() {
+  return Serial1;
+}
+
+// No radio in the simulation; the driver can inject advertisements
+static Hal::BleAdvertisementHandler bleHandler = nullptr;
+
+bool Hal::startBleScan(BleAdvertisementHandler handler, uint16_t intervalMs, uint16_t windowMs, bool active) {
+  (void)intervalMs; (void)windowMs; (void)active;
+  bleHandler = handler;
+  return true;
+}
+
+void Sim::injectBleAdvertisement(uint64_t address, int rssi) {
+  if (bleHandler) bleHandler(address, rssi);
+}
+
+//========================= In-memory flash files =========================
+static std::map<std::string, std::vector<uint8_t>>& flashFiles() {
+  static std::map<std::string, std::vector<uint8_t>> files;
+  return files;
+}
+
+bool Hal::fsBegin() {
+  return true;
+}
+
+size_t Hal::fsFileSize(const char* path) {
+  auto it = flashFiles().find(path);
+  return it != flashFiles().end() ? it->second.size() : 0;
+}
+
+bool Hal::fsAppend(const char* path, const uint8_t* data, size_t len) {
+  std::vector<uint8_t>& file = flashFiles()[path];
+  file.insert(file.end(), data, data + len);
+  return true;
+}
+
+size_t Hal::fsRead(const char* path, size_t offset, uint8_t* out, size_t len) {
+  auto it = flashFiles().find(path);
+  if (it == flashFiles().end() || offset >= it->second.size()) return 0;
+  size_t n = std::min(len, it->second.size() - offset);
+  memcpy(out, it->second.data() + offset, n);
+  return n;
+}
+
+bool Hal::fsRemove(const char* path) {
+  flashFiles().erase(path);
+  return true;
+}
+
+size_t Sim::flashUsedBytes() {
+  size_t total = 0;
+  for (const auto& file : flashFiles()) {
+    total += file.second.size();
+  }
+  return total;
+}
+
+//========================= In-memory NVS =========================
+std::map<std::string, Preferences::Namespace>& Preferences::storage() {
+  static std::map<std::string, Namespace> nvs;
+  return nvs;
+}
+
+//========================= Fonts =========================
+const uint8_t u8g2_font_t0_22_tr[] = {11, 16};
+const uint8_t u8g2_font_t0_17_tr[] = {9, 12};
+const uint8_t u8g2_font_t0_12_tr[] = {6, 9};
+const uint8_t u8g2_font_6x10_tr[] = {6, 7};
+const uint8_t u8g2_font_5x7_tr[] = {5, 6};
+const uint8_t u8g2_font_tom_thumb_4x6_tr[] = {4, 5};
+
+//========================= Heap tracking =========================
+// Every allocation carries a small header with its size so the driver can
+// report current and peak heap use over a long run.
+static size_t heapCurrent = 0;
+static size_t heapPeak = 0;
+static unsigned long heapAllocations = 0;
+
+static const size_t HEAP_HEADER = alignof(std::max_align_t);
+
+static void* trackedAlloc(size_t size) {
+  uint8_t* block = (uint8_t*)malloc(size + HEAP_HEADER);
+  if (!block) throw std::bad_alloc();
+  memcpy(block, &size, sizeof(size));
+  heapCurrent += size;
+  heapAllocations++;
+  if (heapCurrent > heapPeak) heapPeak = heapCurrent;
+  return block + HEAP_HEADER;
+}
+
+static void trackedFree(void* ptr) {
+  if (!ptr) return;
+  uint8_t* block = (uint8_t*)ptr - HEAP_HEADER;
+  size_t size;
+  memcpy(&size, block, sizeof(size));
+  heapCurrent -= size;
+  free(block);
+}
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+
+Sim::HeapStats Sim::heapStats() {
+  HeapStats stats = {heapCurrent, heapPeak, heapAllocations};
+  return stats;
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getHeapSize() {
+  return Sim::SIM_HEAP_SIZE;
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return Sim::SIM_HEAP_SIZE - (uint32_t)heapCurrent;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  return Sim::SIM_HEAP_SIZE - (uint32_t)heapPeak;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  // No fragmentation model - the whole free heap is one block
+  return getFreeHeap();
+}
@@ -0,0 +1,129 @@
+#include "TrackScorer.h"
+#include "MeshPayload.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+
+bool readVarint(const uint8_t* buf, size_t len, size_t& pos, uint32_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 35 && pos < len; shift += 7) {
+    uint8_t b = buf[pos++];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+int32_t unZigZag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+}  // namespace
+
+TrackScorer::TrackScorer()
+  : payloads(0), payloadBytes(0), tracksStarted(0), tracksEnded(0), decodeErrors(0) {}
+
+void TrackScorer::onPayload(const uint8_t* payload, size_t len, unsigned long tMs) {
+  if (len < MESH_PAYLOAD_HEADER_SIZE + 1 || payload[0] != MESH_PAYLOAD_VERSION ||
+      payload[1] != MSG_TRACK) {
+    return;
+  }
+  payloads++;
+  payloadBytes += len;
+  
+  size_t pos = 2;
+  int sections = payload[pos++];
+  for (int s = 0; s < sections; s++) {
+    if (pos + 2 > len) {
+      decodeErrors++;
+      return;
+    }
+    uint8_t header = payload[pos++];
+    int count = payload[pos++];
+    int slot = header & 0x03;
+    if (slot >= SLOTS) {
+      decodeErrors++;
+      return;
+    }
+    if (header & 0x04) tracksStarted++;
+    if (header & 0x08) tracksEnded++;
+    
+    long ds = 0;
+    int x = 0;
+    int y = 0;
+    for (int p = 0; p < count; p++) {
+      uint32_t t, dx, dy;
+      if (!readVarint(payload, len, pos, t) || !readVarint(payload, len, pos, dx) ||
+          !readVarint(payload, len, pos, dy)) {
+        decodeErrors++;
+        return;
+      }
+      if (p == 0) {
+        ds = (long)(tMs / 100) - (long)t;
+        x = unZigZag(dx);
+        y = unZigZag(dy);
+      } else {
+        ds += t;
+        x += unZigZag(dx);
+        y += unZigZag(dy);
+      }
+      bool end = (header & 0x08) && p == count - 1;
+      keyPoints[slot].push_back({ds * 100, x, y, end});
+    }
+  }
+}
+
+void TrackScorer::onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs) {
+  for (int i = 0; i < SLOTS; i++) {
+    if (truth.present[i]) {
+      truthPoints[i].push_back({(long)tMs, truth.xCm[i], truth.yCm[i], false});
+    }
+  }
+}
+
+void TrackScorer::printReport(double simSeconds) const {
+  std::vector<double> errors;
+  unsigned long truthSamples = 0;
+  unsigned long points = 0;
+  
+  for (int i = 0; i < SLOTS; i++) {
+    const std::vector<Point>& keys = keyPoints[i];
+    points += keys.size();
+    for (const Point& truth : truthPoints[i]) {
+      truthSamples++;
+      
+      // Key point segment around this time, within one track
+      std::vector<Point>::const_iterator next = std::upper_bound(
+          keys.begin(), keys.end(), truth.tMs,
+          [](long t, const Point& p) { return t < p.tMs; });
+      if (next == keys.begin() || next == keys.end()) continue;
+      const Point& a = *(next - 1);
+      const Point& b = *next;
+      if (a.end) continue;
+      
+      double f = b.tMs > a.tMs ? (double)(truth.tMs - a.tMs) / (b.tMs - a.tMs) : 0.0;
+      double x = a.x + (b.x - a.x) * f;
+      double y = a.y + (b.y - a.y) * f;
+      errors.push_back(hypot(x - truth.x, y - truth.y));
+    }
+  }
+  
+  std::sort(errors.begin(), errors.end());
+  double sum = 0;
+  for (double e : errors) sum += e;
+  
+  printf("--- Trajectories vs Ground Truth ---\n");
+  printf("Track payloads:    %lu (%lu bytes, %.1f B/min)\n", payloads, payloadBytes,
+         simSeconds > 0 ? payloadBytes * 60.0 / simSeconds : 0.0);
+  printf("Key points:        %lu for %lu true samples (%lu tracks started, %lu ended)\n",
+         points, truthSamples, tracksStarted, tracksEnded);
+  printf("Path coverage:     %.1f%% of true samples between key points\n",
+         truthSamples ? 100.0 * errors.size() / truthSamples : 0.0);
+  if (!errors.empty()) {
+    printf("Path error:        avg %.0f cm, p95 %.0f cm, max %.0f cm\n", sum / errors.size(),
+           errors[errors.size() * 95 / 100], errors.back());
+  }
+  if (decodeErrors) printf("Decode errors:     %lu\n", decodeErrors);
+}
@@ -0,0 +1,44 @@
+#ifndef TRACK_SCORER_H
+#define TRACK_SCORER_H
+
+// Rebuilds the walking paths from the firmware's MSG_TRACK payloads and
+// measures how far the key point polyline strays from the true positions.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "TrajectoryGenerator.h"
+
+class TrackScorer {
+public:
+  TrackScorer();
+  
+  // Apply a mesh payload from the firmware (MSG_TRACK only); tMs is when it
+  // was handed to the radio, which point ages are relative to
+  void onPayload(const uint8_t* payload, size_t len, unsigned long tMs);
+  
+  // Account one frame of ground truth
+  void onFrame(const TrajectoryGenerator::Truth& truth, unsigned long tMs);
+  
+  void printReport(double simSeconds) const;
+
+private:
+  static constexpr int SLOTS = TrajectoryGenerator::MAX_TARGETS;
+  
+  struct Point {
+    long tMs;
+    int x;
+    int y;
+    bool end;  // Last point of its track - no interpolation past it
+  };
+  
+  std::vector<Point> keyPoints[SLOTS];
+  std::vector<Point> truthPoints[SLOTS];
+  unsigned long payloads;
+  unsigned long payloadBytes;
+  unsigned long tracksStarted;
+  unsigned long tracksEnded;
+  unsigned long decodeErrors;
+};
+
+#endif // TRACK_SCORER_H
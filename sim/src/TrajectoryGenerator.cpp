@@ -0,0 +1,211 @@
+#include "TrajectoryGenerator.h"
+#include <math.h>
+#include <string.h>
+
+TrajectoryGenerator::TrajectoryGenerator() : rngState(1) {
+  clear();
+}
+
+void TrajectoryGenerator::clear() {
+  actors.clear();
+  noise.jitterMm = 30;
+  noise.dropoutPermille = 0;
+  noise.ghostPermille = 0;
+}
+
+void TrajectoryGenerator::addActor(const Actor& actor) {
+  if (actor.slot < 0 || actor.slot >= MAX_TARGETS || actor.path.empty()) return;
+  actors.push_back(actor);
+}
+
+void TrajectoryGenerator::setNoise(const Noise& n) {
+  noise = n;
+}
+
+void TrajectoryGenerator::setSeed(uint32_t seed) {
+  rngState = seed ? seed : 1;
+}
+
+uint32_t TrajectoryGenerator::nextRandom() {
+  rngState = rngState * 1664525u + 1013904223u;
+  return rngState >> 8;
+}
+
+int TrajectoryGenerator::randomRange(int lo, int hi) {
+  return lo + (int)(nextRandom() % (uint32_t)(hi - lo + 1));
+}
+
+bool TrajectoryGenerator::positionAt(const Actor& actor, unsigned long tMs, int& xMm, int& yMm) {
+  const std::vector<Waypoint>& path = actor.path;
+  if (tMs < path.front().tMs || tMs > path.back().tMs) return false;
+  
+  for (size_t i = 1; i < path.size(); i++) {
+    if (tMs <= path[i].tMs) {
+      const Waypoint& a = path[i - 1];
+      const Waypoint& b = path[i];
+      unsigned long span = b.tMs - a.tMs;
+      double f = span ? (double)(tMs - a.tMs) / span : 1.0;
+      xMm = (int)lround(a.xMm + (b.xMm - a.xMm) * f);
+      yMm = (int)lround(a.yMm + (b.yMm - a.yMm) * f);
+      return true;
+    }
+  }
+  xMm = path.back().xMm;
+  yMm = path.back().yMm;
+  return true;
+}
+
+void TrajectoryGenerator::buildFrame(unsigned long tMs, uint8_t* out, Truth& truth) {
+  LD2450Proto::Frame frame;
+  memset(&frame, 0, sizeof(frame));
+  
+  memset(&truth, 0, sizeof(truth));
+  truth.dropout = noise.dropoutPermille > 0 && randomRange(1, 1000) <= noise.dropoutPermille;
+  
+  for (const Actor& actor : actors) {
+    int x, y;
+    if (!positionAt(actor, tMs, x, y)) continue;
+    
+    double distMm = sqrt((double)x * x + (double)y * y);
+    if (y <= 0 || distMm > SENSOR_RANGE_MM) continue;  // Outside the radar field
+    if (truth.present[actor.slot]) continue;            // Slot already taken
+    
+    truth.present[actor.slot] = true;
+    truth.distanceCm[actor.slot] = (int)(distMm / 10.0);
+    truth.xCm[actor.slot] = x / 10;
+    truth.yCm[actor.slot] = y / 10;
+    if (truth.dropout) continue;
+    
+    // Radial speed from the position one frame earlier, positive = approaching
+    int px, py;
+    int speedCmS = 0;
+    if (tMs >= FRAME_INTERVAL_MS && positionAt(actor, tMs - FRAME_INTERVAL_MS, px, py)) {
+      double prevMm = sqrt((double)px * px + (double)py * py);
+      speedCmS = (int)lround((prevMm - distMm) / 10.0 * (1000.0 / FRAME_INTERVAL_MS));
+    }
+    
+    LD2450Proto::Target& t = frame.targets[actor.slot];
+    t.x = (int16_t)(x + randomRange(-noise.jitterMm, noise.jitterMm));
+    t.y = (int16_t)(y + randomRange(-noise.jitterMm, noise.jitterMm));
+    t.speed = (int16_t)speedCmS;
+    t.resolution = 360;  // Any non-zero value marks the slot valid
+  }
+  
+  if (truth.dropout || noise.ghostPermille == 0) {
+    LD2450Proto::encodeFrame(frame, out);
+    return;
+  }
+  
+  for (int slot = 0; slot < MAX_TARGETS; slot++) {
+    if (truth.present[slot] || randomRange(1, 1000) > noise.ghostPermille) continue;
+    LD2450Proto::Target& t = frame.targets[slot];
+    t.x = (int16_t)randomRange(-3000, 3000);
+    t.y = (int16_t)randomRange(300, 5500);
+    t.speed = (int16_t)randomRange(-50, 50);
+    t.resolution = 360;
+    truth.ghosts++;
+  }
+  LD2450Proto::encodeFrame(frame, out);
+}
+
+// Walk through the given points at a constant speed, starting at startMs
+void TrajectoryGenerator::addWalk(int slot, unsigned long startMs, int speedMmS,
+                                  const std::vector<Waypoint>& points) {
+  Actor actor;
+  actor.slot = slot;
+  unsigned long t = startMs;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (i > 0) {
+      double dx = points[i].xMm - points[i - 1].xMm;
+      double dy = points[i].yMm - points[i - 1].yMm;
+      t += (unsigned long)(sqrt(dx * dx + dy * dy) * 1000.0 / speedMmS);
+    }
+    // A waypoint's own tMs is a dwell time at that point
+    Waypoint w = {t, points[i].xMm, points[i].yMm};
+    actor.path.push_back(w);
+    if (points[i].tMs > 0) {
+      t += points[i].tMs;
+      w.tMs = t;
+      actor.path.push_back(w);
+    }
+  }
+  addActor(actor);
+}
+
+// Working-hours occupancy: visits cluster 08:00-12:00 and 13:00-17:00
+void TrajectoryGenerator::buildSiteDay(unsigned long durationMs) {
+  unsigned long slotFreeAt[MAX_TARGETS] = {0, 0, 0};
+  
+  for (unsigned long t = 0; t < durationMs; t += 60000UL) {
+    int hour = (int)((t / 3600000UL) % 24);
+    bool busy = (hour >= 8 && hour < 12) || (hour >= 13 && hour < 17);
+    if (randomRange(1, 100) > (busy ? 30 : 1)) continue;
+    
+    for (int slot = 0; slot < MAX_TARGETS; slot++) {
+      if (slotFreeAt[slot] > t) continue;
+      unsigned long start = t + (unsigned long)randomRange(0, 59) * 1000UL;
+      unsigned long dwell = (unsigned long)randomRange(20, 600) * 1000UL;
+      int x = randomRange(-1500, 1500);
+      int y = randomRange(500, 4000);
+      addWalk(slot, start, 1000, {
+        {0, x < 0 ? -5000 : 5000, 5500},
+        {dwell, x, y},
+        {0, x < 0 ? 5000 : -5000, 5500},
+      });
+      slotFreeAt[slot] = actors.back().path.back().tMs + 5000UL;
+      break;
+    }
+  }
+}
+
+const char* TrajectoryGenerator::scenarioNames() {
+  return "walk, stand, cross, leave, noise, siteday";
+}
+
+bool TrajectoryGenerator::loadScenario(const std::string& name, unsigned long durationMs) {
+  clear();
+  
+  if (name == "walk") {
+    // One person walking a loop through the field every two minutes
+    for (unsigned long t = 10000; t < durationMs; t += 120000UL) {
+      addWalk(0, t, 1200, {
+        {0, -4000, 4000}, {0, -1000, 1200}, {0, 1000, 1200}, {0, 4000, 4000},
+      });
+    }
+  } else if (name == "stand") {
+    // Walk in, stand still near the machine for five minutes, walk out
+    for (unsigned long t = 10000; t < durationMs; t += 420000UL) {
+      addWalk(0, t, 1000, {
+        {0, 0, 5800}, {300000UL, 200, 900}, {0, 0, 5800},
+      });
+    }
+  } else if (name == "cross") {
+    // Two people crossing each other's path in front of the sensor
+    for (unsigned long t = 10000; t < durationMs; t += 90000UL) {
+      addWalk(0, t, 1000, {{0, -3000, 2000}, {0, 3000, 2000}});
+      addWalk(1, t, 1000, {{0, 3000, 2200}, {0, -3000, 1800}});
+    }
+  } else if (name == "leave") {
+    // Walk out of the radar range and come back
+    for (unsigned long t = 10000; t < durationMs; t += 180000UL) {
+      addWalk(0, t, 1000, {
+        {0, 0, 1500}, {20000UL, 0, 7500}, {30000UL, 0, 1500},
+      });
+    }
+  } else if (name == "noise") {
+    // Sparse real visits under heavy dropouts and ghost targets
+    for (unsigned long t = 30000; t < durationMs; t += 300000UL) {
+      addWalk(0, t, 800, {{0, -2000, 5000}, {60000UL, 0, 1500}, {0, 2000, 5000}});
+    }
+    Noise n = {80, 20, 5};
+    setNoise(n);
+  } else if (name == "siteday") {
+    buildSiteDay(durationMs);
+    Noise n = {30, 5, 0};
+    setNoise(n);
+  } else {
+    return false;
+  }
+  
+  return true;
+}
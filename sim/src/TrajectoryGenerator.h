@@ -0,0 +1,81 @@
+#ifndef TRAJECTORY_GENERATOR_H
+#define TRAJECTORY_GENERATOR_H
+
+// Synthetic LD2450 frame generator for the native simulation.
+//
+// Scenarios are scripted as actors moving along timed waypoints in the radar
+// plane (x = lateral mm, y = forward mm). Each frame is encoded exactly as the
+// sensor sends it, using the same codec as the firmware (LD2450Proto.h),
+// and the generator reports
+// the per-slot ground truth alongside so output events can be scored.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "LD2450Proto.h"
+
+class TrajectoryGenerator {
+public:
+  static constexpr int FRAME_SIZE = (int)LD2450Proto::FRAME_SIZE;
+  static constexpr int MAX_TARGETS = (int)LD2450Proto::MAX_TARGETS;
+  static constexpr unsigned long FRAME_INTERVAL_MS = 100;  // 10 Hz
+  static constexpr int SENSOR_RANGE_MM = 6000;
+  
+  struct Waypoint {
+    unsigned long tMs;
+    int xMm;
+    int yMm;
+  };
+  
+  struct Actor {
+    int slot;                        // Radar target slot the actor occupies
+    std::vector<Waypoint> path;      // Sorted by time; actor exists between first and last
+  };
+  
+  struct Noise {
+    int jitterMm;                    // Uniform position jitter per frame
+    int dropoutPermille;             // Chance a frame reports no targets at all
+    int ghostPermille;               // Chance a free slot shows a spurious target
+  };
+  
+  // Ground truth for one frame
+  struct Truth {
+    bool present[MAX_TARGETS];       // A real person is visible in this slot
+    int distanceCm[MAX_TARGETS];
+    int xCm[MAX_TARGETS];
+    int yCm[MAX_TARGETS];
+    bool dropout;
+    int ghosts;
+  };
+  
+  TrajectoryGenerator();
+  
+  void clear();
+  void addActor(const Actor& actor);
+  void setNoise(const Noise& noise);
+  void setSeed(uint32_t seed);
+  
+  // Build one of the named scenarios; returns false for an unknown name
+  bool loadScenario(const std::string& name, unsigned long durationMs);
+  static const char* scenarioNames();
+  
+  // Encode the frame at virtual time tMs into out[FRAME_SIZE]
+  void buildFrame(unsigned long tMs, uint8_t* out, Truth& truth);
+
+
+private:
+  std::vector<Actor> actors;
+  Noise noise;
+  uint32_t rngState;
+  
+  uint32_t nextRandom();
+  int randomRange(int lo, int hi);
+  
+  static bool positionAt(const Actor& actor, unsigned long tMs, int& xMm, int& yMm);
+  
+  void addWalk(int slot, unsigned long startMs, int speedMmS,
+               const std::vector<Waypoint>& points);
+  void buildSiteDay(unsigned long durationMs);
+};
+
+#endif // TRAJECTORY_GENERATOR_H
@@ -0,0 +1,470 @@
+// Native soak-test driver: runs the unmodified firmware setup()/loop()
+// against the simulation platform on a virtual clock, feeds it synthetic
+// LD2450 frames and reports event counts, estimated mesh airtime, heap use
+// and how well the reported presence matches the scenario's ground truth.
+// UART1 is wired to a loopback Meshtastic node (MeshRadioSim) speaking the
+// serial client API, so the scorer sees exactly what reaches the mesh.
+//
+//   sim [--scenario NAME] [--hours N] [--seed N] [--loss PERMILLE] [--events] [--heatmap]
+//       [--track BYTES_PER_MIN] [--predict] [--beacons] [--outage MINUTES] [--display-cost MS]
+//       [--telemetry PATH] [--bulk] [--unthrottled] [--verbose]
+//   sim --emit PATH [--scenario NAME] [--hours N] [--realtime]
+//
+// --unthrottled pushes radar frames as fast as loop() can take them to
+// stress readSensor(); --emit writes the raw frame stream to a file or
+// serial device instead of running the firmware (at 10 Hz wall-clock with
+// --realtime, e.g. into a USB-UART wired to a real gateway's radar input).
+// --loss makes the loopback radio NAK that share of want_ack packets.
+// --events switches the firmware from occupancy summaries to per-event
+// presence reports, which are scored for entry/exit latency. --heatmap
+// requests the occupancy heatmap over the mesh at the end of the run (its
+// first fragment is lost once), checks the reassembled grid against the
+// firmware's and prints it. --track turns
+// on trajectory streaming with the given budget and scores the rebuilt paths.
+// --predict enables approach prediction (early entry and safety alerts).
+// --beacons gives every walker a whitelisted BLE beacon and scores the
+// identities the firmware attaches to its radar targets.
+// --outage unplugs the mesh node for that many minutes, starting a third
+// into the run; with --events the journal has to catch up afterwards.
+// --telemetry turns on the binary USB telemetry and writes the USB serial
+// output to a file (decode it with tools/telemetry_csv).
+// --bulk replaces the whitelist with one fragmented command at the end of
+// the run and reads the configuration back, losing one fragment each way.
+// --display-cost makes every display push take that much virtual time, to
+// exercise the loop-latency supervisor.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <U8g2lib.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "SimPlatform.h"
+#include "TrajectoryGenerator.h"
+#include "PresenceScorer.h"
+#include "TrackScorer.h"
+#include "BeaconScorer.h"
+#include "FragmentPeer.h"
+#include "MeshRadioSim.h"
+#include "MeshtasticComm.h"
+#include "ConfigManager.h"
+#include "LD2450Manager.h"
+#include "OccupancyHeatmap.h"
+#include "LoadSupervisor.h"
+#include "TelemetryStream.h"
+#include "MeshPayload.h"
+
+// Unit tests (pio test -e native) link the sim platform and bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+namespace {
+
+const int UNTHROTTLED_FRAMES_PER_LOOP = 64;
+
+struct RunStats {
+  unsigned long framesInjected;
+  unsigned long droppedFrames;
+  unsigned long ghostTargets;
+};
+
+int emitFrames(TrajectoryGenerator& generator, const char* path, unsigned long durationMs, bool realtime) {
+  FILE* out = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+  if (!out) {
+    perror(path);
+    return 1;
+  }
+  
+  uint8_t frame[TrajectoryGenerator::FRAME_SIZE];
+  TrajectoryGenerator::Truth truth;
+  auto next = std::chrono::steady_clock::now();
+  unsigned long frames = 0;
+  
+  for (unsigned long t = 0; t < durationMs; t += TrajectoryGenerator::FRAME_INTERVAL_MS) {
+    generator.buildFrame(t, frame, truth);
+    fwrite(frame, 1, sizeof(frame), out);
+    frames++;
+    if (realtime) {
+      fflush(out);
+      next += std::chrono::milliseconds(TrajectoryGenerator::FRAME_INTERVAL_MS);
+      std::this_thread::sleep_until(next);
+    }
+  }
+  
+  if (out != stdout) fclose(out);
+  fprintf(stderr, "Wrote %lu frames (%lu bytes)\n", frames, frames * (unsigned long)sizeof(frame));
+  return 0;
+}
+
+// Expands a reassembled MSG_HEATMAP export into the grid
+bool decodeHeatmap(const std::string& message, std::vector<uint16_t>& cells) {
+  cells.clear();
+  if (message.size() < HEATMAP_HEADER_SIZE || (uint8_t)message[1] != MSG_HEATMAP ||
+      (uint8_t)message[2] != HEATMAP_COLS || (uint8_t)message[3] != HEATMAP_ROWS) {
+    return false;
+  }
+  
+  size_t pos = HEATMAP_HEADER_SIZE;
+  while (pos < message.size()) {
+    uint32_t value = 0;
+    for (int shift = 0; pos < message.size(); shift += 7) {
+      uint8_t b = (uint8_t)message[pos++];
+      value |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    if (value & 1) {
+      cells.push_back((uint16_t)(value >> 1));
+    } else {
+      cells.insert(cells.end(), value >> 1, 0);
+    }
+  }
+  return cells.size() == (size_t)HEATMAP_CELLS;
+}
+
+void printHeatmap(const std::vector<uint16_t>& cells) {
+  static const char shades[] = " .:-=+*#%@";
+  uint16_t peak = 1;
+  for (uint16_t cell : cells) peak = cell > peak ? cell : peak;
+  
+  // Far edge at the top, sensor at the bottom
+  for (int row = HEATMAP_ROWS - 1; row >= 0; row--) {
+    printf("  |");
+    for (int col = 0; col < HEATMAP_COLS; col++) {
+      uint16_t cell = cells[row * HEATMAP_COLS + col];
+      int shade = cell ? 1 + (int)((sizeof(shades) - 3) * (uint32_t)cell / peak) : 0;
+      putchar(shades[shade]);
+      putchar(shades[shade]);
+    }
+    printf("|\n");
+  }
+  printf("  +%s+ sensor\n", std::string(HEATMAP_COLS * 2, '-').c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double hours = 24.0;
+  bool verbose = false;
+  bool unthrottled = false;
+  bool realtime = false;
+  const char* emitPath = nullptr;
+  std::string scenario = "siteday";
+  uint32_t seed = 1;
+  int lossPermille = 0;
+  bool events = false;
+  bool heatmap = false;
+  int trackBudget = 0;
+  bool predict = false;
+  bool beacons = false;
+  unsigned long outageMs = 0;
+  const char* telemetryPath = nullptr;
+  bool bulk = false;
+  unsigned long displayCostMs = 0;
+  
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+      hours = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+      lossPermille = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+      scenario = argv[++i];
+    } else if (strcmp(argv[i], "--emit") == 0 && i + 1 < argc) {
+      emitPath = argv[++i];
+    } else if (strcmp(argv[i], "--events") == 0) {
+      events = true;
+    } else if (strcmp(argv[i], "--track") == 0 && i + 1 < argc) {
+      trackBudget = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--predict") == 0) {
+      predict = true;
+    } else if (strcmp(argv[i], "--beacons") == 0) {
+      beacons = true;
+    } else if (strcmp(argv[i], "--outage") == 0 && i + 1 < argc) {
+      outageMs = (unsigned long)(atof(argv[++i]) * 60000.0);
+    } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+      telemetryPath = argv[++i];
+    } else if (strcmp(argv[i], "--display-cost") == 0 && i + 1 < argc) {
+      displayCostMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--heatmap") == 0) {
+      heatmap = true;
+    } else if (strcmp(argv[i], "--bulk") == 0) {
+      bulk = true;
+    } else if (strcmp(argv[i], "--unthrottled") == 0) {
+      unthrottled = true;
+    } else if (strcmp(argv[i], "--realtime") == 0) {
+      realtime = true;
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--scenario NAME] [--hours N] [--seed N] [--loss PERMILLE] [--events] [--heatmap]\n"
+                      "       %*s [--track BYTES_PER_MIN] [--predict] [--beacons] [--outage MINUTES] [--display-cost MS]\n"
+                      "       %*s [--telemetry PATH] [--bulk] [--unthrottled] [--verbose]\n"
+                      "       %s --emit PATH [--scenario NAME] [--hours N] [--seed N] [--realtime]\n"
+                      "scenarios: %s\n", argv[0], (int)strlen(argv[0]), "",
+                      (int)strlen(argv[0]), "", argv[0], TrajectoryGenerator::scenarioNames());
+      return 1;
+    }
+  }
+  
+  unsigned long durationMs = (unsigned long)(hours * 3600000.0);
+  unsigned long outageStartMs = durationMs / 3;
+  TrajectoryGenerator generator;
+  generator.setSeed(seed);
+  if (!generator.loadScenario(scenario, durationMs)) {
+    fprintf(stderr, "Unknown scenario '%s' (available: %s)\n", scenario.c_str(),
+            TrajectoryGenerator::scenarioNames());
+    return 1;
+  }
+  
+  if (emitPath) {
+    return emitFrames(generator, emitPath, durationMs, realtime);
+  }
+  
+  Serial.setEcho(verbose);
+  
+  RunStats stats = {0, 0, 0};
+  PresenceScorer scorer;
+  TrackScorer trackScorer;
+  BeaconScorer beaconScorer;
+  MeshRadioSim radio;
+  radio.setLossPermille(lossPermille);
+  std::vector<MeshRadioSim::Delivered> delivered;
+  auto wallStart = std::chrono::steady_clock::now();
+  
+  // Settings are stored before boot, as if configured earlier over the mesh
+  if (events || trackBudget > 0 || predict || telemetryPath) {
+    Preferences prefs;
+    prefs.begin("ld2450_config", false);
+    if (events) prefs.putUInt("summary_s", 0);
+    if (trackBudget > 0) prefs.putUInt("track_bpm", trackBudget);
+    if (predict) prefs.putBool("predict", true);
+    if (telemetryPath) prefs.putBool("telemetry", true);
+    prefs.end();
+  }
+  if (beacons) {
+    BeaconScorer::provision();
+  }
+  
+  FILE* telemetryOut = nullptr;
+  if (telemetryPath) {
+    telemetryOut = fopen(telemetryPath, "wb");
+    if (!telemetryOut) {
+      perror(telemetryPath);
+      return 1;
+    }
+    Serial.setCapture(true);
+  }
+  
+  U8G2::pushCostMs() = displayCostMs;
+  setup();
+  scorer.setSummaryMode(ld2450Manager.getConfig().summaryWindowS > 0,
+                        ld2450Manager.getConfig().alertDistanceCm);
+  radio.poll(Sim::nowMs(), delivered);
+  unsigned long startMs = Sim::nowMs();
+  unsigned long frameTimeMs = 0;  // Scenario time of the next frame
+  uint8_t frame[TrajectoryGenerator::FRAME_SIZE];
+  TrajectoryGenerator::Truth truth;
+  
+  while (frameTimeMs < durationMs) {
+    // Feed every radar frame that became due since the last iteration, or a
+    // fixed burst per iteration when unthrottled
+    int burst = 0;
+    while (frameTimeMs < durationMs &&
+           (unthrottled ? burst < UNTHROTTLED_FRAMES_PER_LOOP
+                        : startMs + frameTimeMs <= Sim::nowMs())) {
+      generator.buildFrame(frameTimeMs, frame, truth);
+      Serial2.injectRx(frame, sizeof(frame));
+      if (!unthrottled) {
+        scorer.onFrame(truth, frameTimeMs);
+        if (trackBudget > 0) trackScorer.onFrame(truth, frameTimeMs);
+        if (beacons) beaconScorer.onFrame(truth, frameTimeMs);
+      }
+      
+      stats.framesInjected++;
+      if (truth.dropout) stats.droppedFrames++;
+      stats.ghostTargets += truth.ghosts;
+      frameTimeMs += TrajectoryGenerator::FRAME_INTERVAL_MS;
+      burst++;
+    }
+    
+    loop();
+    
+    if (telemetryOut) {
+      int c;
+      while ((c = Serial.takeTx()) >= 0) fputc(c, telemetryOut);
+    }
+    if (outageMs > 0) {
+      radio.setOffline(frameTimeMs >= outageStartMs && frameTimeMs < outageStartMs + outageMs);
+    }
+    delivered.clear();
+    radio.poll(Sim::nowMs(), delivered);
+    for (const MeshRadioSim::Delivered& packet : delivered) {
+      scorer.onPayload(packet.payload.data(), packet.payload.size(), packet.tMs - startMs);
+      trackScorer.onPayload(packet.payload.data(), packet.payload.size(), packet.queuedMs - startMs);
+      beaconScorer.onPayload(packet.payload.data(), packet.payload.size());
+    }
+  }
+  
+  // Export the heatmap over the mesh while the radar is quiet, losing its
+  // first fragment once
+  FragmentPeer heatmapPeer(radio, 0x1234, 0);
+  if (heatmap) {
+    heatmapPeer.expectReply(0x01);
+    radio.injectText("{\"m\":\"LD2450\",\"heatmap\":1}", 0x1234, 0);
+    unsigned long deadline = Sim::nowMs() + 180000;
+    while (!heatmapPeer.replyComplete() && Sim::nowMs() < deadline) {
+      loop();
+      delivered.clear();
+      radio.poll(Sim::nowMs(), delivered);
+      for (const MeshRadioSim::Delivered& packet : delivered) {
+        heatmapPeer.onDelivered(packet, Sim::nowMs());
+      }
+    }
+    
+    // Let the gateway hear the final ACK
+    for (int i = 0; i < 20; i++) {
+      loop();
+      delivered.clear();
+      radio.poll(Sim::nowMs(), delivered);
+    }
+  }
+  
+  // Bulk commands over the fragment layer: the whole whitelist in one
+  // command with its second fragment withheld, then the configuration read
+  // back with the first reply fragment lost
+  FragmentPeer bulkPeer(radio, 0x1234, 0);
+  std::string bulkList;
+  size_t bulkCommandLen = 0;
+  unsigned long bulkPackets = radio.getStats().packets;
+  if (bulk) {
+    auto runUntil = [&](bool (FragmentPeer::*done)() const) {
+      unsigned long deadline = Sim::nowMs() + 180000;
+      while (!(bulkPeer.*done)() && Sim::nowMs() < deadline) {
+        loop();
+        delivered.clear();
+        radio.poll(Sim::nowMs(), delivered);
+        for (const MeshRadioSim::Delivered& packet : delivered) {
+          bulkPeer.onDelivered(packet, Sim::nowMs());
+        }
+        bulkPeer.poll(Sim::nowMs());
+      }
+    };
+    
+    for (size_t i = 0; i < MAC_WHITELIST_MAX; i++) {
+      char mac[MAC_STRING_LEN + 1];
+      formatMac(0x02b0de000000ULL + i * 0x010203 + 1, mac);
+      if (i > 0) bulkList += ",";
+      bulkList += mac;
+    }
+    std::string target = ConfigManager::getGatewayID().c_str();
+    std::string command = "{\"target\":\"" + target + "\",\"mac_list\":\"" + bulkList + "\"}";
+    bulkCommandLen = command.size();
+    bulkPeer.send(command, 0x02, Sim::nowMs());
+    runUntil(&FragmentPeer::sendAcked);
+    
+    bulkPeer.expectReply(0x01);
+    radio.injectText(("{\"target\":\"" + target + "\",\"CMD\":\"get_config\"}").c_str(), 0x1234, 0);
+    runUntil(&FragmentPeer::replyComplete);
+    
+    // Let the gateway hear the final ACK
+    for (int i = 0; i < 20; i++) {
+      loop();
+      delivered.clear();
+      radio.poll(Sim::nowMs(), delivered);
+    }
+  }
+  bulkPackets = radio.getStats().packets - bulkPackets;
+  
+  if (telemetryOut) fclose(telemetryOut);
+  
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double simSeconds = (Sim::nowMs() - startMs) / 1000.0;
+  Sim::HeapStats heap = Sim::heapStats();
+  
+  printf("\n=== Simulation Report (%s) ===\n", scenario.c_str());
+  printf("Simulated time:    %.1f h (%.2f s wall, x%.0f)\n",
+         simSeconds / 3600.0, wallSeconds, wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+  printf("Radar frames:      %lu (%lu dropouts, %lu ghosts)%s\n", stats.framesInjected,
+         stats.droppedFrames, stats.ghostTargets, unthrottled ? " unthrottled" : "");
+  unsigned long framesParsed = ld2450Manager.getPublishedFrameCount();
+  printf("Boot:              ready after %lu ms, first frame at %lu ms\n",
+         startMs, ld2450Manager.getFirstFrameTime());
+  printf("Frames parsed:     %lu (%.0f frames/s wall, %lu bytes backlog in UART)\n", framesParsed,
+         wallSeconds > 0 ? framesParsed / wallSeconds : 0.0, (unsigned long)Serial2.rxPending());
+  const MeshRadioSim::Stats& air = radio.getStats();
+  const MeshStats& link = getMeshStats();
+  printf("Mesh packets:      %lu (%.1f per hour)\n", air.packets,
+         simSeconds > 0 ? air.packets * 3600.0 / simSeconds : 0.0);
+  printf("Mesh payload:      %lu bytes (largest %zu)\n", air.payloadBytes, air.maxPayload);
+  printf("Est. airtime:      %.1f s (%.3f%% duty cycle, LongFast)\n",
+         air.airtimeMs / 1000.0, simSeconds > 0 ? air.airtimeMs / (simSeconds * 10.0) : 0.0);
+  printf("Delivery:          %lu acked, %lu failed, %lu timed out, %lu queue rejects\n",
+         link.acked, link.failed, link.timedOut, air.queueRejects);
+  if (outageMs > 0) {
+    printf("Outage:            %.0f min from %.1f h, %lu bytes lost on UART1\n",
+           outageMs / 60000.0, outageStartMs / 3600000.0, air.offlineBytes);
+  }
+  printf("Display pushes:    %lu\n", U8G2::sendCount());
+  if (telemetryPath) {
+    printf("Telemetry:         %lu records, %lu dropped -> %s\n",
+           telemetryStream.getRecords(), telemetryStream.getDropped(), telemetryPath);
+  }
+  printf("Load shedding:     %lu degradations, %lu recoveries, %lu loops over budget, now %s\n",
+         loadSupervisor.getDegradations(), loadSupervisor.getRecoveries(), loadSupervisor.getOverruns(),
+         LoadSupervisor::stageName(loadSupervisor.getStage()));
+  printf("Heap:              current %zu B, peak %zu B, %lu allocations\n",
+         heap.currentBytes, heap.peakBytes, heap.allocations);
+  printf("Flash files:       %zu B\n", Sim::flashUsedBytes());
+  if (!unthrottled) {
+    scorer.printReport();
+  }
+  if (trackBudget > 0 && !unthrottled) {
+    trackScorer.printReport(simSeconds);
+  }
+  if (beacons && !unthrottled) {
+    beaconScorer.printReport();
+  }
+  if (heatmap) {
+    const FragmentPeer::Stats& frag = heatmapPeer.getStats();
+    std::vector<uint16_t> cells;
+    bool decoded = heatmapPeer.replyComplete() && decodeHeatmap(heatmapPeer.reply(), cells);
+    bool match = decoded;
+    for (int i = 0; match && i < HEATMAP_CELLS; i++) {
+      match = cells[i] == occupancyHeatmap.getCell(i % HEATMAP_COLS, i / HEATMAP_COLS);
+    }
+    printf("--- Occupancy Heatmap ---\n");
+    printf("Export:            %zu bytes, %lu fragments received (%lu dropped), %s\n",
+           heatmapPeer.reply().size(), frag.fragmentsReceived, frag.fragmentsDropped,
+           !heatmapPeer.replyComplete() ? "incomplete" : match ? "matches firmware grid" : "MISMATCH");
+    if (decoded) printHeatmap(cells);
+  }
+  if (bulk) {
+    const FragmentPeer::Stats& frag = bulkPeer.getStats();
+    // The whitelist is a hash set: compare the addresses, not their order
+    std::string key = "\"mac_list\":\"";
+    size_t listStart = bulkPeer.reply().find(key);
+    bool readBack = bulkPeer.replyComplete() && listStart != std::string::npos;
+    if (readBack) {
+      listStart += key.size();
+      std::string readList = bulkPeer.reply().substr(listStart, bulkPeer.reply().find('"', listStart) - listStart);
+      readBack = readList.size() == bulkList.size();
+      for (size_t pos = 0; readBack && pos < bulkList.size(); pos += MAC_STRING_LEN + 1) {
+        readBack = readList.find(bulkList.substr(pos, MAC_STRING_LEN)) != std::string::npos;
+      }
+    }
+    printf("--- Bulk Commands ---\n");
+    printf("Whitelist upload:  %zu bytes, %lu fragments sent (%lu withheld, %lu requested), %s, %u entries\n",
+           bulkCommandLen, frag.fragmentsSent, frag.fragmentsWithheld, frag.nacksReceived,
+           bulkPeer.sendAcked() ? "acknowledged" : "NOT ACKNOWLEDGED",
+           (unsigned)ConfigManager::getMacWhitelist().size());
+    printf("Config readout:    %zu bytes, %lu fragments received (%lu dropped), %s\n",
+           bulkPeer.reply().size(), frag.fragmentsReceived, frag.fragmentsDropped,
+           !bulkPeer.replyComplete() ? "incomplete" : readBack ? "whitelist matches" : "MISMATCH");
+    printf("Mesh packets:      %lu from the gateway (%lu NACKs/ACKs from the peer)\n",
+           bulkPackets, frag.nacksSent);
+  }
+  printf("==============================\n");
+  return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,205 @@
+#include "BeaconFusion.h"
+#include "MeshPayload.h"
+
+// Global instance
+BeaconFusion beaconFusion;
+
+// Residual samples are clamped so the running sum fits 16 bits
+static const uint16_t FUSION_RESIDUAL_CLAMP_CM = 1000;
+
+BeaconFusion::BeaconFusion() : identityChanged(false), namings(0), switches(0) {
+  for (MacKey& candidate : candidates) {
+    candidate = MAC_KEY_NONE;
+  }
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    resetTarget(i);
+  }
+}
+
+void BeaconFusion::resetTarget(int slot) {
+  TargetIdentity& identity = identities[slot];
+  if (identity.beacon != MAC_KEY_NONE) identityChanged = true;
+  identity.beacon = MAC_KEY_NONE;
+  identity.confidence = 0;
+  identity.residualCm = 0;
+  identity.candidate = -1;
+  for (size_t j = 0; j < FUSION_CANDIDATES; j++) {
+    residuals[slot][j].reset();
+  }
+}
+
+void BeaconFusion::freeCandidate(size_t column) {
+  candidates[column] = MAC_KEY_NONE;
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    residuals[i][column].reset();
+    if (identities[i].candidate == (int8_t)column) {
+      resetTarget(i);
+    }
+  }
+}
+
+// Drop beacons that expired or left the whitelist, give new ones a column
+void BeaconFusion::refreshCandidates() {
+  for (size_t j = 0; j < FUSION_CANDIDATES; j++) {
+    if (candidates[j] == MAC_KEY_NONE) continue;
+    DeviceInfo* device = deviceTable.find(candidates[j]);
+    if (!device || !deviceTable.isWhitelisted(device)) {
+      freeCandidate(j);
+    }
+  }
+  
+  deviceTable.forEach([this](MacKey mac, DeviceInfo& device) {
+    if (!deviceTable.isWhitelisted(&device)) return;
+    size_t freeColumn = FUSION_CANDIDATES;
+    for (size_t j = 0; j < FUSION_CANDIDATES; j++) {
+      if (candidates[j] == mac) return;
+      if (candidates[j] == MAC_KEY_NONE && freeColumn == FUSION_CANDIDATES) freeColumn = j;
+    }
+    if (freeColumn < FUSION_CANDIDATES) candidates[freeColumn] = mac;
+  });
+}
+
+// Mean residual of a pair, or UINT32_MAX if it cannot be matched
+uint32_t BeaconFusion::pairCost(int slot, int column) const {
+  const MovingAverage<uint16_t, FUSION_WINDOW>& residual = residuals[slot][column];
+  if (candidates[column] == MAC_KEY_NONE || residual.size() < FUSION_MIN_SAMPLES) return UINT32_MAX;
+  uint16_t mean = residual.average();
+  return mean <= FUSION_MAX_RESIDUAL_CM ? mean : UINT32_MAX;
+}
+
+// Exhaustive assignment over the (at most 3) targets; an unmatched target
+// costs FUSION_MAX_RESIDUAL_CM so any valid match is preferred
+void BeaconFusion::search(int slot, uint32_t usedColumns, uint32_t cost, int8_t* current,
+                          uint32_t& bestCost, int8_t* best, const bool* eligible) const {
+  if (cost >= bestCost) return;
+  if (slot == LD2450_MAX_TARGETS) {
+    bestCost = cost;
+    memcpy(best, current, LD2450_MAX_TARGETS);
+    return;
+  }
+  
+  current[slot] = -1;
+  search(slot + 1, usedColumns, cost + FUSION_MAX_RESIDUAL_CM, current, bestCost, best, eligible);
+  if (!eligible[slot]) return;
+  
+  for (size_t j = 0; j < FUSION_CANDIDATES; j++) {
+    if (usedColumns & (1u << j)) continue;
+    uint32_t pair = pairCost(slot, j);
+    if (pair == UINT32_MAX) continue;
+    current[slot] = (int8_t)j;
+    search(slot + 1, usedColumns | (1u << j), cost + pair, current, bestCost, best, eligible);
+  }
+  current[slot] = -1;
+}
+
+void BeaconFusion::onFrame(const TargetSnapshot& snapshot, unsigned long now) {
+  refreshCandidates();
+  
+  // Distance agreement of every detected target with every fresh beacon
+  bool eligible[LD2450_MAX_TARGETS];
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& target = snapshot[i];
+    eligible[i] = target.state == PRESENT;
+    if (target.state == ABSENT) {
+      // The next person in this slot starts from no evidence, whichever
+      // columns still hold samples
+      resetTarget(i);
+      continue;
+    }
+    if (!target.valid) continue;  // Held on its last position, nothing new
+    
+    for (size_t j = 0; j < FUSION_CANDIDATES; j++) {
+      if (candidates[j] == MAC_KEY_NONE) continue;
+      DeviceInfo* device = deviceTable.find(candidates[j]);
+      if (!device || now - device->lastSeen > FUSION_STALE_MS) continue;
+      int beaconCm = (int)(device->filteredDistance * 100.0f + 0.5f);
+      int residual = abs(target.lastDistance - beaconCm);
+      residuals[i][j].add(residual > FUSION_RESIDUAL_CLAMP_CM ? FUSION_RESIDUAL_CLAMP_CM : residual);
+    }
+  }
+  
+  // Cost of keeping the current assignment, then the best one overall
+  int8_t current[LD2450_MAX_TARGETS];
+  int8_t best[LD2450_MAX_TARGETS];
+  uint32_t keepCost = 0;
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    int8_t column = eligible[i] ? identities[i].candidate : -1;
+    uint32_t pair = column >= 0 ? pairCost(i, column) : UINT32_MAX;
+    if (pair == UINT32_MAX) column = -1;
+    best[i] = column;
+    keepCost += column >= 0 ? pair : FUSION_MAX_RESIDUAL_CM;
+  }
+  
+  uint32_t bestCost = keepCost > FUSION_SWITCH_MARGIN_CM ? keepCost - FUSION_SWITCH_MARGIN_CM : 0;
+  int8_t found[LD2450_MAX_TARGETS];
+  memcpy(found, best, sizeof(found));
+  search(0, 0, 0, current, bestCost, found, eligible);
+  memcpy(best, found, sizeof(best));
+  
+  // Confidence grows while a target keeps its match; names follow confidence
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    TargetIdentity& identity = identities[i];
+    if (best[i] != identity.candidate) {
+      identity.candidate = best[i];
+      identity.confidence = 0;
+    }
+    if (best[i] < 0) {
+      identity.residualCm = 0;
+      if (identity.beacon != MAC_KEY_NONE && eligible[i]) {
+        identity.beacon = MAC_KEY_NONE;
+        identityChanged = true;
+      }
+      continue;
+    }
+    
+    identity.residualCm = residuals[i][best[i]].average();
+    if (identity.confidence < UINT16_MAX) identity.confidence++;
+    MacKey mac = candidates[best[i]];
+    if (identity.confidence >= FUSION_CONFIRM_FRAMES && identity.beacon != mac) {
+      if (identity.beacon != MAC_KEY_NONE) switches++;
+      identity.beacon = mac;
+      identityChanged = true;
+      namings++;
+    }
+  }
+}
+
+bool BeaconFusion::takeChange() {
+  bool changed = identityChanged;
+  identityChanged = false;
+  return changed;
+}
+
+size_t BeaconFusion::encodeIdentities(uint8_t* out, size_t cap) const {
+  size_t len = MESH_PAYLOAD_HEADER_SIZE + 1 + LD2450_MAX_TARGETS * 7;
+  if (cap < len) return 0;
+  
+  size_t pos = 0;
+  out[pos++] = MESH_PAYLOAD_VERSION;
+  out[pos++] = MSG_IDENTITY;
+  out[pos++] = LD2450_MAX_TARGETS;
+  for (const TargetIdentity& identity : identities) {
+    bool named = identity.beacon != MAC_KEY_NONE;
+    out[pos++] = named ? (uint8_t)(identity.confidence > 255 ? 255 : identity.confidence) : 0;
+    unpackMac(named ? identity.beacon : MAC_KEY_NONE, out + pos);
+    pos += 6;
+  }
+  return pos;
+}
+
+void BeaconFusion::printStatus() const {
+  size_t active = 0;
+  for (MacKey candidate : candidates) {
+    if (candidate != MAC_KEY_NONE) active++;
+  }
+  Serial.printf("Fusion: %u candidate beacons, %lu namings, %lu switches\n",
+    (unsigned)active, namings, switches);
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetIdentity& identity = identities[i];
+    if (identity.beacon == MAC_KEY_NONE) continue;
+    char text[MAC_STRING_LEN + 1];
+    formatMac(identity.beacon, text);
+    Serial.printf("  Target %d = %s (%u frames, %u cm residual)\n",
+      i + 1, text, identity.confidence, identity.residualCm);
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef BEACONFUSION_H
+#define BEACONFUSION_H
+
+#include <Arduino.h>
+#include "LD2450Manager.h"
+#include "DeviceInfo.h"
+
+// Whitelisted beacons considered at once
+static constexpr size_t FUSION_CANDIDATES = 8;
+
+// Frames of distance agreement averaged per target/beacon pair (1.6 s)
+static constexpr size_t FUSION_WINDOW = 16;
+
+// Pairs need this many samples before they can be matched
+static constexpr size_t FUSION_MIN_SAMPLES = 8;
+
+// Largest mean |radar - beacon| distance that still counts as a match
+static constexpr uint16_t FUSION_MAX_RESIDUAL_CM = 250;
+
+// A new assignment must beat the current one by this much in total residual
+static constexpr uint16_t FUSION_SWITCH_MARGIN_CM = 60;
+
+// Consecutive matched frames before a target is named (2 s)
+static constexpr uint16_t FUSION_CONFIRM_FRAMES = 20;
+
+// Beacons not heard for this long do not update the residuals
+static constexpr unsigned long FUSION_STALE_MS = 3000;
+
+// Identity of one radar target
+struct TargetIdentity {
+  MacKey beacon;          // Named beacon, MAC_KEY_NONE = anonymous
+  uint16_t confidence;    // Consecutive frames matched to the current candidate
+  uint16_t residualCm;    // Mean distance disagreement of the current match
+  int8_t candidate;       // Matched candidate column, -1 = none
+};
+
+// Attaches beacon identities to anonymous radar targets.
+//
+// For every present radar target and every whitelisted beacon in range the
+// difference between the target's radial distance and the beacon's filtered
+// distance is kept as a moving average over FUSION_WINDOW frames (O(1) per
+// pair per frame). Each frame the targets are assigned to beacons by the
+// smallest total residual (at most 3 targets x 8 beacons, searched
+// exhaustively on the stack). The previous assignment is kept unless the new
+// one is clearly better, and a target is only named after its match held
+// for FUSION_CONFIRM_FRAMES, so one noisy RSSI burst cannot swap workers.
+class BeaconFusion {
+private:
+  MacKey candidates[FUSION_CANDIDATES];   // MAC_KEY_NONE = free column
+  MovingAverage<uint16_t, FUSION_WINDOW> residuals[LD2450_MAX_TARGETS][FUSION_CANDIDATES];
+  TargetIdentity identities[LD2450_MAX_TARGETS];
+  bool identityChanged;
+  unsigned long namings;
+  unsigned long switches;
+  
+  // Helper functions
+  void refreshCandidates();
+  void freeCandidate(size_t column);
+  void resetTarget(int slot);
+  uint32_t pairCost(int slot, int column) const;
+  void search(int slot, uint32_t usedColumns, uint32_t cost, int8_t* current,
+              uint32_t& bestCost, int8_t* best, const bool* eligible) const;
+
+public:
+  BeaconFusion();
+  
+  // Feed one processed frame
+  void onFrame(const TargetSnapshot& snapshot, unsigned long now);
+  
+  const TargetIdentity& getIdentity(int slot) const { return identities[slot]; }
+  
+  // True once after any target was named, renamed or lost its name
+  bool takeChange();
+  
+  // Encode MSG_IDENTITY (see MeshPayload.h). Returns the encoded length,
+  // 0 if cap is too small
+  size_t encodeIdentities(uint8_t* out, size_t cap) const;
+  
+  // Status
+  void printStatus() const;
+};
+
+extern BeaconFusion beaconFusion;
+
+#endif // BEACONFUSION_H
@@ -0,0 +1,116 @@
+#include "BleScanner.h"
+#include "ConfigManager.h"
+#include "RssiDistance.h"
+#include "Hal.h"
+
+// Global instances
+BleScanner bleScanner;
+MacTable<DeviceInfo, BEACON_TABLE_CAPACITY> deviceTable;
+
+BleScanner::BleScanner()
+  : dropped(0), received(0), processed(0), filtered(0), tableFull(0), expired(0),
+    whitelistVersion(0), scanning(false) {
+}
+
+void BleScanner::init() {
+  deviceTable.applyWhitelist(ConfigManager::getMacWhitelist());
+  whitelistVersion = ConfigManager::getMacWhitelist().version();
+  expiryWheel.reset(Hal::millis());
+  
+  scanning = Hal::startBleScan(onAdvertisement, ConfigManager::getScanInterval(),
+                               ConfigManager::getScanWindow(), ConfigManager::getActiveScan());
+  Serial.printf("BLE: continuous %s scan %s (interval %d ms, window %d ms)\n",
+    ConfigManager::getActiveScan() ? "active" : "passive", scanning ? "started" : "FAILED",
+    ConfigManager::getScanInterval(), ConfigManager::getScanWindow());
+}
+
+// Runs in the BLE host task: copy and return, never touch the table here
+void BleScanner::onAdvertisement(uint64_t address, int rssi) {
+  BleSighting sighting;
+  sighting.mac = address;
+  sighting.timeMs = Hal::millis();
+  sighting.rssi = rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi);
+  
+  bleScanner.received.fetch_add(1, std::memory_order_relaxed);
+  if (!bleScanner.ring.push(sighting)) {
+    bleScanner.dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void BleScanner::apply(const BleSighting& sighting) {
+  const MacWhitelist& whitelist = ConfigManager::getMacWhitelist();
+  bool useFilter = ConfigManager::getUseDeviceFilter();
+  
+  // Known beacons carry their whitelist bit; unknown ones are checked once
+  DeviceInfo* device = deviceTable.find(sighting.mac);
+  if (!device) {
+    bool whitelisted = whitelist.contains(sighting.mac);
+    if (useFilter && !whitelisted) {
+      filtered++;
+      return;
+    }
+    bool created = false;
+    device = deviceTable.findOrInsert(sighting.mac, whitelisted, &created);
+    if (!device) {
+      tableFull++;
+      return;
+    }
+    if (created) {
+      device->kalmanFilter.reset(rssiDistance.toMeters(sighting.rssi));
+    }
+  } else if (useFilter && !deviceTable.isWhitelisted(device)) {
+    filtered++;
+    return;
+  }
+  
+  device->rssi = sighting.rssi;
+  device->rawDistance = rssiDistance.toMeters(sighting.rssi);
+  device->filteredDistance = device->kalmanFilter.update(device->rawDistance);
+  device->avgRssi = device->rssiFilter.addConfigured(sighting.rssi);
+  device->avgDistance = device->distanceFilter.addConfigured(device->filteredDistance);
+  device->lastSeen = sighting.timeMs;
+  expiryWheel.schedule(deviceTable.indexOf(device),
+                       sighting.timeMs + (unsigned long)ConfigManager::getBeaconTimeout() * 1000UL);
+  processed++;
+}
+
+// Timer of a table entry ran out: the beacon has left
+void BleScanner::expire(size_t index) {
+  MacKey mac = deviceTable.keyAtIndex(index);
+  DeviceInfo* device = deviceTable.find(mac);
+  if (!device) return;
+  
+  if (deviceTable.isWhitelisted(device)) {
+    char text[MAC_STRING_LEN + 1];
+    formatMac(mac, text);
+    Serial.printf("BLE: beacon %s gone\n", text);
+  }
+  deviceTable.remove(mac);
+  expired++;
+}
+
+size_t BleScanner::process(unsigned long now) {
+  // Whitelist edits only touch the cached bits of beacons already tracked
+  uint16_t version = ConfigManager::getMacWhitelist().version();
+  if (version != whitelistVersion) {
+    deviceTable.applyWhitelist(ConfigManager::getMacWhitelist());
+    whitelistVersion = version;
+  }
+  
+  BleSighting batch[BLE_BATCH_MAX];
+  size_t n = ring.popBatch(batch, BLE_BATCH_MAX);
+  for (size_t i = 0; i < n; i++) {
+    apply(batch[i]);
+  }
+  
+  expiryWheel.advance(now, [this](size_t index) { expire(index); });
+  return n;
+}
+
+void BleScanner::printStatus() const {
+  Serial.printf("BLE: %lu received, %lu dropped, %lu processed, %lu filtered, "
+                "%u/%u beacons (%u reserved), %lu table full, %lu evicted, %lu expired\n",
+    (unsigned long)getReceived(), (unsigned long)getDropped(), processed, filtered,
+    (unsigned)deviceTable.size(), (unsigned)BEACON_TABLE_CAPACITY, (unsigned)deviceTable.reserved(),
+    tableFull, deviceTable.getEvictions(), expired);
+}
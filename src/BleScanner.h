@@ -0,0 +1,76 @@
+#ifndef BLESCANNER_H
+#define BLESCANNER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "DeviceInfo.h"
+#include "SpscRing.h"
+#include "TimingWheel.h"
+
+// What the scan callback keeps of an advertisement
+struct BleSighting {
+  MacKey mac;
+  uint32_t timeMs;
+  int8_t rssi;
+};
+
+// Advertisements buffered between the BLE host task and loop()
+static constexpr size_t BLE_RING_SIZE = 256;
+
+// Sightings handled per process() call, bounds the time spent in loop()
+static constexpr size_t BLE_BATCH_MAX = 64;
+
+// Resolution of the beacon timeout
+static constexpr unsigned long BLE_EXPIRY_TICK_MS = 100;
+
+// Continuous BLE scanning that never blocks loop().
+//
+// The scan runs in the BLE host task on the other core; its callback only
+// copies address, RSSI and arrival time into a lock-free ring. process()
+// drains the ring in batches: whitelist check, table lookup, RSSI to
+// distance, Kalman filter and moving averages. When loop() falls behind the
+// ring fills up and further advertisements are counted as dropped.
+// Every sighting re-arms the beacon's timer in a timing wheel, so timeouts
+// cost only the beacons that actually expire, however many are in range.
+class BleScanner {
+private:
+  SpscRing<BleSighting, BLE_RING_SIZE> ring;
+  std::atomic<uint32_t> dropped;     // Ring full (written by the callback)
+  std::atomic<uint32_t> received;    // All advertisements seen by the callback
+  
+  unsigned long processed;           // Sightings applied to the table
+  unsigned long filtered;            // Rejected by the whitelist
+  unsigned long tableFull;           // New device with no table entry to spare
+  unsigned long expired;             // Beacons dropped after the timeout
+  uint16_t whitelistVersion;
+  bool scanning;
+  
+  // Expiry timer per beacon table entry
+  TimingWheel<BEACON_TABLE_CAPACITY, BLE_EXPIRY_TICK_MS> expiryWheel;
+  
+  // Helper functions
+  static void onAdvertisement(uint64_t address, int rssi);
+  void apply(const BleSighting& sighting);
+  void expire(size_t index);
+
+public:
+  BleScanner();
+  
+  // Start continuous scanning with the ConfigManager scan settings
+  void init();
+  
+  // Consumer side, call from loop(). Returns the number of sightings handled
+  size_t process(unsigned long now);
+  
+  // Sightings still waiting in the ring
+  size_t getBacklog() const { return ring.size(); }
+  
+  // Status
+  uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+  uint32_t getReceived() const { return received.load(std::memory_order_relaxed); }
+  void printStatus() const;
+};
+
+extern BleScanner bleScanner;
+
+#endif // BLESCANNER_H
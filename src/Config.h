@@ -2,7 +2,7 @@
 #define CONFIG_H
 
 #include <Arduino.h>
-#include <string>
+#include "FixedString.h"
 
 //========================= LD2450 SENSOR PINS =========================
 // UART2 for LD2450 Sensor
@@ -18,6 +18,6 @@ static constexpr int LD2450_BAUD_RATE = 256000;      // 256000 baud
 static constexpr int PAYLOAD_OUTPUT_INTERVAL = 2000;  // Interval in milliseconds
 
 // Gateway/Device Identification
-extern std::string GATEWAY_ID;
+extern GatewayId GATEWAY_ID;
 
 #endif // CONFIG_H
\ No newline at end of file
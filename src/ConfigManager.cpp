@@ -1,5 +1,7 @@
 #include "ConfigManager.h"
 #include "Config.h"
+#include "RssiDistance.h"
+#include "MeshFragment.h"
 #include <Preferences.h>
 #include <ArduinoJson.h>
 
@@ -17,26 +19,33 @@ float ConfigManager::runtime_MEASUREMENT_NOISE = 0.5;
 int ConfigManager::runtime_WINDOW_SIZE = 5;
 int ConfigManager::runtime_BEACON_TIMEOUT_SECONDS = 10;
 
-std::string ConfigManager::runtime_GATEWAY_ID = "TRAC 001";
+GatewayId ConfigManager::runtime_GATEWAY_ID = "TRAC 001";
 
-std::set<std::string> ConfigManager::runtime_mac_addresses;
+uint32_t ConfigManager::runtime_MESH_DEST = 0xFFFFFFFF;  // Broadcast
+uint8_t ConfigManager::runtime_MESH_CHANNEL = 0;
+bool ConfigManager::runtime_MESH_WANT_ACK = true;
+
+int ConfigManager::runtime_LOOP_BUDGET_MS = 50;
+
+MacWhitelist ConfigManager::runtime_mac_addresses;
 bool ConfigManager::runtime_USE_DEVICE_FILTER = false;
-String ConfigManager::runtime_DEVICE_FILTER = "";
 
-std::string GATEWAY_ID = "TRAC 001";
+GatewayId GATEWAY_ID = "TRAC 001";
 
 void ConfigManager::init() {
     // Minimal init - load from NVS if available
     loadFromNVS();
     
     GATEWAY_ID = runtime_GATEWAY_ID;
+    rssiDistance.rebuild();
     
     Serial.println("ConfigManager initialized");
     printCurrentConfig();
 }
 
 bool ConfigManager::processConfigCommand(const String& jsonString) {
-    StaticJsonDocument<200> doc;
+    // Static: bulk whitelist commands arrive reassembled from several packets
+    static StaticJsonDocument<MESH_COMMAND_JSON_CAPACITY> doc;
     DeserializationError error = deserializeJson(doc, jsonString);
     
     if (error) {
@@ -50,10 +59,10 @@ bool ConfigManager::processConfigCommand(const String& jsonString) {
         return false;
     }
     
-    String targetGateway = doc["target"].as<String>();
-    if (targetGateway != GATEWAY_ID.c_str()) {
+    const char* targetGateway = doc["target"].as<const char*>();
+    if (GATEWAY_ID != targetGateway) {
         Serial.printf("ERROR: Command target '%s' does not match this gateway '%s'\n", 
-                     targetGateway.c_str(), GATEWAY_ID.c_str());
+                     targetGateway ? targetGateway : "", GATEWAY_ID.c_str());
         return false;
     }
     
@@ -63,13 +72,168 @@ bool ConfigManager::processConfigCommand(const String& jsonString) {
     if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "set_gateway_id") {
         if (doc.containsKey("value")) {
             String newGatewayId = doc["value"].as<String>();
-            runtime_GATEWAY_ID = newGatewayId.c_str();
-            GATEWAY_ID = newGatewayId.c_str();
-            Serial.printf("Gateway ID changed to: %s\n", GATEWAY_ID.c_str());
+            if (newGatewayId.length() > 0 &&
+                runtime_GATEWAY_ID.assign(newGatewayId.c_str(), newGatewayId.length())) {
+                GATEWAY_ID = runtime_GATEWAY_ID;
+                Serial.printf("Gateway ID changed to: %s\n", GATEWAY_ID.c_str());
+                configChanged = true;
+            } else {
+                Serial.printf("ERROR: Gateway ID must be 1-%u characters\n", (unsigned)GATEWAY_ID_MAX_LEN);
+            }
+        }
+    }
+    
+    // Meshtastic destination: node number ("!a1b2c3d4", decimal) or "broadcast"
+    if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "set_mesh_dest") {
+        if (doc.containsKey("value")) {
+            String dest = doc["value"].as<String>();
+            if (dest == "broadcast") {
+                runtime_MESH_DEST = 0xFFFFFFFF;
+            } else if (dest.length() > 1 && dest[0] == '!') {
+                runtime_MESH_DEST = strtoul(dest.c_str() + 1, nullptr, 16);
+            } else {
+                runtime_MESH_DEST = strtoul(dest.c_str(), nullptr, 10);
+            }
+            Serial.printf("Mesh destination changed to: 0x%08lx\n", (unsigned long)runtime_MESH_DEST);
+            configChanged = true;
+        }
+    }
+    
+    if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "set_mesh_channel") {
+        if (doc.containsKey("value")) {
+            int channel = doc["value"].as<int>();
+            if (channel >= 0 && channel <= 7) {
+                runtime_MESH_CHANNEL = channel;
+                Serial.printf("Mesh channel changed to: %d\n", channel);
+                configChanged = true;
+            }
+        }
+    }
+    
+    if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "set_mesh_ack") {
+        if (doc.containsKey("value")) {
+            runtime_MESH_WANT_ACK = doc["value"].as<bool>();
+            Serial.printf("Mesh want_ack: %s\n", runtime_MESH_WANT_ACK ? "on" : "off");
             configChanged = true;
         }
     }
     
+    if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "set_loop_budget") {
+        if (doc.containsKey("value")) {
+            int budget = doc["value"].as<int>();
+            if (budget >= 5 && budget <= 1000) {
+                runtime_LOOP_BUDGET_MS = budget;
+                Serial.printf("Loop budget changed to: %d ms\n", budget);
+                configChanged = true;
+            }
+        }
+    }
+    
+    // Path loss model, the RSSI distance table is rebuilt once for all of them
+    bool pathLossChanged = false;
+    
+    if (doc.containsKey("tx_power")) {
+        int txPower = doc["tx_power"].as<int>();
+        if (txPower >= -100 && txPower <= 20) {
+            runtime_TX_POWER = txPower;
+            Serial.printf("TX power changed to: %d dBm\n", txPower);
+            pathLossChanged = true;
+        }
+    }
+    
+    if (doc.containsKey("env_factor")) {
+        float factor = doc["env_factor"].as<float>();
+        if (factor >= 1.5f && factor <= 4.0f) {
+            runtime_ENVIRONMENTAL_FACTOR = factor;
+            Serial.printf("Environmental factor changed to: %.2f\n", factor);
+            pathLossChanged = true;
+        }
+    }
+    
+    if (doc.containsKey("distance_correction")) {
+        float correction = doc["distance_correction"].as<float>();
+        if (correction >= -2.0f && correction <= 2.0f) {
+            runtime_DISTANCE_CORRECTION = correction;
+            Serial.printf("Distance correction changed to: %.2f m\n", correction);
+            pathLossChanged = true;
+        }
+    }
+    
+    if (pathLossChanged) {
+        rssiDistance.rebuild();
+        configChanged = true;
+    }
+    
+    // Beacon whitelist
+    if (doc.containsKey("mac_add")) {
+        MacKey mac;
+        if (!parseMac(doc["mac_add"].as<const char*>(), mac)) {
+            Serial.println("ERROR: mac_add expects aa:bb:cc:dd:ee:ff");
+        } else if (!runtime_mac_addresses.add(mac)) {
+            Serial.printf("ERROR: MAC whitelist full (%u entries)\n", (unsigned)MAC_WHITELIST_MAX);
+        } else {
+            Serial.printf("MAC added, whitelist has %u entries\n", (unsigned)runtime_mac_addresses.size());
+            configChanged = true;
+        }
+    }
+    
+    if (doc.containsKey("mac_remove")) {
+        MacKey mac;
+        if (parseMac(doc["mac_remove"].as<const char*>(), mac) && runtime_mac_addresses.remove(mac)) {
+            Serial.printf("MAC removed, whitelist has %u entries\n", (unsigned)runtime_mac_addresses.size());
+            configChanged = true;
+        } else {
+            Serial.println("ERROR: mac_remove address not in whitelist");
+        }
+    }
+    
+    // Replace the whole whitelist: "aa:bb:cc:dd:ee:ff,11:22:33:44:55:66,..."
+    // ("" empties it). Nothing changes unless every address is valid and
+    // they all fit
+    if (doc.containsKey("mac_list")) {
+        String listText = doc["mac_list"].as<String>();
+        const char* list = listText.c_str();
+        MacKey macs[MAC_WHITELIST_MAX];
+        size_t count = 0;
+        bool valid = true;
+        while (valid && *list) {
+            const char* end = strchr(list, ',');
+            size_t len = end ? (size_t)(end - list) : strlen(list);
+            char text[MAC_STRING_LEN + 1];
+            if (len != MAC_STRING_LEN || count >= MAC_WHITELIST_MAX) {
+                valid = false;
+                break;
+            }
+            memcpy(text, list, len);
+            text[len] = '\0';
+            valid = parseMac(text, macs[count++]);
+            list = end ? end + 1 : list + len;
+        }
+        if (valid) {
+            runtime_mac_addresses.clear();
+            for (size_t i = 0; i < count; i++) {
+                runtime_mac_addresses.add(macs[i]);
+            }
+            Serial.printf("MAC whitelist replaced, %u entries\n", (unsigned)runtime_mac_addresses.size());
+            configChanged = true;
+        } else {
+            Serial.printf("ERROR: mac_list expects up to %u comma-separated aa:bb:cc:dd:ee:ff\n",
+                          (unsigned)MAC_WHITELIST_MAX);
+        }
+    }
+    
+    if (doc.containsKey("mac_clear") && doc["mac_clear"].as<bool>()) {
+        runtime_mac_addresses.clear();
+        Serial.println("MAC whitelist cleared");
+        configChanged = true;
+    }
+    
+    if (doc.containsKey("mac_enable")) {
+        runtime_USE_DEVICE_FILTER = doc["mac_enable"].as<bool>();
+        Serial.printf("MAC filter: %s\n", runtime_USE_DEVICE_FILTER ? "on" : "off");
+        configChanged = true;
+    }
+    
     if (configChanged) {
         saveToNVS();
     }
@@ -77,9 +241,55 @@ bool ConfigManager::processConfigCommand(const String& jsonString) {
     return configChanged;
 }
 
+size_t ConfigManager::encodeConfigJson(char* out, size_t cap) {
+    int len = snprintf(out, cap,
+                       "{\"gateway_id\":\"%s\",\"mesh_dest\":\"!%08lx\",\"mesh_channel\":%d,\"mesh_ack\":%s,"
+                       "\"loop_budget\":%d,\"tx_power\":%d,\"env_factor\":%.2f,\"distance_correction\":%.2f,"
+                       "\"mac_enable\":%s,\"mac_list\":\"",
+                       GATEWAY_ID.c_str(), (unsigned long)runtime_MESH_DEST, runtime_MESH_CHANNEL,
+                       runtime_MESH_WANT_ACK ? "true" : "false", runtime_LOOP_BUDGET_MS, runtime_TX_POWER,
+                       runtime_ENVIRONMENTAL_FACTOR, runtime_DISTANCE_CORRECTION,
+                       runtime_USE_DEVICE_FILTER ? "true" : "false");
+    if (len < 0 || (size_t)len >= cap) {
+        return 0;
+    }
+    
+    // Whitelist in the format mac_list accepts
+    size_t pos = len;
+    runtime_mac_addresses.forEach([&](MacKey mac) {
+        if (pos + MAC_STRING_LEN + 1 < cap) {
+            if (out[pos - 1] != '"') out[pos++] = ',';
+            formatMac(mac, out + pos);
+            pos += MAC_STRING_LEN;
+        } else {
+            pos = cap;
+        }
+    });
+    if (pos + 3 > cap) {
+        return 0;
+    }
+    out[pos++] = '"';
+    out[pos++] = '}';
+    out[pos] = '\0';
+    return pos;
+}
+
 void ConfigManager::printCurrentConfig() {
     Serial.println("\n=== ConfigManager Status ===");
     Serial.printf("GATEWAY_ID: %s\n", GATEWAY_ID.c_str());
+    Serial.printf("MESH_DEST: 0x%08lx\n", (unsigned long)runtime_MESH_DEST);
+    Serial.printf("MESH_CHANNEL: %d\n", runtime_MESH_CHANNEL);
+    Serial.printf("MESH_WANT_ACK: %s\n", runtime_MESH_WANT_ACK ? "on" : "off");
+    Serial.printf("LOOP_BUDGET: %d ms\n", runtime_LOOP_BUDGET_MS);
+    Serial.printf("PATH_LOSS: tx %d dBm, N %.2f, correction %.2f m\n",
+                  runtime_TX_POWER, runtime_ENVIRONMENTAL_FACTOR, runtime_DISTANCE_CORRECTION);
+    Serial.printf("MAC_FILTER: %s, %u/%u entries\n", runtime_USE_DEVICE_FILTER ? "on" : "off",
+                  (unsigned)runtime_mac_addresses.size(), (unsigned)MAC_WHITELIST_MAX);
+    runtime_mac_addresses.forEach([](MacKey mac) {
+        char text[MAC_STRING_LEN + 1];
+        formatMac(mac, text);
+        Serial.printf("  %s\n", text);
+    });
     Serial.println("=============================\n");
 }
 
@@ -92,6 +302,27 @@ void ConfigManager::saveToNVS() {
     }
     
     prefs.putString("gateway_id", runtime_GATEWAY_ID.c_str());
+    prefs.putUInt("mesh_dest", runtime_MESH_DEST);
+    prefs.putUInt("mesh_channel", runtime_MESH_CHANNEL);
+    prefs.putBool("mesh_ack", runtime_MESH_WANT_ACK);
+    prefs.putInt("loop_budget", runtime_LOOP_BUDGET_MS);
+    prefs.putInt("tx_power", runtime_TX_POWER);
+    prefs.putFloat("env_factor", runtime_ENVIRONMENTAL_FACTOR);
+    prefs.putFloat("dist_corr", runtime_DISTANCE_CORRECTION);
+    prefs.putBool("mac_enable", runtime_USE_DEVICE_FILTER);
+    
+    // Whitelist as 6 bytes per address
+    uint8_t macs[MAC_WHITELIST_MAX * 6];
+    size_t macBytes = 0;
+    runtime_mac_addresses.forEach([&](MacKey mac) {
+        unpackMac(mac, macs + macBytes);
+        macBytes += 6;
+    });
+    if (macBytes > 0) {
+        prefs.putBytes("mac_list", macs, macBytes);
+    } else {
+        prefs.remove("mac_list");
+    }
     
     prefs.end();
     Serial.println("Configuration saved to NVS");
@@ -109,8 +340,25 @@ void ConfigManager::loadFromNVS() {
     
     Serial.println("Loading saved configuration from NVS...");
     
-    runtime_GATEWAY_ID = prefs.getString("gateway_id", "TRAC 001").c_str();
+    if (!runtime_GATEWAY_ID.assign(prefs.getString("gateway_id", "TRAC 001").c_str())) {
+        runtime_GATEWAY_ID.assign("TRAC 001");
+    }
     GATEWAY_ID = runtime_GATEWAY_ID;
+    runtime_MESH_DEST = prefs.getUInt("mesh_dest", 0xFFFFFFFF);
+    runtime_MESH_CHANNEL = prefs.getUInt("mesh_channel", 0);
+    runtime_MESH_WANT_ACK = prefs.getBool("mesh_ack", true);
+    runtime_LOOP_BUDGET_MS = prefs.getInt("loop_budget", 50);
+    runtime_TX_POWER = prefs.getInt("tx_power", -59);
+    runtime_ENVIRONMENTAL_FACTOR = prefs.getFloat("env_factor", 2.7);
+    runtime_DISTANCE_CORRECTION = prefs.getFloat("dist_corr", -0.5);
+    runtime_USE_DEVICE_FILTER = prefs.getBool("mac_enable", false);
+    
+    uint8_t macs[MAC_WHITELIST_MAX * 6];
+    size_t macBytes = prefs.getBytes("mac_list", macs, sizeof(macs));
+    runtime_mac_addresses.clear();
+    for (size_t i = 0; i + 6 <= macBytes; i += 6) {
+        runtime_mac_addresses.add(packMac(macs + i));
+    }
     
     prefs.end();
     
@@ -3,8 +3,12 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <set>
-#include <string>
+#include "FixedString.h"
+#include "MacTable.h"
+
+// Beacon whitelist, packed 48-bit addresses with O(1) membership tests
+static constexpr size_t MAC_WHITELIST_MAX = 32;
+typedef MacSet<MAC_WHITELIST_MAX> MacWhitelist;
 
 // ConfigManager class to handle dynamic configuration updates
 class ConfigManager {
@@ -24,15 +28,21 @@ private:
     static int runtime_BEACON_TIMEOUT_SECONDS;
     
     // ✅ NEW: Runtime GATEWAY_ID
-    static std::string runtime_GATEWAY_ID;
+    static GatewayId runtime_GATEWAY_ID;
+    
+    // Meshtastic packet routing
+    static uint32_t runtime_MESH_DEST;
+    static uint8_t runtime_MESH_CHANNEL;
+    static bool runtime_MESH_WANT_ACK;
+    
+    // Per-iteration work budget of loop() for load shedding
+    static int runtime_LOOP_BUDGET_MS;
     
     // MAC address management
-    static std::set<std::string> runtime_mac_addresses;
+    static MacWhitelist runtime_mac_addresses;
     static bool runtime_USE_DEVICE_FILTER;
-    static String runtime_DEVICE_FILTER;
     
     // Helper functions
-    static void rebuildDeviceFilterString();
     static void updateBLEScannerSettings();
     
 public:
@@ -42,6 +52,10 @@ public:
     // Parse and process single JSON configuration command
     static bool processConfigCommand(const String& jsonString);
     
+    // Current gateway settings and whitelist as JSON (get_config reply)
+    // Returns the length written, 0 if cap is too small
+    static size_t encodeConfigJson(char* out, size_t cap);
+    
     // Getters for runtime values (to replace Config.h constants)
     static int getScanTime() { return runtime_SCAN_TIME; }
     static int getScanInterval() { return runtime_SCAN_INTERVAL; }
@@ -56,10 +70,17 @@ public:
     static int getWindowSize() { return runtime_WINDOW_SIZE; }
     static int getBeaconTimeout() { return runtime_BEACON_TIMEOUT_SECONDS; }
     static bool getUseDeviceFilter() { return runtime_USE_DEVICE_FILTER; }
-    static const String& getDeviceFilter() { return runtime_DEVICE_FILTER; }
+    static const MacWhitelist& getMacWhitelist() { return runtime_mac_addresses; }
     
     // ✅ NEW: Getter for runtime GATEWAY_ID
-    static const std::string& getGatewayID() { return runtime_GATEWAY_ID; }
+    static const GatewayId& getGatewayID() { return runtime_GATEWAY_ID; }
+    
+    // Meshtastic destination node, channel index and delivery confirmation
+    static uint32_t getMeshDest() { return runtime_MESH_DEST; }
+    static uint8_t getMeshChannel() { return runtime_MESH_CHANNEL; }
+    static bool getMeshWantAck() { return runtime_MESH_WANT_ACK; }
+    
+    static int getLoopBudgetMs() { return runtime_LOOP_BUDGET_MS; }
     
     // Print current configuration
     static void printCurrentConfig();
@@ -0,0 +1,21 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), bitwise.
+// Shared by the event journal, the USB telemetry and mesh fragments; none of
+// them checks more than a few hundred bytes at a time, so no table is kept.
+// Plain C++11 only, so host tools can use it too.
+inline uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+#endif // CRC16_H
@@ -1,10 +1,16 @@
 #ifndef DEVICEINFO_H
 #define DEVICEINFO_H
 
-#include <string>
-#include <map>
+#include <Arduino.h>
+#include "FixedString.h"
+#include "MacTable.h"
 #include "Filters.h"
 
+// Devices tracked at once, enough for a busy site with the device filter
+// off. Entries for the whitelisted beacons are always kept free; other
+// addresses seen while the rest is in use are ignored until entries expire
+static constexpr size_t BEACON_TABLE_CAPACITY = 256;
+
 // Device information structure
 struct DeviceInfo {
   int rssi;
@@ -12,10 +18,10 @@ struct DeviceInfo {
   float filteredDistance;
   float avgRssi;
   float avgDistance;
-  std::string name;
-  std::string manufacturerId;
-  std::string manufacturerName;
-  std::string serviceUUID;
+  DeviceName name;
+  uint16_t manufacturerId;
+  const char* manufacturerName;   // Static string from getManufacturerName()
+  FixedString<36> serviceUUID;
   unsigned long lastSeen;
   KalmanFilter kalmanFilter;
   MovingAverageFilter rssiFilter;
@@ -27,17 +33,19 @@ struct DeviceInfo {
     filteredDistance(0), 
     avgRssi(0), 
     avgDistance(0), 
+    manufacturerId(0),
+    manufacturerName(""),
     lastSeen(0),
     kalmanFilter(0),
     rssiFilter(),
     distanceFilter() {}
 };
 
-// Map to store devices and their information
-extern std::map<std::string, DeviceInfo> deviceInfoMap;
+// Devices and their information, keyed by address
+extern MacTable<DeviceInfo, BEACON_TABLE_CAPACITY> deviceTable;
 
 // Helper functions for device info
-String getManufacturerName(uint16_t manufacturerId);
-String getServiceName(std::string uuidStr);
+const char* getManufacturerName(uint16_t manufacturerId);
+const char* getServiceName(const char* uuidStr);
 
 #endif // DEVICEINFO_H
\ No newline at end of file
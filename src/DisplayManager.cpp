@@ -1,9 +1,12 @@
 #include "DisplayManager.h"
 #include "Config.h"
+#include "Hal.h"
 
 // Constructor
 DisplayManager::DisplayManager(int sdaPin, int sclPin) 
-  : isDisplayActive(true), lastUpdateTime(0), lastMeasurementTime(0) {
+  : isDisplayActive(true), lastUpdateTime(0), lastMeasurementTime(0),
+    updateInterval(UPDATE_INTERVAL), splashActive(false), splashStartTime(0),
+    radarBackgroundValid(false), radarConfigVersion(0), radarScaleQ12(0) {
   display = new U8G2_SH1106_128X64_NONAME_F_SW_I2C(U8G2_R0, sclPin, sdaPin, U8X8_PIN_NONE);
 }
 
@@ -49,7 +52,8 @@ void DisplayManager::displayStartup() {
   display->drawStr(x3, 58, "NGIS PTE LTD");
   
   display->sendBuffer();
-  delay(3000);
+  splashActive = true;
+  splashStartTime = Hal::millis();
 }
 
 String DisplayManager::formatDistance(int distanceCm) {
@@ -80,20 +84,19 @@ String DisplayManager::formatLastSeen(unsigned long lastMeasurementMs) {
   return String(buffer);
 }
 
-void DisplayManager::updateDisplay(const std::string& deviceId,
-                                   bool t1Present, int t1Distance,
-                                   bool t2Present, int t2Distance,
-                                   bool t3Present, int t3Distance,
-                                   int closestDistance,
-                                   int rangeThresholdCm,
-                                   bool filterEnabled) {
+void DisplayManager::updateDisplay(const ConfigSnapshot& config, const TargetSnapshot& snapshot) {
   if (!display) return;
   
-  // Check if any target present
-  bool anyTargetPresent = t1Present || t2Present || t3Present;
+  // Splash stays up while the radar is already running, a target replaces it
+  if (splashActive) {
+    if (snapshot.presentCount == 0 && Hal::millis() - splashStartTime < SPLASH_DURATION) {
+      return;
+    }
+    splashActive = false;
+  }
   
   // Turn off display if no target
-  if (!anyTargetPresent) {
+  if (snapshot.presentCount == 0) {
     turnDisplayOff();
     return;
   }
@@ -102,64 +105,138 @@ void DisplayManager::updateDisplay(const std::string& deviceId,
   turnDisplayOn();
   
   // Check if update needed
-  unsigned long currentTime = millis();
-  if (currentTime - lastUpdateTime < UPDATE_INTERVAL) {
+  unsigned long currentTime = Hal::millis();
+  if (currentTime - lastUpdateTime < updateInterval) {
     return;
   }
   lastUpdateTime = currentTime;
   
-  display->clearBuffer();
-  display->setDrawColor(1);
-  
-  drawMainScreen(deviceId, t1Present, t1Distance, t2Present, t2Distance, 
-                 t3Present, t3Distance, closestDistance, rangeThresholdCm, filterEnabled);
+  if (config.radarView) {
+    drawRadarScreen(config, snapshot);
+  } else {
+    display->clearBuffer();
+    display->setDrawColor(1);
+    drawMainScreen(config, snapshot);
+  }
   
   display->sendBuffer();
   isDisplayActive = true;
 }
 
-void DisplayManager::drawMainScreen(const std::string& deviceId,
-                                    bool t1Present, int t1Distance,
-                                    bool t2Present, int t2Distance,
-                                    bool t3Present, int t3Distance,
-                                    int closestDistance,
-                                    int rangeThresholdCm,
-                                    bool filterEnabled) {
+// Static lines come preformatted with the configuration
+void DisplayManager::drawMainScreen(const ConfigSnapshot& config, const TargetSnapshot& snapshot) {
   // Line 1: ID: DeviceName
   display->setFont(u8g2_font_t0_12_tr);
-  String line1 = "ID: " + String(deviceId.c_str());
-  display->drawStr(0, 10, line1.c_str());
+  display->drawStr(0, 10, config.idLine);
   
   // Trennstrich unter ID
   display->drawLine(0, 12, 128, 12);
   
-  // Line 2: T1: IN/OUT  T2: IN/OUT  T3: IN/OUT
-  String t1Status = t1Present ? "IN" : "OUT";
-  String t2Status = t2Present ? "IN" : "OUT";
-  String t3Status = t3Present ? "IN" : "OUT";
-  
-  String line2 = "T1:" + t1Status + "  T2:" + t2Status + "  T3:" + t3Status;
-  display->drawStr(0, 25, line2.c_str());
-  
+  // Line 2: Tn: IN/OUT in one column per target
   // Line 3: distances aligned under status
-  String t1Dist = t1Present ? String(t1Distance) + "cm" : "---";
-  String t2Dist = t2Present ? String(t2Distance) + "cm" : "---";
-  String t3Dist = t3Present ? String(t3Distance) + "cm" : "---";
-  
-  String line3 = t1Dist + "    " + t2Dist + "    " + t3Dist;
-  display->drawStr(0, 37, line3.c_str());
+  int columnWidth = 128 / TargetSnapshot::capacity();
+  for (int i = 0; i < TargetSnapshot::capacity(); i++) {
+    const TargetInfo& target = snapshot[i];
+    bool present = (target.state == PRESENT);
+    int x = i * columnWidth;
+    
+    String status = "T" + String(i + 1) + ":" + (present ? "IN" : "OUT");
+    display->drawStr(x, 25, status.c_str());
+    
+    String dist = present ? String(target.lastDistance) + "cm" : "---";
+    display->drawStr(x, 37, dist.c_str());
+  }
   
   // Trennstrich
   display->drawLine(0, 40, 128, 40);
   
   // Line 4: Range threshold
-  String line4 = "Range: " + String(rangeThresholdCm) + "cm";
-  display->drawStr(0, 51, line4.c_str());
+  display->drawStr(0, 51, config.rangeLine);
   
   // Line 5: Filter status and Magic Word
-  String filterStr = filterEnabled ? "ON" : "OFF";
-  String line5 = "Filter:" + filterStr + " MW:LD2450";
-  display->drawStr(0, 62, line5.c_str());
+  display->drawStr(0, 62, config.statusLine);
+}
+
+// Field of view edges at +-60 degrees, 12-bit fixed point
+static const int32_t SIN60_Q12 = 3547;
+static const int32_t COS60_Q12 = 2048;
+
+// Map radar coordinates (mm, y forward) to pixels with the cached scale.
+// Returns false if the point falls outside the display
+bool DisplayManager::radarToScreen(int xMm, int yMm, int& px, int& py) const {
+  px = RADAR_ORIGIN_X + ((xMm * radarScaleQ12) >> 12);
+  py = RADAR_ORIGIN_Y - ((yMm * radarScaleQ12) >> 12);
+  return px >= 0 && px < 128 && py >= 0 && py < 64;
+}
+
+void DisplayManager::renderRadarBackground(const ConfigSnapshot& config) {
+  int rangeMm = config.rangeMaxCm * 10;
+  radarScaleQ12 = ((int32_t)RADAR_RADIUS_PX << 12) / rangeMm;
+  
+  display->clearBuffer();
+  display->setDrawColor(1);
+  
+  // Detection range arc and field of view
+  display->drawCircle(RADAR_ORIGIN_X, RADAR_ORIGIN_Y, RADAR_RADIUS_PX,
+                      U8G2_DRAW_UPPER_LEFT | U8G2_DRAW_UPPER_RIGHT);
+  int fovDx = (RADAR_RADIUS_PX * SIN60_Q12) >> 12;
+  int fovDy = (RADAR_RADIUS_PX * COS60_Q12) >> 12;
+  display->drawLine(RADAR_ORIGIN_X, RADAR_ORIGIN_Y, RADAR_ORIGIN_X - fovDx, RADAR_ORIGIN_Y - fovDy);
+  display->drawLine(RADAR_ORIGIN_X, RADAR_ORIGIN_Y, RADAR_ORIGIN_X + fovDx, RADAR_ORIGIN_Y - fovDy);
+  
+  // Boresight with a tick every metre
+  for (int mm = 1000; mm < rangeMm; mm += 1000) {
+    int py = RADAR_ORIGIN_Y - ((mm * radarScaleQ12) >> 12);
+    display->drawHLine(RADAR_ORIGIN_X - 2, py, 5);
+  }
+  display->drawPixel(RADAR_ORIGIN_X, RADAR_ORIGIN_Y - RADAR_RADIUS_PX);
+  
+  // Safety zone, drawn double so it stands out from the range arc
+  if (config.alertDistanceCm > 0 && config.alertDistanceCm < config.rangeMaxCm) {
+    int r = (config.alertDistanceCm * 10 * radarScaleQ12) >> 12;
+    display->drawCircle(RADAR_ORIGIN_X, RADAR_ORIGIN_Y, r, U8G2_DRAW_UPPER_LEFT | U8G2_DRAW_UPPER_RIGHT);
+    if (r > 1) {
+      display->drawCircle(RADAR_ORIGIN_X, RADAR_ORIGIN_Y, r - 1, U8G2_DRAW_UPPER_LEFT | U8G2_DRAW_UPPER_RIGHT);
+    }
+  }
+  
+  // Device name and range in the top corners
+  display->setFont(u8g2_font_tom_thumb_4x6_tr);
+  display->drawStr(0, 6, config.deviceName.c_str());
+  display->drawStr(128 - display->getStrWidth(config.rangeLabel), 6, config.rangeLabel);
+  
+  memcpy(radarBackground, display->getBufferPtr(), sizeof(radarBackground));
+  radarBackgroundValid = true;
+  radarConfigVersion = config.version;
+}
+
+// Top-down view: cached background plus one marker per target.
+// Detected targets are filled, held (stationary, not currently reported)
+// ones hollow, unconfirmed candidates a single pixel
+void DisplayManager::drawRadarScreen(const ConfigSnapshot& config, const TargetSnapshot& snapshot) {
+  if (!radarBackgroundValid || radarConfigVersion != config.version) {
+    renderRadarBackground(config);
+  }
+  
+  memcpy(display->getBufferPtr(), radarBackground, sizeof(radarBackground));
+  display->setDrawColor(1);
+  
+  for (const TargetInfo& target : snapshot) {
+    int px, py;
+    if (target.state == ABSENT || !radarToScreen(target.lastX, target.lastY, px, py)) continue;
+    
+    // Outside the range arc (compared squared, no square root per target)
+    uint32_t distSqMm = (uint32_t)(target.lastX * target.lastX) + (uint32_t)(target.lastY * target.lastY);
+    if (distSqMm > config.rangeMaxSqMm) continue;
+    
+    if (target.state == DEBOUNCE) {
+      if (target.valid) display->drawPixel(px, py);
+    } else if (target.valid) {
+      display->drawDisc(px, py, 2, U8G2_DRAW_ALL);
+    } else {
+      display->drawCircle(px, py, 2, U8G2_DRAW_ALL);
+    }
+  }
 }
 
 void DisplayManager::drawAbsentScreen() {
@@ -179,7 +256,7 @@ void DisplayManager::drawAbsentScreen() {
 }
 
 void DisplayManager::updateMeasurementTime() {
-  lastMeasurementTime = millis();
+  lastMeasurementTime = Hal::millis();
 }
 
 void DisplayManager::turnDisplayOff() {
@@ -199,6 +276,6 @@ void DisplayManager::turnDisplayOn() {
 }
 
 bool DisplayManager::shouldUpdate() {
-  unsigned long currentTime = millis();
-  return (currentTime - lastUpdateTime >= UPDATE_INTERVAL);
+  unsigned long currentTime = Hal::millis();
+  return (currentTime - lastUpdateTime >= updateInterval);
 }
\ No newline at end of file
@@ -3,46 +3,60 @@
 
 #include <Arduino.h>
 #include <U8g2lib.h>
-#include <string>
+#include "LD2450Manager.h"
 
 #define UPDATE_INTERVAL 500  // Update display every 500ms
+#define SPLASH_DURATION 3000 // Startup splash stays up this long unless a target appears
+
+// Radar plot geometry: sensor at the bottom centre, range arc radius in pixels
+#define RADAR_ORIGIN_X 64
+#define RADAR_ORIGIN_Y 63
+#define RADAR_RADIUS_PX 56
+
+// Full-frame buffer of the 128x64 display (U8g2 F mode)
+static constexpr size_t DISPLAY_BUFFER_SIZE = 128 * 64 / 8;
 
 class DisplayManager {
-  
+
 private:
   U8G2_SH1106_128X64_NONAME_F_SW_I2C* display;
   bool isDisplayActive;
   unsigned long lastUpdateTime;
   unsigned long lastMeasurementTime;
+  unsigned long updateInterval;
+  bool splashActive;
+  unsigned long splashStartTime;
+  
+  // Radar plot background (arcs, field of view, labels), rendered once per
+  // configuration and copied into the frame buffer on every refresh
+  uint8_t radarBackground[DISPLAY_BUFFER_SIZE];
+  bool radarBackgroundValid;
+  uint32_t radarConfigVersion;
+  int32_t radarScaleQ12;      // Pixels per mm, 20.12 fixed point
   
   // Helper methods for drawing
   void drawStartupScreen();
-  void drawMainScreen(const std::string& deviceId, 
-                      bool t1Present, int t1Distance,
-                      bool t2Present, int t2Distance,
-                      bool t3Present, int t3Distance,
-                      int closestDistance,
-                      int rangeThresholdCm,
-                      bool filterEnabled);
+  void drawMainScreen(const ConfigSnapshot& config, const TargetSnapshot& snapshot);
   void drawAbsentScreen();
+  void renderRadarBackground(const ConfigSnapshot& config);
+  void drawRadarScreen(const ConfigSnapshot& config, const TargetSnapshot& snapshot);
+  bool radarToScreen(int xMm, int yMm, int& px, int& py) const;
   
   String formatDistance(int distanceCm);
   String formatLastSeen(unsigned long lastMeasurementMs);
-  
+
 public:
   DisplayManager(int sdaPin, int sclPin);
   ~DisplayManager();
   
   void init();
   
-  // Main display update - call this in loop with target data
-  void updateDisplay(const std::string& deviceId,
-                     bool t1Present, int t1Distance,
-                     bool t2Present, int t2Distance,
-                     bool t3Present, int t3Distance,
-                     int closestDistance,
-                     int rangeThresholdCm,
-                     bool filterEnabled);
+  // Main display update - call this in loop with target data; shows the
+  // text page or the radar plot depending on config.radarView
+  void updateDisplay(const ConfigSnapshot& config, const TargetSnapshot& snapshot);
+  
+  // Refresh interval, UPDATE_INTERVAL unless the load supervisor slows it down
+  void setUpdateInterval(unsigned long ms) { updateInterval = ms; }
   
   // Update measurement time
   void updateMeasurementTime();
@@ -53,6 +67,9 @@ public:
   
   // Status
   bool shouldUpdate();
+  
+  // Draws the splash screen and returns immediately; updateDisplay() keeps
+  // it up for SPLASH_DURATION or until the first target is present
   void displayStartup();
 };
 
@@ -0,0 +1,375 @@
+#include "EventJournal.h"
+#include "MeshPayload.h"
+#include "Hal.h"
+#include "Crc16.h"
+#include <Preferences.h>
+
+// Global instance
+EventJournal eventJournal;
+
+// Record framing: sync, type, body length, body, CRC-16 over type..body
+static const uint8_t RECORD_SYNC = 0xE5;
+static const size_t RECORD_HEADER_SIZE = 3;
+static const size_t RECORD_CRC_SIZE = 2;
+static const size_t RECORD_MAX_BODY = 16;
+static const size_t RECORD_MAX_SIZE = RECORD_HEADER_SIZE + RECORD_MAX_BODY + RECORD_CRC_SIZE;
+
+// Record types
+static const uint8_t RECORD_SEGMENT = 1;  // First record of a file: generation, acked, next seq
+static const uint8_t RECORD_EVENT = 2;    // seq, boot, uptime ms, target, kind, distance cm
+static const uint8_t RECORD_CURSOR = 3;   // Acked seq after a delivered batch
+
+static const size_t EVENT_BODY_SIZE = 14;
+static const size_t BATCH_HEADER_SIZE = MESH_PAYLOAD_HEADER_SIZE + 13;
+static const size_t BATCH_MAX_EVENT_SIZE = 11;  // Two worst-case varints and the kind byte
+
+static void putU16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+static uint16_t getU16(const uint8_t* in) {
+  return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+EventJournal::EventJournal()
+  : ready(false), boot(0), nextSeq(1), ackedSeq(0), dueSeq(0), activeSegment(0), activeSize(0), olderLastSeq(0),
+    retryAt(0), batchLastSeq(0), batchCount(0), cacheLen(0),
+    appended(0), delivered(0), evicted(0), batches(0), failedBatches(0), skippedBytes(0) {
+  readPos.segment = 0;
+  readPos.offset = 0;
+  batchEnd = readPos;
+  cacheStart = readPos;
+}
+
+// Segments alternate between two files by generation
+void EventJournal::segmentPath(uint32_t segment, char* path) {
+  snprintf(path, 16, "/events%u.log", (unsigned)(segment & 1));
+}
+
+void EventJournal::init() {
+  if (!Hal::fsBegin()) {
+    Serial.println("Journal: file system unavailable - events are not stored");
+    return;
+  }
+  
+  Preferences prefs;
+  prefs.begin("journal", false);
+  boot = (uint16_t)(prefs.getUInt("boot", 0) + 1);
+  prefs.putUInt("boot", boot);
+  prefs.end();
+  
+  scan();
+  ready = activeSegment != 0;
+  Serial.printf("Journal: boot %u, %lu events waiting, next seq %lu\n",
+    boot, (unsigned long)getBacklog(), (unsigned long)nextSeq);
+}
+
+// Rebuild the counters from flash: both segments are read once to find the
+// sequence numbers and the delivery cursor, then once more for the first
+// undelivered event
+void EventJournal::scan() {
+  uint32_t generations[2] = {0, 0};
+  for (uint32_t parity = 0; parity < 2; parity++) {
+    Position pos = {parity, 0};
+    uint8_t type, body[RECORD_MAX_BODY];
+    size_t len;
+    cacheLen = 0;
+    if (readRecord(pos, type, body, len) && type == RECORD_SEGMENT && len >= 12 &&
+        (getU32(body) & 1) == parity) {
+      generations[parity] = getU32(body);
+    }
+  }
+  cacheLen = 0;
+  
+  uint32_t newest = generations[0] > generations[1] ? generations[0] : generations[1];
+  if (newest == 0) {
+    char path[16];
+    for (uint32_t parity = 0; parity < 2; parity++) {
+      segmentPath(parity, path);
+      Hal::fsRemove(path);
+    }
+    startSegment(1);
+    return;
+  }
+  
+  activeSegment = newest;
+  char path[16];
+  segmentPath(activeSegment, path);
+  activeSize = Hal::fsFileSize(path);
+  bool hasOlder = generations[(newest - 1) & 1] == newest - 1;
+  Position start = {hasOlder ? newest - 1 : newest, 0};
+  
+  Position pos = start;
+  uint8_t type, body[RECORD_MAX_BODY];
+  size_t len;
+  while (readRecord(pos, type, body, len)) {
+    if (type == RECORD_SEGMENT && len >= 12) {
+      if (getU32(body + 4) > ackedSeq) ackedSeq = getU32(body + 4);
+      if (getU32(body + 8) > nextSeq) nextSeq = getU32(body + 8);
+    } else if (type == RECORD_CURSOR && len >= 4) {
+      if (getU32(body) > ackedSeq) ackedSeq = getU32(body);
+    } else if (type == RECORD_EVENT && len >= EVENT_BODY_SIZE) {
+      uint32_t seq = getU32(body);
+      if (seq >= nextSeq) nextSeq = seq + 1;
+      if (pos.segment != activeSegment) olderLastSeq = seq;
+    }
+  }
+  if (ackedSeq >= nextSeq) ackedSeq = nextSeq - 1;
+  dueSeq = nextSeq - 1;
+  
+  // First record of an undelivered event
+  readPos = start;
+  pos = start;
+  Position recordPos = pos;
+  while (readRecord(pos, type, body, len)) {
+    if (type == RECORD_EVENT && len >= EVENT_BODY_SIZE && getU32(body) > ackedSeq) {
+      readPos = recordPos;
+      return;
+    }
+    recordPos = pos;
+  }
+  readPos = pos;
+}
+
+bool EventJournal::startSegment(uint32_t segment) {
+  char path[16];
+  segmentPath(segment, path);
+  Hal::fsRemove(path);
+  activeSegment = segment;
+  activeSize = 0;
+  cacheLen = 0;
+  
+  uint8_t body[12];
+  putU32(body, segment);
+  putU32(body + 4, ackedSeq);
+  putU32(body + 8, nextSeq);
+  return appendRecord(RECORD_SEGMENT, body, sizeof(body));
+}
+
+bool EventJournal::appendRecord(uint8_t type, const uint8_t* body, size_t len) {
+  uint8_t record[RECORD_MAX_SIZE];
+  size_t size = RECORD_HEADER_SIZE + len + RECORD_CRC_SIZE;
+  
+  // Full segment: the older one goes, oldest events first
+  if (type != RECORD_SEGMENT && activeSize + size > JOURNAL_SEGMENT_BYTES) {
+    uint32_t lastSeq = nextSeq - 1;
+    if (ackedSeq < olderLastSeq) {
+      evicted += olderLastSeq - ackedSeq;
+      Serial.printf("Journal: full, %lu undelivered events evicted\n",
+        (unsigned long)(olderLastSeq - ackedSeq));
+      ackedSeq = olderLastSeq;
+    }
+    if (readPos.segment < activeSegment) {
+      readPos.segment = activeSegment;
+      readPos.offset = 0;
+    }
+    olderLastSeq = lastSeq;
+    if (!startSegment(activeSegment + 1)) return false;
+  }
+  
+  record[0] = RECORD_SYNC;
+  record[1] = type;
+  record[2] = (uint8_t)len;
+  memcpy(record + RECORD_HEADER_SIZE, body, len);
+  putU16(record + RECORD_HEADER_SIZE + len, crc16(record + 1, 2 + len));
+  
+  char path[16];
+  segmentPath(activeSegment, path);
+  if (!Hal::fsAppend(path, record, size)) return false;
+  activeSize += size;
+  return true;
+}
+
+bool EventJournal::append(int target, JournalEventKind kind, int distanceCm, unsigned long now) {
+  if (!ready) return false;
+  
+  uint8_t body[EVENT_BODY_SIZE];
+  putU32(body, nextSeq);
+  putU16(body + 4, boot);
+  putU32(body + 6, (uint32_t)now);
+  body[10] = (uint8_t)target;
+  body[11] = kind;
+  putU16(body + 12, distanceCm > 0 ? (uint16_t)distanceCm : 0);
+  if (!appendRecord(RECORD_EVENT, body, sizeof(body))) {
+    Serial.println("Journal: write failed");
+    return false;
+  }
+  
+  if (kind != EVENT_ALERT) dueSeq = nextSeq;
+  nextSeq++;
+  appended++;
+  return true;
+}
+
+size_t EventJournal::readAt(const Position& pos, uint8_t* out, size_t len) {
+  bool cached = pos.segment == cacheStart.segment && pos.offset >= cacheStart.offset &&
+                pos.offset + len <= cacheStart.offset + cacheLen;
+  if (!cached) {
+    char path[16];
+    segmentPath(pos.segment, path);
+    cacheStart = pos;
+    cacheLen = Hal::fsRead(path, pos.offset, cache, sizeof(cache));
+  }
+  size_t skip = pos.offset - cacheStart.offset;
+  size_t n = cacheLen > skip ? cacheLen - skip : 0;
+  if (n > len) n = len;
+  memcpy(out, cache + skip, n);
+  return n;
+}
+
+// Next intact record at or after pos, in generation order; pos moves past it.
+// False at the end of the active segment
+bool EventJournal::readRecord(Position& pos, uint8_t& type, uint8_t* body, size_t& len) {
+  while (true) {
+    uint8_t record[RECORD_MAX_SIZE];
+    size_t n = readAt(pos, record, sizeof(record));
+    
+    // End of a segment: continue in the next generation
+    if (n < RECORD_HEADER_SIZE + RECORD_CRC_SIZE) {
+      if (pos.segment >= activeSegment || activeSegment == 0) return false;
+      pos.segment++;
+      pos.offset = 0;
+      continue;
+    }
+    
+    // Not a record start: resynchronise on the next sync byte
+    if (record[0] != RECORD_SYNC || record[2] > RECORD_MAX_BODY) {
+      skippedBytes++;
+      pos.offset++;
+      continue;
+    }
+    
+    // A record cut short by a power loss ends the segment
+    size_t size = RECORD_HEADER_SIZE + record[2] + RECORD_CRC_SIZE;
+    if (n < size) {
+      if (pos.segment >= activeSegment) return false;
+      pos.segment++;
+      pos.offset = 0;
+      continue;
+    }
+    
+    if (crc16(record + 1, 2 + record[2]) != getU16(record + RECORD_HEADER_SIZE + record[2])) {
+      skippedBytes++;
+      pos.offset++;
+      continue;
+    }
+    
+    type = record[1];
+    len = record[2];
+    memcpy(body, record + RECORD_HEADER_SIZE, len);
+    pos.offset += size;
+    return true;
+  }
+}
+
+bool EventJournal::drainDue(unsigned long now) const {
+  if (!ready || (long)(now - retryAt) < 0) return false;
+  return dueSeq > ackedSeq || getBacklog() >= JOURNAL_BATCH_EVENTS;
+}
+
+size_t EventJournal::encodeBatch(uint8_t* out, size_t cap, unsigned long now) {
+  if (!ready || getBacklog() == 0 || cap < BATCH_HEADER_SIZE + BATCH_MAX_EVENT_SIZE) return 0;
+  
+  size_t len = BATCH_HEADER_SIZE;
+  uint16_t eventBoot = 0;
+  uint32_t firstSeq = 0, lastSeq = 0, lastTime = 0;
+  uint8_t count = 0;
+  
+  Position pos = readPos;
+  Position recordPos = pos;
+  uint8_t type, body[RECORD_MAX_BODY];
+  size_t bodyLen;
+  while (count < JOURNAL_BATCH_EVENTS && readRecord(pos, type, body, bodyLen)) {
+    if (type != RECORD_EVENT || bodyLen < EVENT_BODY_SIZE || getU32(body) <= ackedSeq) {
+      recordPos = pos;
+      continue;
+    }
+    
+    // One boot and consecutive sequence numbers per batch
+    uint32_t seq = getU32(body);
+    uint16_t recordBoot = getU16(body + 4);
+    if (count > 0 && (recordBoot != eventBoot || seq != lastSeq + 1)) {
+      pos = recordPos;
+      break;
+    }
+    if (len + BATCH_MAX_EVENT_SIZE > cap) {
+      pos = recordPos;
+      break;
+    }
+    
+    uint32_t time = getU32(body + 6);
+    if (count == 0) {
+      eventBoot = recordBoot;
+      firstSeq = seq;
+      payloadPutVarint(out, len, cap, time);
+    } else {
+      payloadPutVarint(out, len, cap, time - lastTime);
+    }
+    out[len++] = (uint8_t)((body[11] << 2) | (body[10] & 0x03));
+    payloadPutVarint(out, len, cap, getU16(body + 12));
+    
+    lastSeq = seq;
+    lastTime = time;
+    count++;
+    recordPos = pos;
+  }
+  
+  // The backlog is gone from flash (corrupt records): count it as lost
+  if (count == 0) {
+    evicted += getBacklog();
+    ackedSeq = nextSeq - 1;
+    readPos = pos;
+    return 0;
+  }
+  
+  out[0] = MESH_PAYLOAD_VERSION;
+  out[1] = MSG_EVENTS;
+  putU16(out + 2, eventBoot);
+  putU32(out + 4, firstSeq);
+  putU16(out + 8, boot);
+  putU32(out + 10, (uint32_t)now);
+  out[14] = count;
+  
+  batchEnd = pos;
+  batchLastSeq = lastSeq;
+  batchCount = count;
+  return len;
+}
+
+void EventJournal::batchDone(bool wasDelivered, unsigned long now) {
+  if (!wasDelivered) {
+    failedBatches++;
+    retryAt = now + JOURNAL_RETRY_MS;
+    return;
+  }
+  
+  batches++;
+  delivered += batchCount;
+  if (batchLastSeq > ackedSeq) {
+    ackedSeq = batchLastSeq;
+    if (batchEnd.segment + 1 >= activeSegment) readPos = batchEnd;
+  }
+  
+  uint8_t body[4];
+  putU32(body, ackedSeq);
+  appendRecord(RECORD_CURSOR, body, sizeof(body));
+}
+
+void EventJournal::printStatus() const {
+  if (!ready) return;
+  Serial.printf("Journal: %lu events, %lu waiting, %lu delivered in %lu batches (%lu failed), "
+                "%lu evicted, %lu bytes skipped, segment %lu at %lu B\n",
+    appended, (unsigned long)getBacklog(), delivered, batches, failedBatches,
+    evicted, skippedBytes, (unsigned long)activeSegment, (unsigned long)activeSize);
+}
@@ -0,0 +1,111 @@
+#ifndef EVENTJOURNAL_H
+#define EVENTJOURNAL_H
+
+#include <Arduino.h>
+
+// Size of each of the two journal segments; together they bound the flash used
+static constexpr size_t JOURNAL_SEGMENT_BYTES = 32 * 1024;
+
+// Events per MSG_EVENTS batch (at most 8 bytes each on the air)
+static constexpr size_t JOURNAL_BATCH_EVENTS = 24;
+
+// Pause after a batch that was not delivered
+static constexpr unsigned long JOURNAL_RETRY_MS = 30000;
+
+enum JournalEventKind : uint8_t {
+  EVENT_EXIT = 0,
+  EVENT_ENTRY = 1,
+  EVENT_ALERT = 2      // Safety zone entry (actual or predicted)
+};
+
+// Store-and-forward log of presence events in flash.
+//
+// Every event is appended to a LittleFS file as a CRC-framed record before
+// anything is sent, with its sequence number, boot number and uptime. The
+// journal is drained to the mesh in order as MSG_EVENTS batches, the next
+// batch only after the previous one was delivered, so an unplugged or
+// congested radio delays events instead of losing them. Delivery progress is
+// journaled too (cursor records), nothing is rewritten in place, and after a
+// reboot the drain resumes where it stopped. Two segment files alternate:
+// when the active one is full the older one is deleted, with any events it
+// still held, and a new one started, so flash use is bounded and eviction is
+// oldest first. A record torn by a power loss fails its CRC and is skipped.
+class EventJournal {
+private:
+  // Record location: segment generation and byte offset in its file
+  struct Position {
+    uint32_t segment;
+    uint32_t offset;
+  };
+  
+  bool ready;
+  uint16_t boot;               // Power-ups so far, from NVS
+  uint32_t nextSeq;            // Sequence number of the next event
+  uint32_t ackedSeq;           // Everything up to here was delivered or evicted
+  uint32_t dueSeq;             // Last entry or exit; alerts ride along with the next one
+  uint32_t activeSegment;      // Generation of the segment being appended to
+  uint32_t activeSize;
+  uint32_t olderLastSeq;       // Last event in the older segment
+  Position readPos;            // Where the next batch starts
+  unsigned long retryAt;
+  
+  // Batch handed out by encodeBatch(), committed by batchDone()
+  Position batchEnd;
+  uint32_t batchLastSeq;
+  uint8_t batchCount;
+  
+  // Read cache, one flash read serves several records
+  uint8_t cache[256];
+  Position cacheStart;
+  size_t cacheLen;
+  
+  unsigned long appended;
+  unsigned long delivered;
+  unsigned long evicted;
+  unsigned long batches;
+  unsigned long failedBatches;
+  unsigned long skippedBytes;      // Corrupt data passed over while reading
+  
+  // Helper functions
+  static void segmentPath(uint32_t segment, char* path);
+  bool appendRecord(uint8_t type, const uint8_t* body, size_t len);
+  bool startSegment(uint32_t segment);
+  size_t readAt(const Position& pos, uint8_t* out, size_t len);
+  bool readRecord(Position& pos, uint8_t& type, uint8_t* body, size_t& len);
+  void scan();
+
+public:
+  EventJournal();
+  
+  // Mount the file system and resume from the journal in flash
+  void init();
+  bool isReady() const { return ready; }
+  
+  // Record one event; false if it could not be written
+  bool append(int target, JournalEventKind kind, int distanceCm, unsigned long now);
+  
+  // Events not delivered yet
+  uint32_t getBacklog() const { return nextSeq - 1 - ackedSeq; }
+  
+  // A batch should go out: an entry or exit (or a full batch) is waiting and
+  // no retry pause is running. Entries and exits are not held back for
+  // fuller batches; batches fill up while the previous one waits for its ACK
+  // or the radio is away. Alerts already went out as presence reports, so
+  // they wait for the next batch
+  bool drainDue(unsigned long now) const;
+  
+  // Encode the next MSG_EVENTS batch (see MeshPayload.h). Returns the
+  // encoded length, 0 if there is nothing to send or cap is too small.
+  // Nothing is consumed until batchDone(true)
+  size_t encodeBatch(uint8_t* out, size_t cap, unsigned long now);
+  
+  // Outcome of the last encoded batch
+  void batchDone(bool wasDelivered, unsigned long now);
+  
+  // Status
+  void printStatus() const;
+};
+
+extern EventJournal eventJournal;
+
+#endif // EVENTJOURNAL_H
@@ -0,0 +1,157 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <stddef.h>
+#include "ConfigManager.h"
+
+// Per-beacon smoothing filters. Both are allocation-free templates with
+// O(1) work per sample, sized at compile time so a DeviceInfo can live in
+// the fixed beacon table. Each has an explicit-parameter update for callers
+// that already hold the settings, a convenience variant that reads them
+// from ConfigManager, and a batch entry point for queued advertisements.
+
+// Upper bound for the window_size setting (2-20)
+static constexpr size_t MOVING_AVERAGE_MAX_WINDOW = 20;
+
+//========================= Kalman =========================
+// Scalar Kalman filter for a quantity assumed constant between samples
+template <typename T>
+class Kalman {
+private:
+  T estimate;
+  T errorCovariance;
+
+public:
+  explicit Kalman(T initial = 0, T initialError = 1)
+    : estimate(initial), errorCovariance(initialError) {}
+  
+  void reset(T initial, T initialError = 1) {
+    estimate = initial;
+    errorCovariance = initialError;
+  }
+  
+  T update(T measurement, T processNoise, T measurementNoise) {
+    errorCovariance += processNoise;
+    T gain = errorCovariance / (errorCovariance + measurementNoise);
+    estimate += gain * (measurement - estimate);
+    errorCovariance -= gain * errorCovariance;
+    return estimate;
+  }
+  
+  T update(T measurement) {
+    return update(measurement, (T)ConfigManager::getProcessNoise(),
+                  (T)ConfigManager::getMeasurementNoise());
+  }
+  
+  // Feed n samples in arrival order, returns the final estimate
+  T updateBatch(const T* measurements, size_t n, T processNoise, T measurementNoise) {
+    for (size_t i = 0; i < n; i++) {
+      update(measurements[i], processNoise, measurementNoise);
+    }
+    return estimate;
+  }
+  
+  T updateBatch(const T* measurements, size_t n) {
+    return updateBatch(measurements, n, (T)ConfigManager::getProcessNoise(),
+                       (T)ConfigManager::getMeasurementNoise());
+  }
+  
+  T getEstimate() const { return estimate; }
+  T getErrorCovariance() const { return errorCovariance; }
+};
+
+//========================= Moving average =========================
+// Mean of the last `window` samples (1..MAX_WINDOW) from a ring of
+// MAX_WINDOW. A running sum makes each sample O(1). For floating point it
+// is recomputed from the ring once per wrap, so rounding cannot build up
+// (amortised at most one extra add per sample)
+template <typename T, size_t MAX_WINDOW>
+class MovingAverage {
+  static_assert(MAX_WINDOW > 0, "MovingAverage needs a window");
+
+private:
+  T samples[MAX_WINDOW];
+  T sum;
+  size_t head;      // Next slot to write
+  size_t count;     // Samples in the active window
+  size_t stored;    // Valid samples in the ring
+  size_t window;    // Active length
+  
+  size_t ago(size_t n) const { return (head + MAX_WINDOW - n) % MAX_WINDOW; }
+  
+  void resum() {
+    sum = 0;
+    for (size_t i = 1; i <= count; i++) {
+      sum += samples[ago(i)];
+    }
+  }
+
+public:
+  explicit MovingAverage(size_t activeWindow = MAX_WINDOW)
+    : sum(0), head(0), count(0), stored(0), window(1) {
+    for (T& sample : samples) {
+      sample = 0;
+    }
+    setWindow(activeWindow);
+  }
+  
+  void reset() {
+    sum = 0;
+    head = 0;
+    count = 0;
+    stored = 0;
+  }
+  
+  // Clamped to 1..MAX_WINDOW. Shrinking keeps the newest samples, growing
+  // starts from what is still in the ring
+  void setWindow(size_t n) {
+    if (n < 1) n = 1;
+    if (n > MAX_WINDOW) n = MAX_WINDOW;
+    if (n == window) return;
+    window = n;
+    count = stored < window ? stored : window;
+    resum();
+  }
+  
+  T add(T sample) {
+    if (count == window) {
+      sum -= samples[ago(window)];
+    } else {
+      count++;
+    }
+    if (stored < MAX_WINDOW) stored++;
+    samples[head] = sample;
+    sum += sample;
+    head = (head + 1) % MAX_WINDOW;
+    if (head == 0) resum();
+    return average();
+  }
+  
+  T add(T sample, size_t activeWindow) {
+    setWindow(activeWindow);
+    return add(sample);
+  }
+  
+  // Window from ConfigManager::getWindowSize()
+  T addConfigured(T sample) {
+    return add(sample, (size_t)ConfigManager::getWindowSize());
+  }
+  
+  // Feed n samples in arrival order, returns the final average
+  T addBatch(const T* batch, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      add(batch[i]);
+    }
+    return average();
+  }
+  
+  T average() const { return count ? sum / (T)count : 0; }
+  size_t size() const { return count; }
+  size_t getWindow() const { return window; }
+  static constexpr size_t maxWindow() { return MAX_WINDOW; }
+};
+
+typedef Kalman<float> KalmanFilter;
+typedef MovingAverage<float, MOVING_AVERAGE_MAX_WINDOW> MovingAverageFilter;
+
+#endif // FILTERS_H
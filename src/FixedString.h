@@ -0,0 +1,66 @@
+#ifndef FIXEDSTRING_H
+#define FIXEDSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Bounded string stored inline - no heap allocation, trivially copyable.
+//
+// Used for configured identifiers (device name, magic word, gateway ID) that
+// live for the whole uptime and are compared or copied on every command.
+// assign() rejects values longer than N instead of truncating them, so the
+// command that tried to set one can report the error.
+template <size_t N>
+class FixedString {
+  static_assert(N > 0 && N < 256, "FixedString capacity must fit the length byte");
+
+private:
+  char buf[N + 1];
+  uint8_t len;
+
+public:
+  FixedString() : len(0) { buf[0] = '\0'; }
+  FixedString(const char* s) : len(0) {
+    buf[0] = '\0';
+    assign(s);
+  }
+  
+  static constexpr size_t capacity() { return N; }
+  
+  // Returns false (and keeps the old value) if s does not fit
+  bool assign(const char* s, size_t n) {
+    if (n > N) {
+      return false;
+    }
+    memmove(buf, s, n);
+    buf[n] = '\0';
+    len = (uint8_t)n;
+    return true;
+  }
+  bool assign(const char* s) { return s ? assign(s, strlen(s)) : assign("", 0); }
+  
+  const char* c_str() const { return buf; }
+  size_t length() const { return len; }
+  bool empty() const { return len == 0; }
+  void clear() { assign("", 0); }
+  
+  bool equals(const char* s, size_t n) const { return n == len && memcmp(buf, s, n) == 0; }
+  bool operator==(const char* s) const { return s && equals(s, strlen(s)); }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  template <size_t M>
+  bool operator==(const FixedString<M>& other) const { return equals(other.c_str(), other.length()); }
+  template <size_t M>
+  bool operator!=(const FixedString<M>& other) const { return !(*this == other); }
+};
+
+// Identifier limits, checked where commands set them
+static constexpr size_t DEVICE_NAME_MAX_LEN = 32;    // Also the MSG_PRESENCE/MSG_SUMMARY name limit
+static constexpr size_t MAGIC_WORD_MAX_LEN = 16;
+static constexpr size_t GATEWAY_ID_MAX_LEN = 32;
+
+typedef FixedString<DEVICE_NAME_MAX_LEN> DeviceName;
+typedef FixedString<MAGIC_WORD_MAX_LEN> MagicWord;
+typedef FixedString<GATEWAY_ID_MAX_LEN> GatewayId;
+
+#endif // FIXEDSTRING_H
@@ -0,0 +1,93 @@
+#include "Hal.h"
+
+// ESP32 implementation - the native simulation provides its own (sim/src)
+#ifndef MESHWAVE_NATIVE_SIM
+
+#include <NimBLEDevice.h>
+#include <LittleFS.h>
+
+unsigned long Hal::millis() {
+  return ::millis();
+}
+
+unsigned long Hal::micros() {
+  return ::micros();
+}
+
+void Hal::delay(unsigned long ms) {
+  ::delay(ms);
+}
+
+HardwareSerial& Hal::radarUart() {
+  return Serial2;
+}
+
+HardwareSerial& Hal::meshUart() {
+  return Serial1;
+}
+
+// Forwards scan results; the scan itself keeps none (setMaxResults(0))
+class AdvertisementForwarder : public NimBLEAdvertisedDeviceCallbacks {
+private:
+  Hal::BleAdvertisementHandler handler;
+
+public:
+  explicit AdvertisementForwarder(Hal::BleAdvertisementHandler h) : handler(h) {}
+  
+  void onResult(NimBLEAdvertisedDevice* device) override {
+    handler((uint64_t)device->getAddress(), device->getRSSI());
+  }
+};
+
+bool Hal::startBleScan(BleAdvertisementHandler handler, uint16_t intervalMs, uint16_t windowMs, bool active) {
+  static AdvertisementForwarder* forwarder = nullptr;
+  if (forwarder) return false;  // Already scanning
+  
+  NimBLEDevice::init("");
+  forwarder = new AdvertisementForwarder(handler);
+  
+  NimBLEScan* scan = NimBLEDevice::getScan();
+  scan->setAdvertisedDeviceCallbacks(forwarder, true);  // Report duplicates
+  scan->setMaxResults(0);
+  scan->setInterval(intervalMs);
+  scan->setWindow(windowMs);
+  scan->setActiveScan(active);
+  
+  // Duration 0 with a completion callback: runs until stopped, returns at once
+  return scan->start(0, nullptr, false);
+}
+
+bool Hal::fsBegin() {
+  return LittleFS.begin(true);
+}
+
+size_t Hal::fsFileSize(const char* path) {
+  if (!LittleFS.exists(path)) return 0;
+  File file = LittleFS.open(path, "r");
+  if (!file) return 0;
+  size_t size = file.size();
+  file.close();
+  return size;
+}
+
+bool Hal::fsAppend(const char* path, const uint8_t* data, size_t len) {
+  File file = LittleFS.open(path, "a");
+  if (!file) return false;
+  size_t written = file.write(data, len);
+  file.close();
+  return written == len;
+}
+
+size_t Hal::fsRead(const char* path, size_t offset, uint8_t* out, size_t len) {
+  File file = LittleFS.open(path, "r");
+  if (!file) return 0;
+  size_t n = file.seek(offset) ? file.read(out, len) : 0;
+  file.close();
+  return n;
+}
+
+bool Hal::fsRemove(const char* path) {
+  return !LittleFS.exists(path) || LittleFS.remove(path);
+}
+
+#endif // MESHWAVE_NATIVE_SIM
@@ -0,0 +1,41 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+// Thin hardware abstraction for the parts of the board the managers touch.
+// On the ESP32 (Hal.cpp) these map straight onto the Arduino core. The native
+// simulation (sim/) provides a virtual clock and in-memory UARTs instead, so
+// the same manager code can be replayed on Linux faster than real time.
+namespace Hal {
+
+// Clock
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// UART2 - LD2450 radar sensor
+HardwareSerial& radarUart();
+
+// UART1 - Meshtastic node
+HardwareSerial& meshUart();
+
+// BLE - continuous scan that never stops on its own. The handler is called
+// from the BLE host task for every advertisement, duplicates included, so it
+// must only copy what it needs and return. The address is packed with the
+// first octet of its text form in bits 40-47
+typedef void (*BleAdvertisementHandler)(uint64_t address, int rssi);
+bool startBleScan(BleAdvertisementHandler handler, uint16_t intervalMs, uint16_t windowMs, bool active);
+
+// Flash file system (LittleFS) for the event journal. fsBegin() mounts it,
+// formatting a partition that cannot be mounted. Files are only ever
+// appended to, read at an offset or removed as a whole
+bool fsBegin();
+size_t fsFileSize(const char* path);   // 0 if missing
+bool fsAppend(const char* path, const uint8_t* data, size_t len);
+size_t fsRead(const char* path, size_t offset, uint8_t* out, size_t len);
+bool fsRemove(const char* path);
+
+}  // namespace Hal
+
+#endif // HAL_H
@@ -1,45 +1,88 @@
 #include "LD2450Manager.h"
+#include "Config.h"
+#include "Hal.h"
+#include "MeshFragment.h"
+#include "MeshPayload.h"
 #include <ArduinoJson.h>
 #include <Preferences.h>
 
 // Global instance
 LD2450Manager ld2450Manager;
 
+// A re-entry this soon after a reported exit counts as a flap
+static const unsigned long FLAP_WINDOW_MS = 10000;
+
+// Radial speed (towards the sensor) that counts as approaching
+static const int APPROACH_MIN_SPEED_CMS = 15;
+
 LD2450Manager::LD2450Manager() 
-  : lastReadTime(0), sensorInitialized(false), closestDistanceCm(600), bufferPos(0) {
+  : lastReadTime(0), sensorInitialized(false), firstFrameSeen(false), firstFrameTime(0), lastFrameTime(0),
+    bufferPos(0), lastParseUs(0) {
   loadDefaultConfig();
+  publishConfig();
+  memset(&lastFrame, 0, sizeof(lastFrame));
   
   // Initialize all targets
-  for (int i = 0; i < 3; i++) {
-    targets[i].state = ABSENT;
-    targets[i].previousState = ABSENT;
-    targets[i].stateChangeTime = 0;
-    targets[i].lastX = 0;
-    targets[i].lastY = 0;
-    targets[i].lastSpeed = 0;
-    targets[i].lastDistance = 0;
-    targets[i].valid = false;
-    targets[i].stateChanged = false;
+  for (TargetInfo& target : snapshot.targets) {
+    target.state = ABSENT;
+    target.previousState = ABSENT;
+    target.stateChangeTime = 0;
+    target.lastX = 0;
+    target.lastY = 0;
+    target.lastSpeed = 0;
+    target.lastDistance = 0;
+    target.valid = false;
+    target.stateChanged = false;
+    target.hitFrames = 0;
+    target.missFrames = 0;
+    target.lastSeenTime = 0;
+    target.lastAbsentTime = 0;
+    target.holding = false;
+    target.approachFrames = 0;
+    target.timeToZoneDs = 0xFF;
+    target.fastConfirms = 0;
+    target.rejectedEntries = 0;
+    target.absorbedDropouts = 0;
+    target.flaps = 0;
   }
+  
+  snapshot.closestDistanceCm = 600;
+  snapshot.presentCount = 0;
+  snapshot.anyStateChanged = false;
+  snapshot.frameCount = 0;
+  
+  publishedSnapshot.write(snapshot);
 }
 
 void LD2450Manager::loadDefaultConfig() {
   config.rangeMaxCm = 300;
   config.debounceMs = 2500;
+  config.enterFrames = 3;
+  config.exitMs = 1500;
+  config.exitFrames = 10;
+  config.summaryWindowS = 300;
+  config.alertDistanceCm = 100;
+  config.trackBudgetBpm = 0;
+  config.trackToleranceCm = 30;
+  config.predictEnable = false;
+  config.fastEnterMs = 500;
   config.filterEnable = true;
   config.sensorEnable = true;
-  config.deviceName = "LD2450_A";
-  config.magicWord = "LD2450";
+  config.radarView = false;
+  config.telemetryEnable = false;
+  config.deviceName.assign("LD2450_A");
+  config.magicWord.assign("LD2450");
 }
 
 void LD2450Manager::init() {
   // Load config from NVS first (if exists)
   loadFromNVS();
+  publishConfig();
   
   // Initialize UART2 for LD2450 (256000 baud)
   // RX = GPIO8, TX = GPIO9
-  Serial2.begin(256000, SERIAL_8N1, 8, 9);
-  delay(500);
+  // The parser resynchronises on the frame header, so no settle delay is needed
+  Hal::radarUart().begin(LD2450_BAUD_RATE, SERIAL_8N1, LD2450_RX_PIN, LD2450_TX_PIN);
   
   bufferPos = 0;
   sensorInitialized = true;
@@ -52,248 +95,367 @@ void LD2450Manager::printConfig() {
   Serial.printf("Device Name: %s\n", config.deviceName.c_str());
   Serial.printf("Magic Word: %s\n", config.magicWord.c_str());
   Serial.printf("Detection Range: %d cm\n", config.rangeMaxCm);
-  Serial.printf("Debounce Time: %lu ms\n", config.debounceMs);
+  Serial.printf("Enter Hold: %lu ms / %u frames\n", config.debounceMs, config.enterFrames);
+  Serial.printf("Exit Hold: %lu ms / %u frames\n", config.exitMs, config.exitFrames);
+  if (config.predictEnable) {
+    Serial.printf("Approach Prediction: Enabled (enter hold %lu ms)\n", config.fastEnterMs);
+  } else {
+    Serial.println("Approach Prediction: Disabled");
+  }
+  if (config.summaryWindowS > 0) {
+    Serial.printf("Reporting: summary every %u s\n", config.summaryWindowS);
+  } else {
+    Serial.println("Reporting: every state change");
+  }
+  Serial.printf("Safety Alert Distance: %d cm\n", config.alertDistanceCm);
+  if (config.trackBudgetBpm > 0) {
+    Serial.printf("Trajectories: %u bytes/min, tolerance %d cm\n", config.trackBudgetBpm, config.trackToleranceCm);
+  } else {
+    Serial.println("Trajectories: Disabled");
+  }
   Serial.printf("Filter: %s\n", config.filterEnable ? "Enabled" : "Disabled");
   Serial.printf("Sensor: %s\n", config.sensorEnable ? "Enabled" : "Disabled");
+  Serial.printf("Display: %s\n", config.radarView ? "radar plot" : "text");
+  Serial.printf("USB Output: %s\n", config.telemetryEnable ? "binary telemetry" : "text log");
   Serial.println("============================\n");
 }
 
 bool LD2450Manager::readSensor() {
-  if (!sensorInitialized || !config.sensorEnable) {
+  if (!sensorInitialized || !getConfig().sensorEnable) {
     return false;
   }
   
-  lastReadTime = millis();
+  lastReadTime = Hal::millis();
   
   // Read all available bytes from UART2
-  while (Serial2.available()) {
-    uint8_t byte = Serial2.read();
+  while (Hal::radarUart().available()) {
+    uint8_t byte = Hal::radarUart().read();
+    
+    // Collect bytes until we have a complete frame
+    frameBuffer[bufferPos++] = byte;
+    if (bufferPos < (int)LD2450Proto::FRAME_SIZE) {
+      continue;
+    }
     
-    // Collect bytes until we have a complete frame (30 bytes)
-    if (bufferPos < 30) {
-      frameBuffer[bufferPos] = byte;
-      bufferPos++;
+    if (LD2450Proto::isFrame(frameBuffer)) {
+      // Valid frame - decode all targets, then run them through the state machine
+      unsigned long parseStart = Hal::micros();
+      lastFrameTime = Hal::millis();
+      LD2450Proto::decodeFrame(frameBuffer, lastFrame);
+      int validCount = parseFrame(lastFrame);
+      bufferPos = 0;
       
-      // Check if we have a complete frame
-      if (bufferPos == 30) {
-        // Validate: Header at 0-3, Footer at 28-29
-        if (frameBuffer[0] == 0xAA && frameBuffer[1] == 0xFF &&
-            frameBuffer[2] == 0x03 && frameBuffer[3] == 0x00 &&
-            frameBuffer[28] == 0x55 && frameBuffer[29] == 0xCC) {
-          
-          // Valid frame - parse it
-          int validCount = parseFrame(frameBuffer);
-          bufferPos = 0;
-          
-          // Calculate closest distance
-          closestDistanceCm = 600;
-          for (int i = 0; i < 3; i++) {
-            if (targets[i].valid && targets[i].state == PRESENT) {
-              int dist = targets[i].lastDistance;
-              if (dist > 0 && dist < closestDistanceCm) {
-                closestDistanceCm = dist;
-              }
-            }
-          }
-          
-          return validCount > 0;
-        } else {
-          // Invalid frame - shift buffer and try again
-          for (int i = 0; i < 29; i++) {
-            frameBuffer[i] = frameBuffer[i + 1];
-          }
-          bufferPos = 29;
-        }
+      updateSnapshotSummary();
+      publishedSnapshot.write(snapshot);
+      lastParseUs = Hal::micros() - parseStart;
+      
+      if (!firstFrameSeen) {
+        firstFrameSeen = true;
+        firstFrameTime = Hal::millis();
+        Serial.printf("LD2450: first valid frame %lu ms after boot\n", firstFrameTime);
       }
+      
+      return validCount > 0;
     }
+    
+    // Invalid frame - shift buffer and try again
+    memmove(frameBuffer, frameBuffer + 1, LD2450Proto::FRAME_SIZE - 1);
+    bufferPos = LD2450Proto::FRAME_SIZE - 1;
   }
   
+  // No complete frame this pass - exit holds still run on the clock
+  expireSilentHolds(getConfig(), lastReadTime);
   return false;
 }
 
-// Helper function: Decode coordinate with special sign bit encoding
-// Bit 7 of high byte = sign bit (0=negative, 1=positive)
-// Bits 0-6 of high byte + all of low byte = magnitude
-int16_t LD2450Manager::decodeCoordinate(uint8_t lowByte, uint8_t highByte) {
-  // Extract magnitude: (highByte & 0x7F) << 8 | lowByte
-  int16_t magnitude = ((highByte & 0x7F) << 8) | lowByte;
-  
-  // Check sign bit (Bit 7 of high byte)
-  // If Bit 7 = 0 → negative, if Bit 7 = 1 → positive
-  if ((highByte & 0x80) == 0) {
-    return -magnitude;
-  }
-  return magnitude;
-}
-
-// Helper function: Decode speed with sign bit encoding
-// Identical to coordinate decoding
-// Bit 7 of high byte = direction (0=moving away, 1=approaching)
-int16_t LD2450Manager::decodeSpeed(uint8_t lowByte, uint8_t highByte) {
-  int16_t magnitude = ((highByte & 0x7F) << 8) | lowByte;
-  
-  // If Bit 7 = 0 → moving away (negative)
-  // If Bit 7 = 1 → approaching (positive)
-  if ((highByte & 0x80) == 0) {
-    return -magnitude;
-  }
-  return magnitude;
-}
-
-int LD2450Manager::parseFrame(uint8_t* frame) {
+// Run the decoded targets of one frame through the state machine
+// (layout and sign-bit decoding: LD2450Proto.h)
+int LD2450Manager::parseFrame(const LD2450Proto::Frame& frame) {
+  const ConfigSnapshot& cfg = getConfig();
   int validCount = 0;
   
-  // Frame structure (30 bytes):
-  // Byte 0-3:   Header (0xAA 0xFF 0x03 0x00)
-  // Byte 4-11:  Target 1 (8 bytes)
-  // Byte 12-19: Target 2 (8 bytes)
-  // Byte 20-27: Target 3 (8 bytes)
-  // Byte 28-29: Footer (0x55 0xCC)
-  //
-  // Target structure (8 bytes):
-  // Byte 0-1: X Position (ESPHome special sign-bit encoding)
-  // Byte 2-3: Y Position (ESPHome special sign-bit encoding)
-  // Byte 4-5: Speed (ESPHome special sign-bit encoding)
-  // Byte 6-7: Resolution (standard little-endian unsigned)
-  
-  for (int i = 0; i < 3; i++) {
-    // Calculate base offset for this target
-    int baseOffset = 4 + (i * 8);  // 4, 12, 20
-    
-    // X Position (baseOffset+0, baseOffset+1)
-    // CORRECT: Use ESPHome decoding with Bit 7 = sign bit
-    int16_t x = decodeCoordinate(frame[baseOffset + 0], frame[baseOffset + 1]);
-    
-    // Y Position (baseOffset+2, baseOffset+3)
-    int16_t y = decodeCoordinate(frame[baseOffset + 2], frame[baseOffset + 3]);
-    
-    // Speed (baseOffset+4, baseOffset+5)
-    // CORRECT: Use ESPHome decoding with Bit 7 = direction
-    int16_t speed = decodeSpeed(frame[baseOffset + 4], frame[baseOffset + 5]);
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    TargetInfo& target = snapshot.targets[i];
+    int16_t x = frame.targets[i].x;
+    int16_t y = frame.targets[i].y;
+    int16_t speed = frame.targets[i].speed;
     
-    // Resolution (baseOffset+6, baseOffset+7) - Standard little-endian unsigned
-    uint16_t resolution = frame[baseOffset + 6] | (frame[baseOffset + 7] << 8);
+    bool targetValid = (frame.targets[i].resolution != 0);
     
-    bool targetValid = (resolution != 0);
+    // Calculate distance from x, y (both in mm)
+    int distanceCm = 0;
+    if (targetValid) {
+      float dist_mm = sqrtf((float)x * x + (float)y * y);
+      distanceCm = (int)(dist_mm / 10.0); // Convert to cm
+    }
     
     // Update state machine if filtering enabled
-    if (config.filterEnable) {
-      updateTargetState(i, targetValid);
+    if (cfg.filterEnable) {
+      updateTargetState(cfg, i, targetValid, distanceCm, speed);
     } else {
       // No filtering - direct mapping
-      targets[i].previousState = targets[i].state;
-      targets[i].state = targetValid ? PRESENT : ABSENT;
-      targets[i].stateChanged = (targets[i].previousState != targets[i].state);
+      target.previousState = target.state;
+      target.state = targetValid ? PRESENT : ABSENT;
+      target.stateChanged = (target.previousState != target.state);
     }
     
     // Store target data
     if (targetValid) {
-      targets[i].lastX = x;
-      targets[i].lastY = y;
-      targets[i].lastSpeed = speed;
-      targets[i].valid = true;
-      
-      // Calculate distance from x, y (both in mm)
-      float dist_mm = sqrtf((float)x * x + (float)y * y);
-      targets[i].lastDistance = (int)(dist_mm / 10.0); // Convert to cm
+      target.lastX = x;
+      target.lastY = y;
+      target.lastSpeed = speed;
+      target.valid = true;
+      target.lastDistance = distanceCm;
       
       validCount++;
       
-      Serial.printf("[LD2450] T%d: x=%6dmm y=%6dmm dist=%3dcm speed=%3dcm/s resolution=%d\n",
-        i + 1, x, y, targets[i].lastDistance, speed, resolution);
+      if (!cfg.telemetryEnable) {
+        Serial.printf("[LD2450] T%d: x=%6dmm y=%6dmm dist=%3dcm speed=%3dcm/s resolution=%d\n",
+          i + 1, x, y, target.lastDistance, speed, frame.targets[i].resolution);
+      }
     } else {
-      targets[i].previousState = targets[i].state;
-      targets[i].state = ABSENT;
-      targets[i].stateChanged = (targets[i].previousState != targets[i].state);
-      targets[i].valid = false;
-      targets[i].lastDistance = 0;
+      target.valid = false;
+      
+      // A held target keeps its last known position (stationary person)
+      if (target.state != PRESENT) {
+        target.lastDistance = 0;
+      }
     }
+    
+    updateTimeToZone(cfg, target);
   }
   
   return validCount;
 }
 
-int16_t LD2450Manager::readInt16LE(uint8_t* ptr) {
-  // Little Endian: low byte first, high byte second
-  return (int16_t)((ptr[1] << 8) | ptr[0]);
-}
-
-void LD2450Manager::updateTargetState(int targetIdx, bool sensorDetected) {
-  TargetInfo& target = targets[targetIdx];
-  unsigned long currentTime = millis();
+// Presence engine with asymmetric hysteresis:
+// - Entry needs enterFrames consecutive detections AND debounceMs in DEBOUNCE;
+//   with prediction enabled, a target that kept approaching for enterFrames
+//   frames only needs fastEnterMs
+// - Exit needs exitFrames consecutive misses AND exitMs since last detection;
+//   until then the target stays PRESENT on its last known position
+// The entry time conditions are counted in frames (see ConfigSnapshot).
+// Only PRESENT <-> ABSENT transitions are reported as state changes.
+void LD2450Manager::updateTargetState(const ConfigSnapshot& cfg, int targetIdx, bool sensorDetected,
+                                      int distanceCm, int speedCmS) {
+  TargetInfo& target = snapshot.targets[targetIdx];
+  unsigned long currentTime = Hal::millis();
   
   target.previousState = target.state;
   
+  if (sensorDetected) {
+    if (target.hitFrames < UINT16_MAX) target.hitFrames++;
+    target.missFrames = 0;
+    target.lastSeenTime = currentTime;
+    
+    // Approaching = moving towards the sensor AND getting closer frame to frame,
+    // so a lingering or jittering detection never qualifies
+    bool closer = target.hitFrames == 1 || distanceCm < target.lastDistance;
+    if (speedCmS >= APPROACH_MIN_SPEED_CMS && closer) {
+      if (target.approachFrames < UINT16_MAX) target.approachFrames++;
+    } else {
+      target.approachFrames = 0;
+    }
+  } else {
+    if (target.missFrames < UINT16_MAX) target.missFrames++;
+    target.hitFrames = 0;
+    target.approachFrames = 0;
+  }
+  
   switch (target.state) {
     case ABSENT:
       if (sensorDetected) {
         target.state = DEBOUNCE;
         target.stateChangeTime = currentTime;
-        target.stateChanged = false;
       }
       break;
-      
+    
     case DEBOUNCE:
-      if (sensorDetected) {
-        if ((currentTime - target.stateChangeTime) >= config.debounceMs) {
-          target.state = PRESENT;
-          target.stateChanged = true;
-          Serial.printf("Target %d PRESENT (debounce confirmed)\n", targetIdx + 1);
-        }
-      } else {
+      if (!sensorDetected) {
+        // Detection did not last long enough - treat as noise
         target.state = ABSENT;
+        target.rejectedEntries++;
+      } else if (target.hitFrames >= cfg.enterConfirmFrames ||
+                 (target.hitFrames >= cfg.fastConfirmFrames && target.approachFrames >= cfg.enterFrames)) {
+        if (target.hitFrames < cfg.enterConfirmFrames) {
+          target.fastConfirms++;
+        }
+        target.state = PRESENT;
+        target.stateChangeTime = currentTime;
+        if (target.lastAbsentTime != 0 &&
+            (currentTime - target.lastAbsentTime) < FLAP_WINDOW_MS) {
+          target.flaps++;
+        }
+        Serial.printf("Target %d PRESENT (debounce confirmed)\n", targetIdx + 1);
       }
       break;
-      
+    
     case PRESENT:
-      if (!sensorDetected) {
-        target.state = DEBOUNCE;
-        target.stateChangeTime = currentTime;
-        target.stateChanged = false;
+      if (sensorDetected) {
+        if (target.holding) {
+          target.holding = false;
+          target.absorbedDropouts++;
+        }
+      } else {
+        target.holding = true;
+        if (exitHoldExpired(cfg, target, currentTime)) {
+          confirmExit(target, currentTime);
+        }
       }
       break;
   }
   
-  target.stateChanged = (target.previousState != target.state) && 
-                        (target.state == PRESENT || target.state == ABSENT);
+  target.stateChanged = (target.previousState == PRESENT) != (target.state == PRESENT);
 }
 
-bool LD2450Manager::isTargetPresent(int targetIdx) {
-  if (targetIdx < 0 || targetIdx >= 3) return false;
-  return targets[targetIdx].state == PRESENT;
+// Both exit conditions, measured from the last detection. Frames the radar
+// should have sent since its last one count as missed, so the hold also
+// runs out while the radar is silent
+bool LD2450Manager::exitHoldExpired(const ConfigSnapshot& cfg, const TargetInfo& target,
+                                    unsigned long now) const {
+  unsigned long missed = target.missFrames + (now - lastFrameTime) / LD2450Proto::FRAME_INTERVAL_MS;
+  return missed >= cfg.exitFrames && now - target.lastSeenTime >= cfg.exitMs;
 }
 
-bool LD2450Manager::hasTargetStateChanged(int targetIdx) {
-  if (targetIdx < 0 || targetIdx >= 3) return false;
-  return targets[targetIdx].stateChanged;
+void LD2450Manager::confirmExit(TargetInfo& target, unsigned long now) {
+  target.state = ABSENT;
+  target.holding = false;
+  target.stateChangeTime = now;
+  target.lastAbsentTime = now;
+  target.lastDistance = 0;
 }
 
-int LD2450Manager::getClosestDistanceCm() {
-  return closestDistanceCm;
+// Exit holds that ran out between frames (radar stalled or unplugged).
+// The exits are published as an extra frame tick without a radar frame, so
+// consumers handle the state changes like those of a real frame
+void LD2450Manager::expireSilentHolds(const ConfigSnapshot& cfg, unsigned long now) {
+  if (!cfg.filterEnable) {
+    return;
+  }
+  
+  bool anyExpired = false;
+  for (const TargetInfo& target : snapshot.targets) {
+    if (target.state == PRESENT && exitHoldExpired(cfg, target, now)) {
+      anyExpired = true;
+    }
+  }
+  if (!anyExpired) {
+    return;
+  }
+  
+  for (TargetInfo& target : snapshot.targets) {
+    target.previousState = target.state;
+    if (target.state == PRESENT && exitHoldExpired(cfg, target, now)) {
+      confirmExit(target, now);
+      target.valid = false;
+      target.hitFrames = 0;
+      target.approachFrames = 0;
+    }
+    target.stateChanged = (target.previousState == PRESENT) != (target.state == PRESENT);
+    updateTimeToZone(cfg, target);
+  }
+  
+  updateSnapshotSummary();
+  publishedSnapshot.write(snapshot);
 }
 
-int LD2450Manager::getTargetDistanceCm(int targetIdx) {
-  if (targetIdx < 0 || targetIdx >= 3) {
-    return 0;
+// Predicted time until a PRESENT target reaches the safety zone, from its
+// current distance and radial speed
+void LD2450Manager::updateTimeToZone(const ConfigSnapshot& cfg, TargetInfo& target) {
+  target.timeToZoneDs = 0xFF;
+  if (target.state != PRESENT || cfg.alertDistanceCm <= 0 || target.lastDistance <= 0) {
+    return;
   }
   
-  if (targets[targetIdx].valid && targets[targetIdx].state == PRESENT) {
-    return targets[targetIdx].lastDistance;
+  int gapCm = target.lastDistance - cfg.alertDistanceCm;
+  if (gapCm <= 0) {
+    target.timeToZoneDs = 0;
+  } else if (target.valid && target.approachFrames >= cfg.enterFrames &&
+             target.lastSpeed >= APPROACH_MIN_SPEED_CMS) {
+    int ds = (gapCm * 10 + target.lastSpeed - 1) / target.lastSpeed;
+    target.timeToZoneDs = ds < 0xFF ? (uint8_t)ds : 0xFF;
   }
-  
-  return 0;
 }
 
-TargetInfo LD2450Manager::getTargetInfo(int targetIdx) {
-  if (targetIdx < 0 || targetIdx >= 3) {
-    TargetInfo empty = {ABSENT, ABSENT, 0, 0, 0, 0, false, false};
-    return empty;
+// Recompute the aggregate fields once per processed frame
+void LD2450Manager::updateSnapshotSummary() {
+  snapshot.closestDistanceCm = 600;
+  snapshot.presentCount = 0;
+  snapshot.anyStateChanged = false;
+  snapshot.frameCount++;
+  
+  for (const TargetInfo& target : snapshot.targets) {
+    if (target.stateChanged) {
+      snapshot.anyStateChanged = true;
+    }
+    
+    if (target.state == PRESENT) {
+      snapshot.presentCount++;
+      
+      int dist = target.lastDistance;
+      if (dist > 0 && dist < snapshot.closestDistanceCm) {
+        snapshot.closestDistanceCm = dist;
+      }
+    }
   }
-  return targets[targetIdx];
 }
 
-const LD2450Config& LD2450Manager::getConfig() const {
-  return config;
+const TargetSnapshot& LD2450Manager::getSnapshot() const {
+  return snapshot;
+}
+
+// Consistent copy of the last processed frame - safe from any task
+// Returns the publication sequence number of the copy
+uint32_t LD2450Manager::readPublishedSnapshot(TargetSnapshot& out) const {
+  return publishedSnapshot.read(out);
+}
+
+size_t LD2450Manager::getRxBacklog() const {
+  return Hal::radarUart().available() + bufferPos;
+}
+
+uint32_t LD2450Manager::getPublishedFrameCount() const {
+  return publishedSnapshot.version();
+}
+
+const ConfigSnapshot& LD2450Manager::getConfig() const {
+  return publishedConfig.get();
+}
+
+// Frame ticks covering ms, rounded up
+static uint16_t framesFor(unsigned long ms) {
+  unsigned long frames = (ms + LD2450Proto::FRAME_INTERVAL_MS - 1) / LD2450Proto::FRAME_INTERVAL_MS;
+  return frames < UINT16_MAX ? (uint16_t)frames : UINT16_MAX - 1;
+}
+
+// Build the next configuration version with its derived values and swap it
+// in; readers pick it up with their next getConfig()
+void LD2450Manager::publishConfig() {
+  ConfigSnapshot& next = publishedConfig.prepare();
+  static_cast<LD2450Config&>(next) = config;
+  next.version++;
+  
+  // A target enters DEBOUNCE on its first detection, so debounceMs has
+  // passed on detection framesFor(debounceMs) + 1
+  uint16_t debounceFrames = framesFor(config.debounceMs) + 1;
+  next.enterConfirmFrames = debounceFrames > config.enterFrames ? debounceFrames : config.enterFrames;
+  if (config.predictEnable) {
+    uint16_t fastFrames = framesFor(config.fastEnterMs) + 1;
+    next.fastConfirmFrames = fastFrames > config.enterFrames ? fastFrames : config.enterFrames;
+  } else {
+    next.fastConfirmFrames = UINT16_MAX;
+  }
+  next.rangeMaxSqMm = (uint32_t)(config.rangeMaxCm * 10) * (uint32_t)(config.rangeMaxCm * 10);
+  
+  // Clamped to the 0-6m the radar covers, so the display strings always fit
+  uint16_t rangeCm = config.rangeMaxCm < 0 ? 0 : (config.rangeMaxCm > 600 ? 600 : config.rangeMaxCm);
+  snprintf(next.idLine, sizeof(next.idLine), "ID: %s", config.deviceName.c_str());
+  snprintf(next.rangeLine, sizeof(next.rangeLine), "Range: %ucm", rangeCm);
+  snprintf(next.statusLine, sizeof(next.statusLine), "Filter:%s MW:%s",
+           config.filterEnable ? "ON" : "OFF", config.magicWord.c_str());
+  snprintf(next.rangeLabel, sizeof(next.rangeLabel), "%u.%um", rangeCm / 100u, (rangeCm % 100u) / 10u);
+  
+  publishedConfig.publish();
 }
 
 bool LD2450Manager::isSensorInitialized() const {
@@ -301,39 +463,91 @@ bool LD2450Manager::isSensorInitialized() const {
 }
 
 String LD2450Manager::generatePayload() {
-  String payload = "{\"d\":\"" + String(config.deviceName.c_str()) + "\"";
-  payload += ",\"m\":\"" + String(config.magicWord.c_str()) + "\"";
+  const ConfigSnapshot& cfg = getConfig();
+  String payload = "{\"d\":\"" + String(cfg.deviceName.c_str()) + "\"";
+  payload += ",\"m\":\"" + String(cfg.magicWord.c_str()) + "\"";
   
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& target = snapshot.targets[i];
+    
     payload += ",\"t" + String(i + 1) + "\":";
-    payload += (targets[i].state == PRESENT) ? "true" : "false";
+    payload += (target.state == PRESENT) ? "true" : "false";
     
     payload += ",\"t" + String(i + 1) + "_d\":";
-    payload += (targets[i].state == PRESENT) ? String(targets[i].lastDistance) : "0";
+    payload += (target.state == PRESENT) ? String(target.lastDistance) : "0";
   }
   
-  payload += ",\"x\":" + String(closestDistanceCm);
+  payload += ",\"x\":" + String(snapshot.closestDistanceCm);
   payload += ",\"e\":0}";
   
   return payload;
 }
 
+size_t LD2450Manager::encodePresencePayload(uint8_t* out, size_t cap) const {
+  const ConfigSnapshot& cfg = getConfig();
+  size_t nameLen = cfg.deviceName.length();
+  
+  size_t len = MESH_PAYLOAD_HEADER_SIZE + 4 + LD2450_MAX_TARGETS * 3 + 1 + nameLen;
+  if (len > cap) {
+    return 0;
+  }
+  
+  uint8_t presentMask = 0;
+  size_t pos = 0;
+  out[pos++] = MESH_PAYLOAD_VERSION;
+  out[pos++] = MSG_PRESENCE;
+  out[pos++] = 0;  // Present bitmask, filled below
+  out[pos++] = LD2450_MAX_TARGETS;
+  out[pos++] = snapshot.closestDistanceCm & 0xFF;
+  out[pos++] = (snapshot.closestDistanceCm >> 8) & 0xFF;
+  
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& target = snapshot.targets[i];
+    int dist = 0;
+    if (target.state == PRESENT) {
+      presentMask |= (1 << i);
+      dist = target.lastDistance;
+    }
+    out[pos++] = dist & 0xFF;
+    out[pos++] = (dist >> 8) & 0xFF;
+  }
+  out[2] = presentMask;
+  
+  out[pos++] = (uint8_t)nameLen;
+  memcpy(out + pos, cfg.deviceName.c_str(), nameLen);
+  pos += nameLen;
+  
+  for (const TargetInfo& target : snapshot.targets) {
+    out[pos++] = target.timeToZoneDs;
+  }
+  
+  return pos;
+}
+
 void LD2450Manager::printTargetStatus() {
   Serial.println("\n--- Target Status ---");
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& target = snapshot.targets[i];
+    
     Serial.printf("Target %d: ", i + 1);
     Serial.printf("State=%s ", 
-      targets[i].state == ABSENT ? "ABSENT" : 
-      targets[i].state == DEBOUNCE ? "DEBOUNCE" : "PRESENT");
-    Serial.printf("Valid=%d ", targets[i].valid);
-    if (targets[i].valid) {
-      Serial.printf("X=%dmm Y=%dmm Dist=%dcm Speed=%dcm/s", 
-        targets[i].lastX, targets[i].lastY, 
-        targets[i].lastDistance, targets[i].lastSpeed);
+      target.state == ABSENT ? "ABSENT" : 
+      target.state == DEBOUNCE ? "DEBOUNCE" : "PRESENT");
+    Serial.printf("Valid=%d ", target.valid);
+    if (target.valid || target.holding) {
+      Serial.printf("X=%dmm Y=%dmm Dist=%dcm Speed=%dcm/s%s ", 
+        target.lastX, target.lastY, 
+        target.lastDistance, target.lastSpeed,
+        target.holding ? " (hold)" : "");
+    }
+    if (target.timeToZoneDs != 0xFF) {
+      Serial.printf("TTZ=%.1fs ", target.timeToZoneDs / 10.0);
     }
+    Serial.printf("Rejected=%lu Bridged=%lu Flaps=%lu Fast=%lu",
+      target.rejectedEntries, target.absorbedDropouts, target.flaps, target.fastConfirms);
     Serial.println();
   }
-  Serial.printf("Closest: %d cm\n", closestDistanceCm);
+  Serial.printf("Closest: %d cm\n", snapshot.closestDistanceCm);
   Serial.println("--------------------\n");
 }
 
@@ -347,8 +561,19 @@ void LD2450Manager::saveToNVS() {
   
   prefs.putInt("range_max", config.rangeMaxCm);
   prefs.putULong("debounce_ms", config.debounceMs);
+  prefs.putUInt("enter_frames", config.enterFrames);
+  prefs.putULong("exit_ms", config.exitMs);
+  prefs.putUInt("exit_frames", config.exitFrames);
+  prefs.putUInt("summary_s", config.summaryWindowS);
+  prefs.putInt("alert_cm", config.alertDistanceCm);
+  prefs.putUInt("track_bpm", config.trackBudgetBpm);
+  prefs.putInt("track_tol", config.trackToleranceCm);
+  prefs.putBool("predict", config.predictEnable);
+  prefs.putULong("fast_enter_ms", config.fastEnterMs);
   prefs.putBool("filter_enable", config.filterEnable);
   prefs.putBool("sensor_enable", config.sensorEnable);
+  prefs.putBool("radar_view", config.radarView);
+  prefs.putBool("telemetry", config.telemetryEnable);
   prefs.putString("device_name", config.deviceName.c_str());
   prefs.putString("magic_word", config.magicWord.c_str());
   
@@ -370,10 +595,25 @@ void LD2450Manager::loadFromNVS() {
   
   config.rangeMaxCm = prefs.getInt("range_max", 300);
   config.debounceMs = prefs.getULong("debounce_ms", 2500);
+  config.enterFrames = prefs.getUInt("enter_frames", 3);
+  config.exitMs = prefs.getULong("exit_ms", 1500);
+  config.exitFrames = prefs.getUInt("exit_frames", 10);
+  config.summaryWindowS = prefs.getUInt("summary_s", 300);
+  config.alertDistanceCm = prefs.getInt("alert_cm", 100);
+  config.trackBudgetBpm = prefs.getUInt("track_bpm", 0);
+  config.trackToleranceCm = prefs.getInt("track_tol", 30);
+  config.predictEnable = prefs.getBool("predict", false);
+  config.fastEnterMs = prefs.getULong("fast_enter_ms", 500);
   config.filterEnable = prefs.getBool("filter_enable", true);
   config.sensorEnable = prefs.getBool("sensor_enable", true);
-  config.deviceName = prefs.getString("device_name", "LD2450_A").c_str();
-  config.magicWord = prefs.getString("magic_word", "LD2450").c_str();
+  config.radarView = prefs.getBool("radar_view", false);
+  config.telemetryEnable = prefs.getBool("telemetry", false);
+  if (!config.deviceName.assign(prefs.getString("device_name", "LD2450_A").c_str())) {
+    config.deviceName.assign("LD2450_A");
+  }
+  if (!config.magicWord.assign(prefs.getString("magic_word", "LD2450").c_str())) {
+    config.magicWord.assign("LD2450");
+  }
   
   prefs.end();
   
@@ -396,6 +636,76 @@ void LD2450Manager::setDebounceMs(unsigned long ms) {
   }
 }
 
+void LD2450Manager::setEnterFrames(int frames) {
+  if (frames >= 1 && frames <= 50) {
+    config.enterFrames = frames;
+    Serial.printf("Enter frames set to: %d\n", frames);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setExitMs(unsigned long ms) {
+  if (ms <= 30000) {
+    config.exitMs = ms;
+    Serial.printf("Exit hold set to: %lu ms\n", ms);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setExitFrames(int frames) {
+  if (frames >= 1 && frames <= 300) {
+    config.exitFrames = frames;
+    Serial.printf("Exit frames set to: %d\n", frames);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setSummaryWindowS(int seconds) {
+  if (seconds == 0 || (seconds >= 10 && seconds <= 3600)) {
+    config.summaryWindowS = seconds;
+    Serial.printf("Summary window set to: %d s\n", seconds);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setAlertDistanceCm(int cm) {
+  if (cm >= 0 && cm <= 600) {
+    config.alertDistanceCm = cm;
+    Serial.printf("Alert distance set to: %d cm\n", cm);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setTrackBudgetBpm(int bytesPerMin) {
+  if (bytesPerMin == 0 || (bytesPerMin >= 30 && bytesPerMin <= 2000)) {
+    config.trackBudgetBpm = bytesPerMin;
+    Serial.printf("Trajectory budget set to: %d bytes/min\n", bytesPerMin);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setTrackToleranceCm(int cm) {
+  if (cm >= 5 && cm <= 200) {
+    config.trackToleranceCm = cm;
+    Serial.printf("Trajectory tolerance set to: %d cm\n", cm);
+    saveToNVS();
+  }
+}
+
+void LD2450Manager::setPredictEnable(bool enable) {
+  config.predictEnable = enable;
+  Serial.printf("Approach prediction: %s\n", enable ? "Enabled" : "Disabled");
+  saveToNVS();
+}
+
+void LD2450Manager::setFastEnterMs(unsigned long ms) {
+  if (ms >= 100 && ms <= 5000) {
+    config.fastEnterMs = ms;
+    Serial.printf("Fast enter hold set to: %lu ms\n", ms);
+    saveToNVS();
+  }
+}
+
 void LD2450Manager::setFilterEnable(bool enable) {
   config.filterEnable = enable;
   Serial.printf("Filter: %s\n", enable ? "Enabled" : "Disabled");
@@ -408,20 +718,39 @@ void LD2450Manager::setSensorEnable(bool enable) {
   saveToNVS();
 }
 
-void LD2450Manager::setDeviceName(const String& name) {
-  config.deviceName = name.c_str();
-  Serial.printf("Device name set to: %s\n", config.deviceName.c_str());
+void LD2450Manager::setRadarView(bool enable) {
+  config.radarView = enable;
+  Serial.printf("Display: %s\n", enable ? "radar plot" : "text");
   saveToNVS();
 }
 
-void LD2450Manager::setMagicWord(const String& word) {
-  config.magicWord = word.c_str();
-  Serial.printf("Magic word set to: %s\n", config.magicWord.c_str());
+void LD2450Manager::setTelemetryEnable(bool enable) {
+  config.telemetryEnable = enable;
+  Serial.printf("USB output: %s\n", enable ? "binary telemetry" : "text log");
   saveToNVS();
 }
 
+void LD2450Manager::setDeviceName(const String& name) {
+  if (name.length() > 0 && config.deviceName.assign(name.c_str(), name.length())) {
+    Serial.printf("Device name set to: %s\n", config.deviceName.c_str());
+    saveToNVS();
+  } else {
+    Serial.printf("ERROR: Device name must be 1-%u characters\n", (unsigned)DEVICE_NAME_MAX_LEN);
+  }
+}
+
+void LD2450Manager::setMagicWord(const String& word) {
+  if (word.length() > 0 && config.magicWord.assign(word.c_str(), word.length())) {
+    Serial.printf("Magic word set to: %s\n", config.magicWord.c_str());
+    saveToNVS();
+  } else {
+    Serial.printf("ERROR: Magic word must be 1-%u characters\n", (unsigned)MAGIC_WORD_MAX_LEN);
+  }
+}
+
 bool LD2450Manager::processConfigCommand(const String& jsonString) {
-  StaticJsonDocument<256> doc;
+  // Static: commands can arrive reassembled from several packets
+  static StaticJsonDocument<MESH_COMMAND_JSON_CAPACITY> doc;
   DeserializationError error = deserializeJson(doc, jsonString);
   
   if (error) {
@@ -430,7 +759,7 @@ bool LD2450Manager::processConfigCommand(const String& jsonString) {
     return false;
   }
   
-  if (!doc.containsKey("m") || doc["m"].as<String>() != config.magicWord.c_str()) {
+  if (!doc.containsKey("m") || getConfig().magicWord != doc["m"].as<const char*>()) {
     Serial.println("LD2450: Wrong magic word or missing");
     return false;
   }
@@ -447,11 +776,66 @@ bool LD2450Manager::processConfigCommand(const String& jsonString) {
     configChanged = true;
   }
   
+  if (doc.containsKey("enter_frames")) {
+    setEnterFrames(doc["enter_frames"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("exit_ms")) {
+    setExitMs(doc["exit_ms"].as<unsigned long>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("exit_frames")) {
+    setExitFrames(doc["exit_frames"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("summary_s")) {
+    setSummaryWindowS(doc["summary_s"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("alert_cm")) {
+    setAlertDistanceCm(doc["alert_cm"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("track_bpm")) {
+    setTrackBudgetBpm(doc["track_bpm"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("track_tol_cm")) {
+    setTrackToleranceCm(doc["track_tol_cm"].as<int>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("predict")) {
+    setPredictEnable(doc["predict"].as<bool>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("fast_enter_ms")) {
+    setFastEnterMs(doc["fast_enter_ms"].as<unsigned long>());
+    configChanged = true;
+  }
+  
   if (doc.containsKey("filter_enable")) {
     setFilterEnable(doc["filter_enable"].as<bool>());
     configChanged = true;
   }
   
+  if (doc.containsKey("radar_view")) {
+    setRadarView(doc["radar_view"].as<bool>());
+    configChanged = true;
+  }
+  
+  if (doc.containsKey("telemetry")) {
+    setTelemetryEnable(doc["telemetry"].as<bool>());
+    configChanged = true;
+  }
+  
   if (doc.containsKey("sensor_enable")) {
     setSensorEnable(doc["sensor_enable"].as<bool>());
     configChanged = true;
@@ -467,5 +851,10 @@ bool LD2450Manager::processConfigCommand(const String& jsonString) {
     configChanged = true;
   }
   
+  // All keys of one command take effect together
+  if (configChanged) {
+    publishConfig();
+  }
+  
   return configChanged;
 }
\ No newline at end of file
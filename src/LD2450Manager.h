@@ -2,7 +2,13 @@
 #define LD2450MANAGER_H
 
 #include <Arduino.h>
-#include <string>
+#include "SeqLock.h"
+#include "Versioned.h"
+#include "FixedString.h"
+#include "LD2450Proto.h"
+
+// Targets reported per LD2450 frame - sizes all per-target arrays
+static constexpr int LD2450_MAX_TARGETS = (int)LD2450Proto::MAX_TARGETS;
 
 // Target state enum
 enum TargetState {
@@ -22,40 +28,111 @@ struct TargetInfo {
   int lastDistance; // cm
   bool valid;
   bool stateChanged;
+  
+  // Presence hysteresis
+  uint16_t hitFrames;             // Consecutive frames with detection
+  uint16_t missFrames;            // Consecutive frames without detection
+  unsigned long lastSeenTime;     // Last frame with detection
+  unsigned long lastAbsentTime;   // Last PRESENT -> ABSENT transition
+  bool holding;                   // PRESENT on last known position (not detected)
+  
+  // Approach prediction
+  uint16_t approachFrames;        // Consecutive detections moving closer
+  uint8_t timeToZoneDs;           // Predicted time to the safety zone, 0.1 s (0 = inside, 0xFF = none)
+  unsigned long fastConfirms;     // Entries confirmed early because of an approach
+  
+  // Flap counters
+  unsigned long rejectedEntries;  // Detections dropped before entry confirmed
+  unsigned long absorbedDropouts; // Detection gaps bridged by the exit hold
+  unsigned long flaps;            // Re-entries shortly after a reported exit
+};
+
+// Per-frame view of all targets - consumers iterate this instead of
+// querying each slot individually
+struct TargetSnapshot {
+  TargetInfo targets[LD2450_MAX_TARGETS];
+  int closestDistanceCm;  // Closest PRESENT target (600 = none)
+  int presentCount;       // Number of targets in PRESENT state
+  bool anyStateChanged;   // At least one target changed state this frame
+  uint32_t frameCount;    // Frames processed so far - identifies this frame
+  
+  static constexpr int capacity() { return LD2450_MAX_TARGETS; }
+  const TargetInfo& operator[](int idx) const { return targets[idx]; }
+  const TargetInfo* begin() const { return targets; }
+  const TargetInfo* end() const { return targets + LD2450_MAX_TARGETS; }
 };
 
 // Configuration structure
 struct LD2450Config {
   int rangeMaxCm;           // 1-600cm detection range
-  unsigned long debounceMs; // 500-5000ms debounce time (default 2500)
+  unsigned long debounceMs; // 500-5000ms enter hold time (default 2500)
+  uint16_t enterFrames;     // 1-50 consecutive frames to confirm entry (default 3)
+  unsigned long exitMs;     // 0-30000ms exit hold time (default 1500)
+  uint16_t exitFrames;      // 1-300 consecutive missed frames to confirm exit (default 10)
+  uint16_t summaryWindowS;  // 0 or 10-3600s occupancy summary window, 0 = per-event reports (default 300)
+  int alertDistanceCm;      // 0-600cm safety zone for immediate alerts, 0 = off (default 100)
+  uint16_t trackBudgetBpm;  // 0 or 30-2000 bytes/min for trajectory streaming, 0 = off (default 0)
+  int trackToleranceCm;     // 5-200cm path simplification error bound (default 30)
+  bool predictEnable;       // Shorter entry confirmation and early alerts for approaching targets
+  unsigned long fastEnterMs; // 100-5000ms enter hold for approaching targets (default 500)
   bool filterEnable;        // Enable/disable state filtering
   bool sensorEnable;        // Enable/disable sensor
-  std::string deviceName;   // Device identifier
-  std::string magicWord;    // Configuration magic word
+  bool radarView;           // Display shows the top-down radar plot instead of text
+  bool telemetryEnable;     // Binary per-frame telemetry on USB instead of the frame log
+  DeviceName deviceName;    // Device identifier (max 32 chars)
+  MagicWord magicWord;      // Configuration magic word (max 16 chars)
+};
+
+// Published configuration: the settings plus values derived from them once
+// per change, so the frame path and the display never recompute them.
+// Never modified after publication (see Versioned.h)
+struct ConfigSnapshot : LD2450Config {
+  uint32_t version;             // Increments with every published change
+  
+  // Entry hysteresis in frame ticks (LD2450Proto::FRAME_INTERVAL_MS). Entry
+  // needs detections, so both conditions are counted from the first one and
+  // collapse into one threshold. Exit is checked against the clock as well,
+  // since no frames arrive when the radar goes quiet (see exitHoldExpired())
+  uint16_t enterConfirmFrames;  // max(enterFrames, debounceMs + 1 tick)
+  uint16_t fastConfirmFrames;   // Same for approaching targets, UINT16_MAX = prediction off
+  
+  uint32_t rangeMaxSqMm;        // rangeMaxCm squared, in mm^2
+  
+  // Display text
+  char idLine[40];              // "ID: <device name>"
+  char rangeLine[16];           // "Range: 300cm"
+  char statusLine[40];          // "Filter:ON MW:<magic word>"
+  char rangeLabel[12];          // "3.0m" (radar plot)
 };
 
 class LD2450Manager {
 private:
-  TargetInfo targets[3];
-  LD2450Config config;
+  TargetSnapshot snapshot;
+  SeqLock<TargetSnapshot> publishedSnapshot;  // Lock-free copy for other tasks
+  LD2450Config config;                        // Working copy, edited by the setters
+  Versioned<ConfigSnapshot> publishedConfig;  // What everything else reads
   unsigned long lastReadTime;
   bool sensorInitialized;
-  int closestDistanceCm;
+  bool firstFrameSeen;
+  unsigned long firstFrameTime;  // ms since boot of the first valid frame
+  unsigned long lastFrameTime;   // ms since boot of the last valid frame
   
   // Frame parsing
-  uint8_t frameBuffer[30];
+  uint8_t frameBuffer[LD2450Proto::FRAME_SIZE];
   int bufferPos;
+  LD2450Proto::Frame lastFrame;  // Raw values of the last processed frame
+  unsigned long lastParseUs;     // Time spent processing it
   
   // Helper functions
-  void updateTargetState(int targetIdx, bool sensorDetected);
-  int parseFrame(uint8_t* frame);
-  int16_t readInt16LE(uint8_t* ptr);
-  
-  // ESPHome-compatible decoders with special sign-bit encoding
-  // Bit 7 of highByte = sign bit (0=negative, 1=positive)
-  int16_t decodeCoordinate(uint8_t lowByte, uint8_t highByte);
-  int16_t decodeSpeed(uint8_t lowByte, uint8_t highByte);
-  
+  void updateTargetState(const ConfigSnapshot& cfg, int targetIdx, bool sensorDetected,
+                         int distanceCm, int speedCmS);
+  bool exitHoldExpired(const ConfigSnapshot& cfg, const TargetInfo& target, unsigned long now) const;
+  void confirmExit(TargetInfo& target, unsigned long now);
+  void expireSilentHolds(const ConfigSnapshot& cfg, unsigned long now);
+  void updateTimeToZone(const ConfigSnapshot& cfg, TargetInfo& target);
+  int parseFrame(const LD2450Proto::Frame& frame);
+  void updateSnapshotSummary();
+
 public:
   LD2450Manager();
   
@@ -68,26 +145,56 @@ public:
   bool readSensor();
   
   // Configuration
+  // The setters edit the working copy and persist it; processConfigCommand()
+  // publishes the result once per command
   bool processConfigCommand(const String& jsonString);
+  void publishConfig();
   void setRangeMaxCm(int cm);
   void setDebounceMs(unsigned long ms);
+  void setEnterFrames(int frames);
+  void setExitMs(unsigned long ms);
+  void setExitFrames(int frames);
+  void setSummaryWindowS(int seconds);
+  void setAlertDistanceCm(int cm);
+  void setTrackBudgetBpm(int bytesPerMin);
+  void setTrackToleranceCm(int cm);
+  void setPredictEnable(bool enable);
+  void setFastEnterMs(unsigned long ms);
   void setFilterEnable(bool enable);
   void setSensorEnable(bool enable);
+  void setRadarView(bool enable);
+  void setTelemetryEnable(bool enable);
   void setDeviceName(const String& name);
   void setMagicWord(const String& word);
   
   // Getters
-  bool isTargetPresent(int targetIdx);
-  bool hasTargetStateChanged(int targetIdx);
-  int getClosestDistanceCm();
-  int getTargetDistanceCm(int targetIdx);
-  TargetInfo getTargetInfo(int targetIdx);
-  const LD2450Config& getConfig() const;
+  // getSnapshot() is for the task that calls readSensor(); other tasks
+  // use readPublishedSnapshot(), which never blocks the parser
+  const TargetSnapshot& getSnapshot() const;
+  uint32_t readPublishedSnapshot(TargetSnapshot& out) const;
+  uint32_t getPublishedFrameCount() const;
+  // Current published configuration (one pointer load, safe from any task)
+  const ConfigSnapshot& getConfig() const;
   bool isSensorInitialized() const;
   
-  // JSON output
+  // Radar bytes received but not parsed yet (readSensor() parses one frame
+  // per call)
+  size_t getRxBacklog() const;
+  
+  // Raw decoded values and processing time of the last frame (telemetry)
+  const LD2450Proto::Frame& getLastFrame() const { return lastFrame; }
+  unsigned long getLastParseUs() const { return lastParseUs; }
+  
+  // Time to first valid frame since boot in ms, 0 until one arrived
+  unsigned long getFirstFrameTime() const { return firstFrameTime; }
+  
+  // JSON output (serial log)
   String generatePayload();
   
+  // Binary mesh payload (MSG_PRESENCE, see MeshPayload.h)
+  // Returns the encoded length, 0 if cap is too small
+  size_t encodePresencePayload(uint8_t* out, size_t cap) const;
+  
   // Status
   void printTargetStatus();
   
@@ -0,0 +1,144 @@
+#ifndef LD2450PROTO_H
+#define LD2450PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Header-only codec for the LD2450 target report frame. The layout is
+// described once by the constants below and checked at compile time, so the
+// parser, the simulation's frame generator and host tools all agree on it.
+// Plain C++11 only, so it builds for the firmware and the native simulation.
+namespace LD2450Proto {
+
+//========================= Frame layout =========================
+// Header(4) | target 1(8) | target 2(8) | target 3(8) | footer(2)
+static constexpr size_t MAX_TARGETS = 3;
+
+static constexpr uint8_t HEADER_0 = 0xAA;
+static constexpr uint8_t HEADER_1 = 0xFF;
+static constexpr uint8_t HEADER_2 = 0x03;
+static constexpr uint8_t HEADER_3 = 0x00;
+static constexpr uint8_t FOOTER_0 = 0x55;
+static constexpr uint8_t FOOTER_1 = 0xCC;
+
+static constexpr size_t HEADER_OFFSET = 0;
+static constexpr size_t HEADER_SIZE = 4;
+static constexpr size_t TARGETS_OFFSET = HEADER_OFFSET + HEADER_SIZE;
+static constexpr size_t TARGET_SIZE = 8;
+static constexpr size_t FOOTER_OFFSET = TARGETS_OFFSET + MAX_TARGETS * TARGET_SIZE;
+static constexpr size_t FOOTER_SIZE = 2;
+static constexpr size_t FRAME_SIZE = FOOTER_OFFSET + FOOTER_SIZE;
+
+// Nominal reporting period: the sensor streams frames at 10 Hz
+static constexpr unsigned long FRAME_INTERVAL_MS = 100;
+
+// Fields of one target record, all 16-bit little-endian. X, Y (mm) and speed
+// (cm/s, positive = approaching) use sign-magnitude with bit 15 set for
+// positive values; resolution is unsigned and 0 marks an empty slot.
+static constexpr size_t X_OFFSET = 0;
+static constexpr size_t Y_OFFSET = 2;
+static constexpr size_t SPEED_OFFSET = 4;
+static constexpr size_t RESOLUTION_OFFSET = 6;
+
+static_assert(FRAME_SIZE == 30, "LD2450 report frames are 30 bytes");
+static_assert(FOOTER_OFFSET == 28, "Footer follows the three target records");
+static_assert(RESOLUTION_OFFSET + 2 == TARGET_SIZE, "Target fields fill the record");
+static_assert(X_OFFSET < Y_OFFSET && Y_OFFSET < SPEED_OFFSET && SPEED_OFFSET < RESOLUTION_OFFSET,
+              "Target fields are in wire order and do not overlap");
+
+static constexpr size_t targetOffset(size_t slot) {
+  return TARGETS_OFFSET + slot * TARGET_SIZE;
+}
+static_assert(targetOffset(0) == 4 && targetOffset(1) == 12 && targetOffset(2) == 20,
+              "Target records start at 4, 12 and 20");
+
+//========================= Decoded frame =========================
+struct Target {
+  int16_t x;            // mm, lateral (negative = left)
+  int16_t y;            // mm, forward
+  int16_t speed;        // cm/s, positive = approaching
+  uint16_t resolution;  // mm, 0 = no target
+};
+
+struct Frame {
+  Target targets[MAX_TARGETS];
+};
+
+//========================= Field codecs =========================
+constexpr uint16_t readU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// 1 when the sign bit (bit 15) is clear, i.e. the value is negative
+constexpr int32_t negativeFlag(uint16_t raw) {
+  return ((raw >> 15) & 1) ^ 1;
+}
+
+// Sign-magnitude to two's complement without a branch: conditional negate
+constexpr int16_t decodeSignMagnitude(uint16_t raw) {
+  return (int16_t)((((int32_t)(raw & 0x7FFF)) ^ -negativeFlag(raw)) + negativeFlag(raw));
+}
+
+// Two's complement to sign-magnitude; magnitudes beyond 15 bits saturate
+constexpr uint16_t encodeSignMagnitude(int16_t value) {
+  return value >= 0 ? (uint16_t)(0x8000 | value)
+                    : (uint16_t)(value < -0x7FFF ? 0x7FFF : -value);
+}
+
+static_assert(decodeSignMagnitude(0x8000) == 0 && decodeSignMagnitude(0x0000) == 0, "Zero");
+static_assert(decodeSignMagnitude(0x8064) == 100 && decodeSignMagnitude(0x0064) == -100, "Sign bit");
+static_assert(decodeSignMagnitude(encodeSignMagnitude(32767)) == 32767, "Positive limit");
+static_assert(decodeSignMagnitude(encodeSignMagnitude(-32767)) == -32767, "Negative limit");
+static_assert(decodeSignMagnitude(encodeSignMagnitude(-32768)) == -32767, "Saturation");
+
+//========================= Frame codec =========================
+constexpr bool hasHeader(const uint8_t* buf) {
+  return buf[HEADER_OFFSET] == HEADER_0 && buf[HEADER_OFFSET + 1] == HEADER_1 &&
+         buf[HEADER_OFFSET + 2] == HEADER_2 && buf[HEADER_OFFSET + 3] == HEADER_3;
+}
+
+constexpr bool isFrame(const uint8_t* buf) {
+  return hasHeader(buf) && buf[FOOTER_OFFSET] == FOOTER_0 && buf[FOOTER_OFFSET + 1] == FOOTER_1;
+}
+
+// Decode all target records of a FRAME_SIZE buffer (framing already checked)
+inline void decodeFrame(const uint8_t* buf, Frame& out) {
+  for (size_t i = 0; i < MAX_TARGETS; i++) {
+    const uint8_t* t = buf + targetOffset(i);
+    out.targets[i].x = decodeSignMagnitude(readU16(t + X_OFFSET));
+    out.targets[i].y = decodeSignMagnitude(readU16(t + Y_OFFSET));
+    out.targets[i].speed = decodeSignMagnitude(readU16(t + SPEED_OFFSET));
+    out.targets[i].resolution = readU16(t + RESOLUTION_OFFSET);
+  }
+}
+
+inline void writeU16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+// Encode a complete frame into a FRAME_SIZE buffer. Empty slots
+// (resolution 0) are sent as zero bytes, like the sensor does
+inline void encodeFrame(const Frame& in, uint8_t* buf) {
+  buf[HEADER_OFFSET] = HEADER_0;
+  buf[HEADER_OFFSET + 1] = HEADER_1;
+  buf[HEADER_OFFSET + 2] = HEADER_2;
+  buf[HEADER_OFFSET + 3] = HEADER_3;
+  for (size_t i = 0; i < MAX_TARGETS; i++) {
+    uint8_t* t = buf + targetOffset(i);
+    if (in.targets[i].resolution == 0) {
+      for (size_t j = 0; j < TARGET_SIZE; j++) t[j] = 0;
+      continue;
+    }
+    writeU16(t + X_OFFSET, encodeSignMagnitude(in.targets[i].x));
+    writeU16(t + Y_OFFSET, encodeSignMagnitude(in.targets[i].y));
+    writeU16(t + SPEED_OFFSET, encodeSignMagnitude(in.targets[i].speed));
+    writeU16(t + RESOLUTION_OFFSET, in.targets[i].resolution);
+  }
+  buf[FOOTER_OFFSET] = FOOTER_0;
+  buf[FOOTER_OFFSET + 1] = FOOTER_1;
+}
+
+}  // namespace LD2450Proto
+
+#endif // LD2450PROTO_H
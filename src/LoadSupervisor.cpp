@@ -0,0 +1,113 @@
+#include "LoadSupervisor.h"
+#include "Hal.h"
+#include "LD2450Manager.h"
+
+// Global instance
+LoadSupervisor loadSupervisor;
+
+// Pressure is evaluated over windows of this length
+static const unsigned long LOAD_WINDOW_MS = 1000;
+
+// Windows below the current stage needed to step back down
+static const uint8_t LOAD_RECOVER_WINDOWS = 5;
+
+// Radar backlog thresholds in bytes
+static const size_t LOAD_BACKLOG_QUIET = 2 * LD2450Proto::FRAME_SIZE;
+static const size_t LOAD_BACKLOG_DEFER = 4 * LD2450Proto::FRAME_SIZE;
+
+LoadSupervisor::LoadSupervisor()
+  : stage(LOAD_NORMAL), iterationStartUs(0), windowStartTime(0), windowMaxUs(0),
+    windowMaxBacklog(0), calmWindows(0), iterations(0), overruns(0), maxIterationUs(0),
+    maxBacklog(0), degradations(0), recoveries(0) {
+  for (unsigned long& count : degradationsTo) {
+    count = 0;
+  }
+}
+
+void LoadSupervisor::beginIteration() {
+  iterationStartUs = Hal::micros();
+}
+
+// Stage that the worst iteration and backlog of the window call for
+LoadStage LoadSupervisor::requiredStage(unsigned long budgetUs) const {
+  if (windowMaxBacklog >= LOAD_BACKLOG_DEFER || windowMaxUs > 4 * budgetUs) {
+    return LOAD_DEFER_MESH;
+  }
+  if (windowMaxBacklog >= LOAD_BACKLOG_QUIET || windowMaxUs > 2 * budgetUs) {
+    return LOAD_QUIET;
+  }
+  if (windowMaxUs > budgetUs) {
+    return LOAD_SLOW_DISPLAY;
+  }
+  return LOAD_NORMAL;
+}
+
+void LoadSupervisor::changeStage(LoadStage next) {
+  if (next > stage) {
+    degradations++;
+    degradationsTo[next]++;
+  } else {
+    recoveries++;
+  }
+  
+  // Transitions are rare and always logged, even when status output is off
+  Serial.printf("Load: %s -> %s (worst loop %lu ms, radar backlog %u B)\n",
+    stageName(stage), stageName(next), windowMaxUs / 1000, (unsigned)windowMaxBacklog);
+  stage = next;
+}
+
+void LoadSupervisor::endIteration(size_t rxBacklog, unsigned long budgetMs) {
+  unsigned long elapsedUs = Hal::micros() - iterationStartUs;
+  unsigned long budgetUs = budgetMs * 1000;
+  
+  iterations++;
+  if (elapsedUs > budgetUs) overruns++;
+  if (elapsedUs > maxIterationUs) maxIterationUs = elapsedUs;
+  if (rxBacklog > maxBacklog) maxBacklog = rxBacklog;
+  if (elapsedUs > windowMaxUs) windowMaxUs = elapsedUs;
+  if (rxBacklog > windowMaxBacklog) windowMaxBacklog = rxBacklog;
+  
+  unsigned long now = Hal::millis();
+  LoadStage required = requiredStage(budgetUs);
+  
+  // Escalate as soon as the pressure shows up, without waiting for the window
+  if (required > stage) {
+    changeStage(required);
+    calmWindows = 0;
+  }
+  
+  if (now - windowStartTime < LOAD_WINDOW_MS) {
+    return;
+  }
+  
+  if (required < stage) {
+    if (++calmWindows >= LOAD_RECOVER_WINDOWS) {
+      changeStage((LoadStage)(stage - 1));
+      calmWindows = 0;
+    }
+  } else {
+    calmWindows = 0;
+  }
+  
+  windowStartTime = now;
+  windowMaxUs = 0;
+  windowMaxBacklog = 0;
+}
+
+const char* LoadSupervisor::stageName(LoadStage stage) {
+  switch (stage) {
+    case LOAD_NORMAL: return "normal";
+    case LOAD_SLOW_DISPLAY: return "slow display";
+    case LOAD_QUIET: return "quiet";
+    case LOAD_DEFER_MESH: return "defer mesh";
+    default: return "?";
+  }
+}
+
+void LoadSupervisor::printStatus() const {
+  Serial.printf("Load: %s, %lu loops, %lu over budget, worst %lu ms, max backlog %u B, "
+                "%lu degradations (%lu/%lu/%lu), %lu recoveries\n",
+    stageName(stage), iterations, overruns, maxIterationUs / 1000, (unsigned)maxBacklog,
+    degradations, degradationsTo[LOAD_SLOW_DISPLAY], degradationsTo[LOAD_QUIET],
+    degradationsTo[LOAD_DEFER_MESH], recoveries);
+}
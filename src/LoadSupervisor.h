@@ -0,0 +1,74 @@
+#ifndef LOADSUPERVISOR_H
+#define LOADSUPERVISOR_H
+
+#include <Arduino.h>
+
+// Service levels, each one keeps the restrictions of the previous ones.
+// Radar frame processing, presence reports and safety alerts are never shed.
+enum LoadStage : uint8_t {
+  LOAD_NORMAL = 0,      // Full service
+  LOAD_SLOW_DISPLAY,    // Display refreshed every LOAD_SLOW_DISPLAY_MS
+  LOAD_QUIET,           // Periodic status and payload logging suppressed
+  LOAD_DEFER_MESH,      // Summaries, trajectories and heatmap fragments wait
+  LOAD_STAGE_COUNT
+};
+
+// Display refresh interval while degraded
+static constexpr unsigned long LOAD_SLOW_DISPLAY_MS = 2000;
+
+// Watches how long each loop() iteration takes and how many radar bytes are
+// still waiting in the UART, and sheds optional work in stages when either
+// runs over. Pressure is judged per one second window: the worst iteration
+// and the largest backlog of the window map to the stage that is needed.
+// Escalation is immediate; recovery goes back one stage at a time once the
+// pressure stayed below the current stage for LOAD_RECOVER_WINDOWS windows.
+class LoadSupervisor {
+private:
+  LoadStage stage;
+  unsigned long iterationStartUs;
+  
+  // Current window
+  unsigned long windowStartTime;
+  unsigned long windowMaxUs;
+  size_t windowMaxBacklog;
+  uint8_t calmWindows;
+  
+  // Statistics since boot
+  unsigned long iterations;
+  unsigned long overruns;                 // Iterations longer than the budget
+  unsigned long maxIterationUs;
+  size_t maxBacklog;
+  unsigned long degradations;             // Stage increases
+  unsigned long recoveries;               // Stage decreases
+  unsigned long degradationsTo[LOAD_STAGE_COUNT];
+  
+  // Helper functions
+  LoadStage requiredStage(unsigned long budgetUs) const;
+  void changeStage(LoadStage next);
+
+public:
+  LoadSupervisor();
+  
+  // Bracket the work of one loop() iteration (not its idle delay).
+  // rxBacklog is the number of radar bytes left unparsed at the end
+  void beginIteration();
+  void endIteration(size_t rxBacklog, unsigned long budgetMs);
+  
+  LoadStage getStage() const { return stage; }
+  unsigned long displayInterval(unsigned long normalMs) const {
+    return stage >= LOAD_SLOW_DISPLAY ? LOAD_SLOW_DISPLAY_MS : normalMs;
+  }
+  bool statusOutputAllowed() const { return stage < LOAD_QUIET; }
+  bool deferrableMeshAllowed() const { return stage < LOAD_DEFER_MESH; }
+  
+  // Status
+  unsigned long getDegradations() const { return degradations; }
+  unsigned long getRecoveries() const { return recoveries; }
+  unsigned long getOverruns() const { return overruns; }
+  static const char* stageName(LoadStage stage);
+  void printStatus() const;
+};
+
+extern LoadSupervisor loadSupervisor;
+
+#endif // LOADSUPERVISOR_H
@@ -0,0 +1,373 @@
+#ifndef MACTABLE_H
+#define MACTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity containers keyed by a Bluetooth device address.
+//
+// Addresses are packed into the low 48 bits of an integer, so a lookup is a
+// hash, a few integer compares and no allocation. The index uses open
+// addressing with linear probing at a load factor of at most 1/2 and
+// backward-shift deletion (no tombstones), so probe chains stay short no
+// matter how often beacons come and go.
+// Plain C++11 only, so it builds for the firmware and the native simulation.
+
+// First octet of the text form in the most significant byte.
+// 00:00:00:00:00:00 is not a usable address and marks free slots
+typedef uint64_t MacKey;
+
+static constexpr MacKey MAC_KEY_NONE = 0;
+static constexpr size_t MAC_STRING_LEN = 17;   // "aa:bb:cc:dd:ee:ff"
+
+//========================= Address helpers =========================
+inline MacKey packMac(const uint8_t* bytes) {
+  MacKey key = 0;
+  for (int i = 0; i < 6; i++) {
+    key = (key << 8) | bytes[i];
+  }
+  return key;
+}
+
+inline void unpackMac(MacKey key, uint8_t* bytes) {
+  for (int i = 5; i >= 0; i--) {
+    bytes[i] = key & 0xFF;
+    key >>= 8;
+  }
+}
+
+inline int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Parse "aa:bb:cc:dd:ee:ff" in any case, with ':' or '-' separators.
+// Returns false on malformed input and for the all-zero address
+inline bool parseMac(const char* s, MacKey& out) {
+  if (!s) return false;
+  MacKey key = 0;
+  for (int i = 0; i < 6; i++) {
+    int hi = hexNibble(s[0]);
+    int lo = hi < 0 ? -1 : hexNibble(s[1]);
+    if (lo < 0) return false;
+    key = (key << 8) | (MacKey)((hi << 4) | lo);
+    s += 2;
+    if (i < 5) {
+      if (*s != ':' && *s != '-') return false;
+      s++;
+    }
+  }
+  if (*s != '\0' || key == MAC_KEY_NONE) return false;
+  out = key;
+  return true;
+}
+
+// Lowercase text form; out must hold MAC_STRING_LEN + 1 bytes
+inline void formatMac(MacKey key, char* out) {
+  static const char digits[] = "0123456789abcdef";
+  for (int i = 0; i < 6; i++) {
+    uint8_t b = (key >> (40 - 8 * i)) & 0xFF;
+    out[3 * i] = digits[b >> 4];
+    out[3 * i + 1] = digits[b & 0x0F];
+    out[3 * i + 2] = i < 5 ? ':' : '\0';
+  }
+}
+
+// Smallest power of two holding n keys at a load factor of at most 1/2
+constexpr size_t macSlotsFor(size_t n, size_t slots = 2) {
+  return slots >= 2 * n ? slots : macSlotsFor(n, slots * 2);
+}
+
+// log2 of a power of two
+constexpr unsigned macSlotBits(size_t slots) {
+  return slots <= 1 ? 0 : 1 + macSlotBits(slots / 2);
+}
+
+//========================= Index =========================
+// Open-addressing map from address to a small value (a pool index)
+template <size_t SLOTS>
+class MacIndex {
+  static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "MacIndex size must be a power of two");
+  static_assert(SLOTS <= 0x10000, "MacIndex slots must fit 16 bits");
+  
+  static constexpr unsigned SLOT_BITS = macSlotBits(SLOTS);
+
+private:
+  MacKey keys[SLOTS];
+  uint16_t values[SLOTS];
+  
+  // Slot holding key, or the free slot where it would go
+  size_t probe(MacKey key) const {
+    size_t i = home(key);
+    while (keys[i] != MAC_KEY_NONE && keys[i] != key) {
+      i = (i + 1) & (SLOTS - 1);
+    }
+    return i;
+  }
+
+public:
+  MacIndex() { clear(); }
+  
+  // Fold the 48 bits into 32, then Fibonacci hashing keeps the high bits:
+  // the low bits of the product only depend on the low bits of the input,
+  // so addresses that differ in their upper octets would share a home slot
+  static size_t home(MacKey key) {
+    uint32_t h = ((uint32_t)key ^ (uint32_t)(key >> 32) * 0x85EBCA6Bu) * 0x9E3779B1u;
+    return (size_t)(h >> (32 - SLOT_BITS));
+  }
+  
+  void clear() {
+    for (size_t i = 0; i < SLOTS; i++) {
+      keys[i] = MAC_KEY_NONE;
+      values[i] = 0;
+    }
+  }
+  
+  bool find(MacKey key, uint16_t& value) const {
+    size_t i = probe(key);
+    if (keys[i] == MAC_KEY_NONE) return false;
+    value = values[i];
+    return true;
+  }
+  
+  // The owner keeps the load factor at or below 1/2, so a free slot exists
+  void insert(MacKey key, uint16_t value) {
+    size_t i = probe(key);
+    keys[i] = key;
+    values[i] = value;
+  }
+  
+  bool remove(MacKey key) {
+    size_t i = probe(key);
+    if (keys[i] == MAC_KEY_NONE) return false;
+    
+    // Backward shift: pull later entries of the chain into the hole unless
+    // that would move them in front of their home slot
+    size_t j = i;
+    for (;;) {
+      j = (j + 1) & (SLOTS - 1);
+      if (keys[j] == MAC_KEY_NONE) break;
+      size_t k = home(keys[j]);
+      bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+      if (stays) continue;
+      keys[i] = keys[j];
+      values[i] = values[j];
+      i = j;
+    }
+    keys[i] = MAC_KEY_NONE;
+    return true;
+  }
+  
+  // Raw slot access for iteration
+  static constexpr size_t slots() { return SLOTS; }
+  MacKey keyAt(size_t slot) const { return keys[slot]; }
+};
+
+//========================= Set =========================
+// Address set with room for N entries, e.g. the beacon whitelist.
+// version() changes on every modification so cached membership can be
+// refreshed lazily
+template <size_t N>
+class MacSet {
+  static_assert(N > 0 && N <= 255, "MacSet capacity must fit the index value");
+
+private:
+  MacIndex<macSlotsFor(N)> index;
+  uint8_t count;
+  uint16_t changes;
+
+public:
+  MacSet() : count(0), changes(0) {}
+  
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  uint16_t version() const { return changes; }
+  
+  bool contains(MacKey key) const {
+    uint16_t unused;
+    return index.find(key, unused);
+  }
+  
+  // Returns false if the set is full; adding a present key succeeds
+  bool add(MacKey key) {
+    if (key == MAC_KEY_NONE) return false;
+    if (contains(key)) return true;
+    if (count >= N) return false;
+    index.insert(key, 0);
+    count++;
+    changes++;
+    return true;
+  }
+  
+  bool remove(MacKey key) {
+    if (!index.remove(key)) return false;
+    count--;
+    changes++;
+    return true;
+  }
+  
+  void clear() {
+    index.clear();
+    count = 0;
+    changes++;
+  }
+  
+  // fn(MacKey) for every member, in slot order
+  template <typename F>
+  void forEach(F fn) const {
+    for (size_t i = 0; i < index.slots(); i++) {
+      if (index.keyAt(i) != MAC_KEY_NONE) fn(index.keyAt(i));
+    }
+  }
+};
+
+//========================= Table =========================
+// Address -> T map with room for N entries. Entries live in a fixed arena
+// and are recycled through a free list, so pointers stay valid until the
+// entry is removed. Whitelist membership is cached as one bit per arena
+// slot, which makes the per-advertisement filter check a single bit test.
+//
+// Whitelisted addresses always get an entry: other addresses are only
+// inserted while more entries are free than there are whitelisted addresses
+// not in the table yet. If a whitelist change left the arena full anyway, a
+// whitelisted address takes over the entry of a non-whitelisted one
+template <typename T, size_t N>
+class MacTable {
+  static_assert(N > 0 && N < 0xFFFF, "MacTable capacity must fit the index value");
+
+private:
+  MacIndex<macSlotsFor(N)> index;
+  T pool[N];
+  MacKey poolKeys[N];          // MAC_KEY_NONE = arena slot unused
+  uint16_t freeList[N];
+  uint16_t freeCount;
+  uint32_t whitelistBits[(N + 31) / 32];
+  uint16_t whitelistedCount;     // Entries with their whitelist bit set
+  uint16_t whitelistSize;        // Addresses on the whitelist (applyWhitelist())
+  unsigned long insertFailures;  // No entry for a new address
+  unsigned long evictions;       // Entries handed over to whitelisted addresses
+  
+  size_t slotOf(const T* entry) const { return (size_t)(entry - pool); }
+  
+  bool whitelistBit(size_t slot) const {
+    return (whitelistBits[slot >> 5] >> (slot & 31)) & 1;
+  }
+  
+  void setWhitelisted(size_t slot, bool on) {
+    if (on == whitelistBit(slot)) return;
+    if (on) {
+      whitelistBits[slot >> 5] |= 1u << (slot & 31);
+      whitelistedCount++;
+    } else {
+      whitelistBits[slot >> 5] &= ~(1u << (slot & 31));
+      whitelistedCount--;
+    }
+  }
+  
+  // Free a non-whitelisted entry; false if every entry is whitelisted
+  bool evictOther() {
+    for (size_t i = 0; i < N; i++) {
+      if (poolKeys[i] != MAC_KEY_NONE && !whitelistBit(i)) {
+        remove(poolKeys[i]);
+        evictions++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  MacTable() : whitelistedCount(0), whitelistSize(0), insertFailures(0), evictions(0) { clear(); }
+  
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return N - freeCount; }
+  unsigned long getInsertFailures() const { return insertFailures; }
+  unsigned long getEvictions() const { return evictions; }
+  
+  // Free entries held back for whitelisted addresses not in the table yet
+  size_t reserved() const {
+    return whitelistSize > whitelistedCount ? whitelistSize - whitelistedCount : 0;
+  }
+  
+  void clear() {
+    index.clear();
+    for (size_t i = 0; i < N; i++) {
+      poolKeys[i] = MAC_KEY_NONE;
+      freeList[i] = (uint16_t)(N - 1 - i);
+    }
+    freeCount = (uint16_t)N;
+    for (uint32_t& bits : whitelistBits) {
+      bits = 0;
+    }
+    whitelistedCount = 0;
+  }
+  
+  T* find(MacKey key) {
+    uint16_t slot;
+    return index.find(key, slot) ? &pool[slot] : nullptr;
+  }
+  
+  // Existing entry for key, or a freshly reset one. Returns nullptr when
+  // there is no entry to spare for key; created tells the caller to
+  // initialise the entry
+  T* findOrInsert(MacKey key, bool whitelisted, bool* created = nullptr) {
+    if (created) *created = false;
+    T* entry = find(key);
+    if (entry || key == MAC_KEY_NONE) return entry;
+    bool room = whitelisted ? (freeCount > 0 || evictOther()) : freeCount > reserved();
+    if (!room) {
+      insertFailures++;
+      return nullptr;
+    }
+    
+    uint16_t slot = freeList[--freeCount];
+    pool[slot] = T();
+    poolKeys[slot] = key;
+    setWhitelisted(slot, whitelisted);
+    index.insert(key, slot);
+    if (created) *created = true;
+    return &pool[slot];
+  }
+  
+  bool remove(MacKey key) {
+    uint16_t slot;
+    if (!index.find(key, slot)) return false;
+    index.remove(key);
+    poolKeys[slot] = MAC_KEY_NONE;
+    setWhitelisted(slot, false);
+    freeList[freeCount++] = slot;
+    return true;
+  }
+  
+  MacKey keyOf(const T* entry) const { return poolKeys[slotOf(entry)]; }
+  
+  // Arena position 0..N-1 of an entry, stable while it is in the table
+  size_t indexOf(const T* entry) const { return slotOf(entry); }
+  MacKey keyAtIndex(size_t index) const { return poolKeys[index]; }
+  
+  bool isWhitelisted(const T* entry) const { return whitelistBit(slotOf(entry)); }
+  
+  // Recompute the cached membership bits and the reservation after the
+  // whitelist changed
+  template <size_t M>
+  void applyWhitelist(const MacSet<M>& whitelist) {
+    static_assert(M < N, "The whitelist must leave room for other addresses");
+    whitelistSize = (uint16_t)whitelist.size();
+    for (size_t i = 0; i < N; i++) {
+      setWhitelisted(i, poolKeys[i] != MAC_KEY_NONE && whitelist.contains(poolKeys[i]));
+    }
+  }
+  
+  // fn(MacKey, T&) for every entry, in arena order
+  template <typename F>
+  void forEach(F fn) {
+    for (size_t i = 0; i < N; i++) {
+      if (poolKeys[i] != MAC_KEY_NONE) fn(poolKeys[i], pool[i]);
+    }
+  }
+};
+
+#endif // MACTABLE_H
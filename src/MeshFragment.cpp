@@ -0,0 +1,325 @@
+#include "MeshFragment.h"
+#include "MeshtasticComm.h"
+#include "Crc16.h"
+#include "Hal.h"
+
+// Global instance
+MeshFragments meshFragments;
+
+static void putU16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static uint16_t getU16(const uint8_t* in) {
+  return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint8_t allFragments(uint8_t count) {
+  return (uint8_t)((1u << count) - 1);
+}
+
+static int countBits(uint8_t bits) {
+  int n = 0;
+  for (; bits; bits &= bits - 1) n++;
+  return n;
+}
+
+size_t encodeFragment(uint8_t* out, size_t cap, uint16_t id, uint8_t index,
+                      const uint8_t* message, size_t len, uint16_t crc) {
+  size_t offset = (size_t)index * FRAG_DATA_SIZE;
+  if (offset >= len) {
+    return 0;
+  }
+  size_t chunk = len - offset < FRAG_DATA_SIZE ? len - offset : FRAG_DATA_SIZE;
+  if (FRAG_HEADER_SIZE + chunk > cap) {
+    return 0;
+  }
+  
+  out[0] = MESH_PAYLOAD_VERSION;
+  out[1] = MSG_FRAGMENT;
+  putU16(out + 2, id);
+  out[4] = index;
+  out[5] = fragmentCount(len);
+  putU16(out + 6, (uint16_t)len);
+  putU16(out + 8, crc);
+  memcpy(out + FRAG_HEADER_SIZE, message + offset, chunk);
+  return FRAG_HEADER_SIZE + chunk;
+}
+
+bool decodeFragment(const uint8_t* in, size_t len, FragmentHeader& header,
+                    const uint8_t*& slice, size_t& sliceLen) {
+  if (len <= FRAG_HEADER_SIZE || in[0] != MESH_PAYLOAD_VERSION || in[1] != MSG_FRAGMENT) {
+    return false;
+  }
+  header.id = getU16(in + 2);
+  header.index = in[4];
+  header.count = in[5];
+  header.length = getU16(in + 6);
+  header.crc = getU16(in + 8);
+  slice = in + FRAG_HEADER_SIZE;
+  sliceLen = len - FRAG_HEADER_SIZE;
+  
+  // The layout follows from the length: full slices, a shorter last one
+  if (header.length == 0 || header.length > FRAG_MAX_MESSAGE ||
+      header.count != fragmentCount(header.length) || header.index >= header.count) {
+    return false;
+  }
+  size_t offset = (size_t)header.index * FRAG_DATA_SIZE;
+  size_t expected = header.length - offset < FRAG_DATA_SIZE ? header.length - offset : FRAG_DATA_SIZE;
+  return sliceLen == expected;
+}
+
+size_t encodeFragmentNack(uint8_t* out, size_t cap, uint16_t id, uint8_t count, uint8_t missing) {
+  if (cap < FRAG_NACK_SIZE) {
+    return 0;
+  }
+  out[0] = MESH_PAYLOAD_VERSION;
+  out[1] = MSG_FRAGMENT_NACK;
+  putU16(out + 2, id);
+  out[4] = count;
+  out[5] = missing;
+  return FRAG_NACK_SIZE;
+}
+
+bool decodeFragmentNack(const uint8_t* in, size_t len, uint16_t& id, uint8_t& count, uint8_t& missing) {
+  if (len != FRAG_NACK_SIZE || in[0] != MESH_PAYLOAD_VERSION || in[1] != MSG_FRAGMENT_NACK) {
+    return false;
+  }
+  id = getU16(in + 2);
+  count = in[4];
+  missing = in[5];
+  return count >= 1 && count <= FRAG_MAX_COUNT;
+}
+
+MeshFragments::MeshFragments()
+  : rxActive(false), rxNode(0), rxChannel(0), rxHeader(), rxReceived(0), rxRequests(0),
+    rxNackDue(false), rxLastTime(0), rxNackTime(0),
+    doneValid(false), doneNode(0), doneChannel(0), doneHeader(), doneTime(0), ackDue(false),
+    txLen(0), txActive(false), txNode(0), txChannel(0), txId(0), txCrc(0), txCount(0),
+    txPending(0), txProbes(0), txWaitStart(0), nextTxId(0),
+    messagesIn(0), messagesOut(0), failedOut(0), droppedIn(0), nacksSent(0), fragmentsResent(0) {
+}
+
+bool MeshFragments::isFragmentPayload(const uint8_t* data, size_t len) {
+  return len >= MESH_PAYLOAD_HEADER_SIZE && data[0] == MESH_PAYLOAD_VERSION &&
+         (data[1] == MSG_FRAGMENT || data[1] == MSG_FRAGMENT_NACK);
+}
+
+void MeshFragments::onPayload(const uint8_t* data, size_t len, uint32_t fromNode, uint8_t channel,
+                              unsigned long now) {
+  FragmentHeader header;
+  const uint8_t* slice;
+  size_t sliceLen;
+  uint16_t id;
+  uint8_t count;
+  uint8_t missing;
+  
+  if (decodeFragment(data, len, header, slice, sliceLen)) {
+    onFragment(header, slice, sliceLen, fromNode, channel, now);
+  } else if (decodeFragmentNack(data, len, id, count, missing)) {
+    onNack(id, count, missing, fromNode, now);
+  } else {
+    Serial.printf("FRAG: Malformed %u byte payload from 0x%08lx ignored\n",
+                  (unsigned)len, (unsigned long)fromNode);
+  }
+}
+
+void MeshFragments::onFragment(const FragmentHeader& header, const uint8_t* slice, size_t sliceLen,
+                               uint32_t fromNode, uint8_t channel, unsigned long now) {
+  // Repeated fragment of a message already delivered: our ACK got lost
+  if (doneValid && fromNode == doneNode && header.id == doneHeader.id &&
+      header.length == doneHeader.length && header.crc == doneHeader.crc) {
+    ackDue = true;
+    return;
+  }
+  
+  bool sameMessage = rxActive && fromNode == rxNode && header.id == rxHeader.id &&
+                     header.length == rxHeader.length && header.crc == rxHeader.crc;
+  if (rxActive && !sameMessage) {
+    if (fromNode != rxNode) {
+      // One message at a time; the other sender probes again later
+      return;
+    }
+    Serial.printf("FRAG: Message #%u from 0x%08lx replaced by #%u\n",
+                  rxHeader.id, (unsigned long)rxNode, header.id);
+    droppedIn++;
+    rxActive = false;
+  }
+  
+  if (!rxActive) {
+    rxActive = true;
+    rxNode = fromNode;
+    rxChannel = channel;
+    rxHeader = header;
+    rxReceived = 0;
+    rxRequests = 0;
+    rxNackDue = false;
+    rxNackTime = now;
+  }
+  
+  memcpy(rxData + (size_t)header.index * FRAG_DATA_SIZE, slice, sliceLen);
+  rxReceived |= (uint8_t)(1u << header.index);
+  rxLastTime = now;
+  
+  if (rxReceived == allFragments(rxHeader.count)) {
+    completeMessage(now);
+  } else if (header.index == rxHeader.count - 1) {
+    // The sender is done for now - ask for the gaps right away
+    rxNackDue = true;
+  }
+}
+
+void MeshFragments::completeMessage(unsigned long now) {
+  if (crc16(rxData, rxHeader.length) != rxHeader.crc) {
+    // Fragments from different attempts do not fit together - start over
+    Serial.printf("FRAG: Message #%u from 0x%08lx failed its CRC\n",
+                  rxHeader.id, (unsigned long)rxNode);
+    rxReceived = 0;
+    rxNackDue = true;
+    return;
+  }
+  
+  rxActive = false;
+  rxNackDue = false;
+  doneValid = true;
+  doneNode = rxNode;
+  doneChannel = rxChannel;
+  doneHeader = rxHeader;
+  doneTime = now;
+  ackDue = true;
+  messagesIn++;
+  
+  Serial.printf("FRAG: Message #%u from 0x%08lx complete (%u bytes in %u fragments)\n",
+                rxHeader.id, (unsigned long)rxNode, rxHeader.length, rxHeader.count);
+  processReceivedJSON((const char*)rxData, rxHeader.length, rxNode, rxChannel);
+}
+
+void MeshFragments::onNack(uint16_t id, uint8_t count, uint8_t missing, uint32_t fromNode,
+                           unsigned long now) {
+  if (!txActive || fromNode != txNode || id != txId || count != txCount) {
+    return;
+  }
+  
+  missing &= allFragments(txCount);
+  if (missing == 0) {
+    Serial.printf("FRAG: Message #%u delivered to 0x%08lx\n", txId, (unsigned long)txNode);
+    messagesOut++;
+    txActive = false;
+    return;
+  }
+  
+  // Only what was handed over already is sent again. The receiver limits
+  // its own requests, so every answer allows a new round of probes
+  uint8_t resend = missing & ~txPending;
+  fragmentsResent += countBits(resend);
+  txPending |= missing;
+  txProbes = 0;
+  txWaitStart = now;
+  Serial.printf("FRAG: Message #%u: 0x%08lx is missing fragments 0x%02x\n",
+                txId, (unsigned long)txNode, missing);
+}
+
+bool MeshFragments::sendNack(uint32_t node, uint8_t channel, uint16_t id, uint8_t count, uint8_t missing) {
+  uint8_t nack[FRAG_NACK_SIZE];
+  size_t len = encodeFragmentNack(nack, sizeof(nack), id, count, missing);
+  if (len == 0 || !sendMeshPayloadTo(node, channel, nack, len, false)) {
+    return false;
+  }
+  nacksSent++;
+  return true;
+}
+
+void MeshFragments::poll(unsigned long now) {
+  // Receiving: request gaps after a quiet spell, give up on stale messages
+  if (rxActive) {
+    if (now - rxLastTime > FRAG_TIMEOUT_MS) {
+      Serial.printf("FRAG: Message #%u from 0x%08lx timed out (fragments 0x%02x of %u)\n",
+                    rxHeader.id, (unsigned long)rxNode, rxReceived, rxHeader.count);
+      droppedIn++;
+      rxActive = false;
+    } else if (now - rxLastTime > FRAG_GAP_MS && now - rxNackTime > FRAG_GAP_MS) {
+      rxNackDue = true;
+    }
+  }
+  
+  if (rxActive && rxNackDue) {
+    if (rxRequests >= FRAG_MAX_REQUESTS) {
+      rxNackDue = false;  // Wait for the timeout or the sender's probe
+    } else if (sendNack(rxNode, rxChannel, rxHeader.id, rxHeader.count,
+                        allFragments(rxHeader.count) & ~rxReceived)) {
+      rxRequests++;
+      rxNackDue = false;
+      rxNackTime = now;
+    }
+  }
+  
+  if (doneValid && now - doneTime > FRAG_TIMEOUT_MS) {
+    doneValid = false;
+    ackDue = false;
+  }
+  if (ackDue && sendNack(doneNode, doneChannel, doneHeader.id, doneHeader.count, 0)) {
+    ackDue = false;
+  }
+  
+  // Sending: no answer to the last fragment - repeat it a few times
+  if (txActive && txPending == 0 && now - txWaitStart > FRAG_REPLY_WAIT_MS) {
+    if (txProbes < FRAG_MAX_REQUESTS) {
+      txProbes++;
+      txPending = (uint8_t)(1u << (txCount - 1));
+      fragmentsResent++;
+    } else {
+      Serial.printf("FRAG: Message #%u to 0x%08lx not answered - giving up\n",
+                    txId, (unsigned long)txNode);
+      failedOut++;
+      txActive = false;
+    }
+  }
+}
+
+bool MeshFragments::send(uint32_t node, uint8_t channel, const uint8_t* data, size_t len) {
+  if (txActive || len == 0 || len > FRAG_MAX_MESSAGE) {
+    return false;
+  }
+  
+  if (nextTxId == 0) {
+    nextTxId = (uint16_t)((Hal::millis() * 2654435761UL) >> 16) | 1;  // Differ across reboots
+  }
+  memcpy(txData, data, len);
+  txLen = len;
+  txNode = node;
+  txChannel = channel;
+  txId = nextTxId++;
+  txCrc = crc16(txData, txLen);
+  txCount = fragmentCount(txLen);
+  txPending = allFragments(txCount);
+  txProbes = 0;
+  txActive = true;
+  
+  Serial.printf("FRAG: Message #%u to 0x%08lx: %u bytes in %u fragments\n",
+                txId, (unsigned long)node, (unsigned)len, txCount);
+  return true;
+}
+
+size_t MeshFragments::encodeNextFragment(uint8_t* out, size_t cap) const {
+  if (!sendPending()) {
+    return 0;
+  }
+  uint8_t index = 0;
+  while (!(txPending & (1u << index))) index++;
+  return encodeFragment(out, cap, txId, index, txData, txLen, txCrc);
+}
+
+void MeshFragments::fragmentSent(unsigned long now) {
+  txPending &= txPending - 1;  // Lowest pending index went out
+  if (txPending == 0) {
+    txWaitStart = now;
+  }
+}
+
+void MeshFragments::printStatus() const {
+  if (messagesIn + messagesOut + failedOut + droppedIn == 0 && !rxActive && !txActive) return;
+  Serial.printf("Fragments: %lu messages in (%lu dropped), %lu out (%lu failed), "
+                "%lu NACKs sent, %lu fragments resent\n",
+    messagesIn, droppedIn, messagesOut, failedOut, nacksSent, fragmentsResent);
+}
@@ -0,0 +1,156 @@
+#ifndef MESHFRAGMENT_H
+#define MESHFRAGMENT_H
+
+#include <Arduino.h>
+#include "MeshPayload.h"
+#include "MeshtasticProto.h"
+
+// Fragment header: version, type, message id (2), index, count, length (2), CRC (2)
+static constexpr size_t FRAG_HEADER_SIZE = MESH_PAYLOAD_HEADER_SIZE + 8;
+static constexpr size_t FRAG_NACK_SIZE = MESH_PAYLOAD_HEADER_SIZE + 4;
+
+// Message bytes per fragment; every fragment but the last one is full
+static constexpr size_t FRAG_DATA_SIZE = MeshProto::MAX_DATA_PAYLOAD - FRAG_HEADER_SIZE;
+
+// Longest message in either direction; the largest is the heatmap export
+// (HEATMAP_EXPORT_MAX, 1205 bytes)
+static constexpr size_t FRAG_MAX_MESSAGE = 1280;
+static constexpr size_t FRAG_MAX_COUNT = (FRAG_MAX_MESSAGE + FRAG_DATA_SIZE - 1) / FRAG_DATA_SIZE;
+static_assert(FRAG_MAX_COUNT <= 8, "Missing fragments are reported in one bitmap byte");
+
+// Receiver: quiet time before missing fragments are requested
+static constexpr unsigned long FRAG_GAP_MS = 8000;
+
+// Sender: wait for the receiver's answer before probing with the last fragment
+static constexpr unsigned long FRAG_REPLY_WAIT_MS = 20000;
+
+// Receiver: drop a partial message after this long without a fragment
+static constexpr unsigned long FRAG_TIMEOUT_MS = 60000;
+
+// Requests for missing fragments (receiver) and probes (sender) per message
+static constexpr uint8_t FRAG_MAX_REQUESTS = 3;
+
+// JSON document for mesh commands, sized for a full reassembled message
+static constexpr size_t MESH_COMMAND_JSON_CAPACITY = FRAG_MAX_MESSAGE + FRAG_MAX_MESSAGE / 2;
+
+// Decoded MSG_FRAGMENT header
+struct FragmentHeader {
+  uint16_t id;
+  uint8_t index;
+  uint8_t count;
+  uint16_t length;    // Whole message
+  uint16_t crc;       // Whole message
+};
+
+// Fragments needed for a message of len bytes
+inline uint8_t fragmentCount(size_t len) {
+  return len == 0 ? 0 : (uint8_t)((len + FRAG_DATA_SIZE - 1) / FRAG_DATA_SIZE);
+}
+
+// Fragment and NACK codec, shared with the simulated far end.
+// The encoders return the encoded length, 0 if cap is too small
+size_t encodeFragment(uint8_t* out, size_t cap, uint16_t id, uint8_t index,
+                      const uint8_t* message, size_t len, uint16_t crc);
+bool decodeFragment(const uint8_t* in, size_t len, FragmentHeader& header,
+                    const uint8_t*& slice, size_t& sliceLen);
+size_t encodeFragmentNack(uint8_t* out, size_t cap, uint16_t id, uint8_t count, uint8_t missing);
+bool decodeFragmentNack(const uint8_t* in, size_t len, uint16_t& id, uint8_t& count, uint8_t& missing);
+
+// Messages longer than one mesh packet, in both directions.
+//
+// A message is split into MSG_FRAGMENT packets that carry the message id,
+// their index, the fragment count and a CRC of the whole message. The
+// receiver reassembles one message at a time in a static buffer and answers
+// with MSG_FRAGMENT_NACK: the bitmap of fragments it is still missing, sent
+// as soon as the last fragment arrived with gaps or after FRAG_GAP_MS
+// without progress, or an empty bitmap once the CRC checked out. Only the
+// listed fragments are sent again. A sender that hears nothing repeats the
+// last fragment, which makes the receiver answer again. Partial messages
+// are dropped after FRAG_TIMEOUT_MS, and a new message from the same node
+// replaces the one in progress.
+//
+// Reassembled commands go to processReceivedJSON(); replies (configuration
+// readout, heatmap export) are queued with send() and handed to the radio by
+// the main loop one fragment at a time.
+class MeshFragments {
+private:
+  // Message being reassembled
+  uint8_t rxData[FRAG_MAX_MESSAGE];
+  bool rxActive;
+  uint32_t rxNode;
+  uint8_t rxChannel;
+  FragmentHeader rxHeader;      // Index unused
+  uint8_t rxReceived;           // Bitmap of fragments received
+  uint8_t rxRequests;           // NACKs sent for this message
+  bool rxNackDue;
+  unsigned long rxLastTime;     // Last fragment received
+  unsigned long rxNackTime;     // Last NACK sent
+  
+  // Last completed message; duplicates of it are only acknowledged again
+  bool doneValid;
+  uint32_t doneNode;
+  uint8_t doneChannel;
+  FragmentHeader doneHeader;
+  unsigned long doneTime;
+  bool ackDue;
+  
+  // Message being sent
+  uint8_t txData[FRAG_MAX_MESSAGE];
+  size_t txLen;
+  bool txActive;
+  uint32_t txNode;
+  uint8_t txChannel;
+  uint16_t txId;
+  uint16_t txCrc;
+  uint8_t txCount;
+  uint8_t txPending;            // Bitmap of fragments still to hand to the radio
+  uint8_t txProbes;
+  unsigned long txWaitStart;    // All fragments handed over, waiting for the answer
+  uint16_t nextTxId;
+  
+  unsigned long messagesIn;
+  unsigned long messagesOut;
+  unsigned long failedOut;      // Sends given up without an answer
+  unsigned long droppedIn;      // Partial messages timed out, replaced or corrupt
+  unsigned long nacksSent;
+  unsigned long fragmentsResent;
+  
+  // Helper functions
+  void onFragment(const FragmentHeader& header, const uint8_t* slice, size_t sliceLen,
+                  uint32_t fromNode, uint8_t channel, unsigned long now);
+  void onNack(uint16_t id, uint8_t count, uint8_t missing, uint32_t fromNode, unsigned long now);
+  void completeMessage(unsigned long now);
+  bool sendNack(uint32_t node, uint8_t channel, uint16_t id, uint8_t count, uint8_t missing);
+
+public:
+  MeshFragments();
+  
+  // MSG_FRAGMENT or MSG_FRAGMENT_NACK payload
+  static bool isFragmentPayload(const uint8_t* data, size_t len);
+  
+  // Feed a fragment or NACK received from the mesh
+  void onPayload(const uint8_t* data, size_t len, uint32_t fromNode, uint8_t channel, unsigned long now);
+  
+  // Timers: NACK retries, stale partial messages, unanswered sends.
+  // Call this every loop iteration
+  void poll(unsigned long now);
+  
+  // Queue a message for node/channel; false while another one is being sent
+  bool send(uint32_t node, uint8_t channel, const uint8_t* data, size_t len);
+  
+  bool sendPending() const { return txActive && txPending != 0; }
+  uint32_t getSendNode() const { return txNode; }
+  uint8_t getSendChannel() const { return txChannel; }
+  
+  // Encode the next fragment to send; call fragmentSent() once the radio
+  // accepted it. Returns the encoded length, 0 if cap is too small
+  size_t encodeNextFragment(uint8_t* out, size_t cap) const;
+  void fragmentSent(unsigned long now);
+  
+  // Status
+  void printStatus() const;
+};
+
+extern MeshFragments meshFragments;
+
+#endif // MESHFRAGMENT_H
@@ -0,0 +1,107 @@
+#ifndef MESHPAYLOAD_H
+#define MESHPAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary payloads the gateway sends on its private Meshtastic port.
+// Every payload starts with a two byte header: format version, message type.
+// Multi-byte integers are little-endian.
+static constexpr uint8_t MESH_PAYLOAD_VERSION = 1;
+static constexpr uint8_t MESH_PAYLOAD_HEADER_SIZE = 2;
+
+enum MeshMessageType : uint8_t {
+  // Presence state after a transition (summary mode: safety zone entries,
+  // actual or predicted, only)
+  //   [2] present bitmask (bit i = target i+1)
+  //   [3] target count N
+  //   [4..5] closest distance cm (600 = none)
+  //   [6..] N x target distance cm (0 = not present)
+  //   [..] device name length + bytes
+  //   [..] N x time to safety zone in 0.1 s (0 = inside, 0xFF = not approaching)
+  MSG_PRESENCE = 0x01,
+  
+  // Reply to a configuration command
+  //   [2] status (1 = ok, 0 = fail)
+  //   [3] target name length + bytes
+  MSG_CONFIG_ACK = 0x02,
+  
+  // Occupancy summary for one reporting window (0.1 s = time unit "ds")
+  //   [2..3] window length s
+  //   [4..5] zone occupied ds (any target present)
+  //   [6..7] mean occupancy, persons in 8.8 fixed point
+  //   [8..9] entries
+  //   [10..11] closest approach cm (0xFFFF = none)
+  //   [12..13] safety zone occupied ds
+  //   [14..15] safety zone entries (alerts)
+  //   [16] max simultaneous targets
+  //   [17] target count N
+  //   [18..] N x (occupied ds u16, entries u8, closest approach cm u16)
+  //   [..] device name length + bytes
+  MSG_SUMMARY = 0x03,
+  
+  // Exported occupancy heatmap (see OccupancyHeatmap.h). Never a packet of
+  // its own: the whole message travels as MSG_FRAGMENT packets
+  //   [2] columns, [3] rows, [4] cell size cm
+  //   [5..] compressed grid, row-major varints: (n << 1) = n empty cells,
+  //         (v << 1) | 1 = one cell with count v
+  MSG_HEATMAP = 0x04,
+  
+  // Simplified walking paths (key points, see TrajectoryStreamer.h)
+  //   [2] section count
+  //   per section: header (slot | 0x04 track start | 0x08 track end),
+  //   point count n, then n points of three varints:
+  //     first: age at send time in 0.1 s, x cm (zigzag), y cm (zigzag)
+  //     next:  0.1 s since previous point, dx cm (zigzag), dy cm (zigzag)
+  MSG_TRACK = 0x05,
+  
+  // Beacon identities of the radar targets (see BeaconFusion.h)
+  //   [2] target count N
+  //   [3..] N x (confidence u8: frames matched, capped at 255, 0 = anonymous;
+  //         beacon address, 6 bytes in text order, all zero = anonymous)
+  MSG_IDENTITY = 0x06,
+  
+  // Replayed presence events from the event journal (see EventJournal.h),
+  // oldest first; sequence numbers are consecutive within a batch
+  //   [2..3] boot number the events were recorded in
+  //   [4..7] sequence number of the first event
+  //   [8..9] current boot number, [10..13] current uptime ms: when both boot
+  //          numbers match, event age = current uptime - event uptime
+  //   [14] event count N
+  //   [15..] N x (varint uptime ms, the first absolute, then delta to the
+  //          previous event; kind << 2 | target index (kind: 0 exit,
+  //          1 entry, 2 safety zone alert); varint distance cm)
+  MSG_EVENTS = 0x07,
+  
+  // One fragment of a message longer than a packet, in either direction
+  // (see MeshFragment.h)
+  //   [2..3] message id, [4] fragment index, [5] fragment count
+  //   [6..7] message length, [8..9] CRC-16/CCITT-FALSE of the whole message
+  //   [10..] slice of the message; every fragment but the last is full
+  // A message is JSON text (commands, configuration readout) or a binary
+  // payload starting with version and type (heatmap export)
+  MSG_FRAGMENT = 0x08,
+  
+  // Receiver's answer to MSG_FRAGMENT, sent back to the node the fragments
+  // came from
+  //   [2..3] message id, [4] fragment count
+  //   [5] bitmap of missing fragments (bit i = index i); 0 = message
+  //       received and its CRC checked
+  MSG_FRAGMENT_NACK = 0x09
+};
+
+// Protobuf-style varint into a payload buffer, dropped once the buffer is full
+static inline void payloadPutVarint(uint8_t* out, size_t& pos, size_t cap, uint32_t value) {
+  while (value >= 0x80 && pos < cap) {
+    out[pos++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  if (pos < cap) out[pos++] = (uint8_t)value;
+}
+
+// Signed values are zigzag-mapped before varint encoding (0, -1, 1, -2 ...)
+static inline uint32_t payloadZigZag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+#endif // MESHPAYLOAD_H
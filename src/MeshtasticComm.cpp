@@ -1,116 +1,437 @@
 #include "MeshtasticComm.h"
+#include "MeshtasticProto.h"
+#include "MeshPayload.h"
+#include "MeshFragment.h"
 #include "ConfigManager.h"
 #include "LD2450Manager.h"
+#include "OccupancyHeatmap.h"
+#include "Hal.h"
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 // Global serial interface for Meshtastic (UART1)
 HardwareSerial* MeshtasticSerial = nullptr;
 
-// Message buffer
-std::string receivedChars;
-unsigned long lastCharTime = 0;
-const unsigned long CHAR_TIMEOUT = 100;  // 100ms timeout
+// Link timing
+const unsigned long FRAME_TIMEOUT = 100;           // Drop a partial frame after 100ms silence
+const unsigned long HANDSHAKE_RETRY_MS = 10000;    // Re-request config until the radio answers
+const unsigned long HEARTBEAT_INTERVAL_MS = 60000; // Keep the radio in API mode
+const unsigned long MESH_ACK_TIMEOUT_MS = 60000;   // Give up waiting for a Routing ACK
+const unsigned long QUEUE_PROBE_MS = 5000;         // Retry a full radio queue without fresh status
+const int MESH_MAX_IN_FLIGHT = 4;                  // Unacknowledged packets at once
+const int MESH_DELIVERY_HISTORY = 8;               // Completed packets remembered for getMeshDelivery()
+
+// RX frame assembly
+enum RxState { RX_START1, RX_START2, RX_LEN_MSB, RX_LEN_LSB, RX_PAYLOAD };
+static RxState rxState = RX_START1;
+static uint8_t rxFrame[MeshProto::MAX_FRAME_PAYLOAD];
+static size_t rxLen = 0;
+static size_t rxPos = 0;
+static unsigned long lastByteTime = 0;
+
+// TX frame (header + ToRadio)
+static uint8_t txFrame[MeshProto::FRAME_HEADER_SIZE + MeshProto::MAX_FRAME_PAYLOAD];
+
+// Link state
+static uint32_t configNonce = 0;
+static unsigned long lastHandshakeTime = 0;
+static unsigned long lastTxTime = 0;
+static unsigned long lastQueueStatusTime = 0;
+static uint32_t nextPacketId = 0;
+static MeshStats stats = {};
+
+// Packets waiting for their Routing ACK
+struct InFlightPacket {
+  uint32_t id;
+  unsigned long sentTime;
+};
+static InFlightPacket inFlight[MESH_MAX_IN_FLIGHT];
+static int inFlightCount = 0;
+
+// Outcomes of the most recently completed packets
+struct CompletedPacket {
+  uint32_t id;
+  bool delivered;
+};
+static CompletedPacket completed[MESH_DELIVERY_HISTORY];
+static int completedNext = 0;
+
+static void recordCompletion(uint32_t id, bool delivered) {
+  completed[completedNext].id = id;
+  completed[completedNext].delivered = delivered;
+  completedNext = (completedNext + 1) % MESH_DELIVERY_HISTORY;
+}
+
+static bool writeFrame(size_t len) {
+  if (len == 0) {
+    return false;
+  }
+  MeshProto::writeFrameHeader(txFrame, len);
+  MeshtasticSerial->write(txFrame, MeshProto::FRAME_HEADER_SIZE + len);
+  lastTxTime = Hal::millis();
+  return true;
+}
+
+static void sendWantConfig() {
+  configNonce = (configNonce + 1) | 1;
+  lastHandshakeTime = Hal::millis();
+  writeFrame(MeshProto::encodeToRadioWantConfig(configNonce, txFrame + MeshProto::FRAME_HEADER_SIZE,
+                                                MeshProto::MAX_FRAME_PAYLOAD));
+  Serial.printf("MESH: Requesting radio config (nonce %lu)\n", (unsigned long)configNonce);
+}
+
+static void sendHeartbeat() {
+  writeFrame(MeshProto::encodeToRadioHeartbeat(txFrame + MeshProto::FRAME_HEADER_SIZE,
+                                               MeshProto::MAX_FRAME_PAYLOAD));
+}
+
+static void removeInFlight(int idx) {
+  inFlight[idx] = inFlight[inFlightCount - 1];
+  inFlightCount--;
+}
+
+static int findInFlight(uint32_t id) {
+  for (int i = 0; i < inFlightCount; i++) {
+    if (inFlight[i].id == id) {
+      return i;
+    }
+  }
+  return -1;
+}
 
 void initMeshtasticComm() {
-  MeshtasticSerial = &Serial1;  // Use UART1 (already initialized in main.cpp)
-  Serial.println("Initializing Meshtastic UART communication...");
-  Serial.println("Meshtastic UART initialized");
+  MeshtasticSerial = &Hal::meshUart();  // Use UART1 (already initialized in main.cpp)
+  Serial.println("Initializing Meshtastic serial API...");
+  
+  nextPacketId = (Hal::millis() * 2654435761UL) | 1;
+  rxState = RX_START1;
+  inFlightCount = 0;
+  memset(completed, 0, sizeof(completed));
+  stats = MeshStats();
+  
+  sendWantConfig();
+  Serial.println("Meshtastic serial API initialized (waiting for radio handshake)");
 }
 
-void sendPayloadViaMeshtastic(const String& payload) {
-  Serial.println("UART-DEBUG: Sending payload via Meshtastic:");
-  Serial.println(payload);
-  Serial.printf("Payload size: %d bytes\n", payload.length());
+bool meshCanSend() {
+  return stats.connected && stats.queueFree > 0 && inFlightCount < MESH_MAX_IN_FLIGHT;
+}
+
+uint32_t sendMeshPayloadTo(uint32_t dest, uint8_t channel, const uint8_t* data, size_t len, bool wantAck) {
+  if (!meshCanSend() || len > MeshProto::MAX_DATA_PAYLOAD) {
+    return 0;
+  }
+  
+  MeshProto::OutboundPacket packet;
+  packet.id = nextPacketId++;
+  if (packet.id == 0) packet.id = nextPacketId++;
+  packet.to = dest;
+  packet.channel = channel;
+  packet.port = MeshProto::PORT_PRIVATE;
+  packet.payload = data;
+  packet.payloadLen = len;
+  packet.wantAck = wantAck;
+  packet.hopLimit = 0;
+  
+  size_t encoded = MeshProto::encodeToRadioPacket(packet, txFrame + MeshProto::FRAME_HEADER_SIZE,
+                                                  MeshProto::MAX_FRAME_PAYLOAD);
+  if (!writeFrame(encoded)) {
+    Serial.println("MESH: Packet encoding failed");
+    return 0;
+  }
+  
+  stats.sent++;
+  stats.queueFree--;  // Until the radio reports its queue again
   
-  MeshtasticSerial->println(payload);
+  if (wantAck) {
+    inFlight[inFlightCount].id = packet.id;
+    inFlight[inFlightCount].sentTime = Hal::millis();
+    inFlightCount++;
+  } else {
+    recordCompletion(packet.id, true);
+  }
+  
+  Serial.printf("MESH: Sent packet 0x%08lx (%d bytes) to 0x%08lx ch%d\n",
+                (unsigned long)packet.id, (int)len, (unsigned long)dest, channel);
+  return packet.id;
 }
 
-void checkForMeshtasticCommands() {
-  // Check for incoming data on UART1
-  while (MeshtasticSerial->available()) {
-    char c = MeshtasticSerial->read();
+uint32_t sendMeshPayload(const uint8_t* data, size_t len) {
+  return sendMeshPayloadTo(ConfigManager::getMeshDest(), ConfigManager::getMeshChannel(),
+                           data, len, ConfigManager::getMeshWantAck());
+}
+
+static void handlePacket(const MeshProto::FromRadioMessage& msg) {
+  // Delivery reports for our own packets
+  if (msg.port == MeshProto::PORT_ROUTING && msg.requestId != 0) {
+    int idx = findInFlight(msg.requestId);
+    if (idx >= 0) {
+      recordCompletion(msg.requestId, msg.routingError == 0);
+      if (msg.routingError == 0) {
+        stats.acked++;
+        Serial.printf("MESH: Packet 0x%08lx delivered\n", (unsigned long)msg.requestId);
+      } else {
+        stats.failed++;
+        Serial.printf("MESH: Packet 0x%08lx failed (reason %ld)\n",
+                      (unsigned long)msg.requestId, (long)msg.routingError);
+      }
+      removeInFlight(idx);
+    }
+    return;
+  }
+  
+  // Commands arrive as JSON text on the text message or our private port
+  if ((msg.port == MeshProto::PORT_TEXT_MESSAGE || msg.port == MeshProto::PORT_PRIVATE) &&
+      msg.payload && msg.payloadLen > 0 && msg.from != stats.myNodeNum) {
+    stats.rxPackets++;
     
-    // Debug output for each character
-    if (c >= 32 && c <= 126) {
-      Serial.printf("UART-DEBUG: [CHAR] 0x%02X ('%c') - Buffer size: %d\n", c, c, (int)receivedChars.length() + 1);
-    } else {
-      Serial.printf("UART-DEBUG: [CHAR] 0x%02X (non-printable) - Buffer size: %d\n", c, (int)receivedChars.length() + 1);
+    // Longer commands arrive in fragments and are reassembled first
+    if (msg.port == MeshProto::PORT_PRIVATE && MeshFragments::isFragmentPayload(msg.payload, msg.payloadLen)) {
+      meshFragments.onPayload(msg.payload, msg.payloadLen, msg.from, msg.channel, Hal::millis());
+      return;
     }
+    processReceivedJSON((const char*)msg.payload, msg.payloadLen, msg.from, msg.channel);
+  }
+}
+
+static void handleFrame(const uint8_t* frame, size_t len) {
+  MeshProto::FromRadioMessage msg;
+  if (!MeshProto::decodeFromRadio(frame, len, msg)) {
+    stats.rxFrameErrors++;
+    return;
+  }
+  
+  switch (msg.kind) {
+    case MeshProto::FromRadioMessage::MY_INFO:
+      stats.myNodeNum = msg.myNodeNum;
+      break;
+    
+    case MeshProto::FromRadioMessage::CONFIG_COMPLETE:
+      if (msg.configCompleteId == configNonce && !stats.connected) {
+        stats.connected = true;
+        if (stats.queueFree == 0) stats.queueFree = 1;  // Until the first queue status
+        Serial.printf("MESH: Radio connected (node 0x%08lx)\n", (unsigned long)stats.myNodeNum);
+      }
+      break;
     
-    receivedChars += c;
-    lastCharTime = millis();
+    case MeshProto::FromRadioMessage::REBOOTED:
+      Serial.println("MESH: Radio rebooted - restarting handshake");
+      stats.connected = false;
+      sendWantConfig();
+      break;
     
-    // Process on newline or closing brace
-    if (c == '\n' || c == '}') {
-      Serial.println("UART-DEBUG: *** TRIGGER: Received '" + String(c) + "' - processing buffer ***");
-      processReceivedJSON();
-      receivedChars.clear();
+    case MeshProto::FromRadioMessage::QUEUE_STATUS:
+      lastQueueStatusTime = Hal::millis();
+      stats.queueFree = msg.queueFree;
+      stats.queueMaxlen = msg.queueMaxlen;
+      if (msg.queueRes != 0 && msg.queuePacketId != 0) {
+        // The radio refused this packet - no ACK will follow
+        int idx = findInFlight(msg.queuePacketId);
+        if (idx >= 0) removeInFlight(idx);
+        recordCompletion(msg.queuePacketId, false);
+        stats.failed++;
+        Serial.printf("MESH: Radio rejected packet 0x%08lx (res %ld)\n",
+                      (unsigned long)msg.queuePacketId, (long)msg.queueRes);
+      }
+      break;
+    
+    case MeshProto::FromRadioMessage::PACKET:
+      handlePacket(msg);
+      break;
+    
+    default:
+      break;
+  }
+}
+
+void checkForMeshtasticCommands() {
+  unsigned long now = Hal::millis();
+  
+  // Drop a partial frame if the radio went quiet
+  if (rxState != RX_START1 && (now - lastByteTime > FRAME_TIMEOUT)) {
+    rxState = RX_START1;
+    stats.rxFrameErrors++;
+  }
+  
+  // Assemble 0x94 0xC3 length-prefixed frames; other bytes are radio log text
+  while (MeshtasticSerial->available()) {
+    uint8_t c = MeshtasticSerial->read();
+    lastByteTime = now;
+    
+    switch (rxState) {
+      case RX_START1:
+        if (c == MeshProto::FRAME_START1) rxState = RX_START2;
+        break;
+      case RX_START2:
+        rxState = (c == MeshProto::FRAME_START2) ? RX_LEN_MSB : RX_START1;
+        break;
+      case RX_LEN_MSB:
+        rxLen = (size_t)c << 8;
+        rxState = RX_LEN_LSB;
+        break;
+      case RX_LEN_LSB:
+        rxLen |= c;
+        rxPos = 0;
+        if (rxLen == 0 || rxLen > MeshProto::MAX_FRAME_PAYLOAD) {
+          stats.rxFrameErrors++;
+          rxState = RX_START1;
+        } else {
+          rxState = RX_PAYLOAD;
+        }
+        break;
+      case RX_PAYLOAD:
+        rxFrame[rxPos++] = c;
+        if (rxPos == rxLen) {
+          handleFrame(rxFrame, rxLen);
+          rxState = RX_START1;
+        }
+        break;
+    }
+  }
+  
+  // Expire packets whose ACK never arrived
+  for (int i = inFlightCount - 1; i >= 0; i--) {
+    if (now - inFlight[i].sentTime > MESH_ACK_TIMEOUT_MS) {
+      Serial.printf("MESH: Packet 0x%08lx not acknowledged\n", (unsigned long)inFlight[i].id);
+      stats.timedOut++;
+      recordCompletion(inFlight[i].id, false);
+      removeInFlight(i);
     }
   }
   
-  // Timeout check
-  if (!receivedChars.empty() && (millis() - lastCharTime > CHAR_TIMEOUT)) {
-    Serial.println("UART-DEBUG: Buffer timeout - clearing");
-    receivedChars.clear();
+  // A full queue is only reported on our own sends - probe again after a while
+  if (stats.connected && stats.queueFree == 0 && now - lastQueueStatusTime > QUEUE_PROBE_MS) {
+    stats.queueFree = 1;
+    lastQueueStatusTime = now;
+  }
+  
+  // Fragment requests, acknowledgements and timeouts
+  meshFragments.poll(now);
+  
+  // Handshake retry and keep-alive
+  if (!stats.connected) {
+    if (now - lastHandshakeTime > HANDSHAKE_RETRY_MS) {
+      sendWantConfig();
+    }
+  } else if (now - lastTxTime > HEARTBEAT_INTERVAL_MS) {
+    sendHeartbeat();
   }
 }
 
-void processReceivedJSON() {
-  if (receivedChars.empty()) {
-    return;
-  }
+static void sendConfigAck(uint32_t fromNode, uint8_t channel, bool ok, const char* target) {
+  uint8_t ack[MESH_PAYLOAD_HEADER_SIZE + 2 + 32];
+  size_t targetLen = strlen(target);
+  if (targetLen > 32) targetLen = 32;
   
+  ack[0] = MESH_PAYLOAD_VERSION;
+  ack[1] = MSG_CONFIG_ACK;
+  ack[2] = ok ? 1 : 0;
+  ack[3] = (uint8_t)targetLen;
+  memcpy(ack + 4, target, targetLen);
+  
+  if (!sendMeshPayloadTo(fromNode, channel, ack, 4 + targetLen, false)) {
+    Serial.println("MESH: Radio busy - config ACK dropped");
+  }
+}
+
+void processReceivedJSON(const char* data, size_t len, uint32_t fromNode, uint8_t channel) {
   Serial.println("========================================");
-  Serial.println("UART-DEBUG: Processing message:");
-  Serial.printf("UART-DEBUG: Buffer length: %d bytes\n", (int)receivedChars.length());
-  Serial.println(receivedChars.c_str());
-  Serial.println("========================================");
+  Serial.printf("MESH: Message from 0x%08lx ch%d (%d bytes)\n", (unsigned long)fromNode, channel, (int)len);
   
   // Find JSON
-  size_t jsonStart = receivedChars.find('{');
-  size_t jsonEnd = receivedChars.find('}');
-  
-  if (jsonStart != std::string::npos && jsonEnd != std::string::npos && jsonEnd > jsonStart) {
-    Serial.printf("UART-DEBUG: Found '{' at position %d\n", (int)jsonStart);
-    Serial.printf("UART-DEBUG: Found '}' at position %d\n", (int)jsonEnd);
-    
-    String jsonStr = receivedChars.substr(jsonStart, jsonEnd - jsonStart + 1).c_str();
-    Serial.println("UART-DEBUG: Extracted JSON: " + jsonStr);
-    
-    // Parse JSON
-    StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, jsonStr);
-    
-    if (error) {
-      Serial.println("UART-DEBUG: JSON Parse Error: " + String(error.c_str()));
-      return;
+  const char* jsonStart = (const char*)memchr(data, '{', len);
+  const char* jsonEnd = nullptr;
+  for (const char* p = data + len; p > data; p--) {
+    if (p[-1] == '}') {
+      jsonEnd = p - 1;
+      break;
     }
-    
-    // Check magic word - try LD2450 config first
-    if (doc.containsKey("m")) {
-      String magicWord = doc["m"].as<String>();
+  }
+  
+  if (!jsonStart || !jsonEnd || jsonEnd <= jsonStart) {
+    Serial.println("MESH: No valid JSON found in message");
+    return;
+  }
+  
+  size_t jsonLen = jsonEnd - jsonStart + 1;
+  
+  // Parse JSON - static, a reassembled command can be FRAG_MAX_MESSAGE long
+  static StaticJsonDocument<MESH_COMMAND_JSON_CAPACITY> doc;
+  DeserializationError error = deserializeJson(doc, jsonStart, jsonLen);
+  
+  if (error) {
+    Serial.println("MESH: JSON Parse Error: " + String(error.c_str()));
+    return;
+  }
+  
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  
+  // Check magic word - try LD2450 config first
+  if (doc.containsKey("m")) {
+    // Check if this is for LD2450
+    if (ld2450Manager.getConfig().magicWord == doc["m"].as<const char*>()) {
+      Serial.println("MESH: LD2450 command detected");
       
-      // Check if this is for LD2450
-      if (magicWord == ld2450Manager.getConfig().magicWord.c_str()) {
-        Serial.println("UART-DEBUG: LD2450 command detected");
-        
-        if (ld2450Manager.processConfigCommand(jsonStr)) {
-          String ack = "{\"ack\":\"ok\",\"target\":\"LD2450\"}";
-          MeshtasticSerial->println(ack);
-          Serial.println("UART-DEBUG: LD2450 ACK sent: " + ack);
+      // Heatmap requests are answered with the heatmap itself, in fragments
+      if (doc.containsKey("heatmap")) {
+        if (doc["heatmap"].as<String>() == "clear") {
+          occupancyHeatmap.clear();
+          sendConfigAck(fromNode, channel, true, "LD2450");
+          return;
+        }
+        static uint8_t grid[HEATMAP_EXPORT_MAX];
+        size_t gridLen = occupancyHeatmap.encodeExport(grid, sizeof(grid));
+        if (gridLen == 0 || !meshFragments.send(fromNode, channel, grid, gridLen)) {
+          Serial.println("MESH: Heatmap export busy");
+          sendConfigAck(fromNode, channel, false, "LD2450");
         } else {
-          String ack = "{\"ack\":\"fail\",\"target\":\"LD2450\"}";
-          MeshtasticSerial->println(ack);
-          Serial.println("UART-DEBUG: LD2450 FAIL sent: " + ack);
+          Serial.printf("MESH: Heatmap export, %u bytes in %u fragments\n",
+                        (unsigned)gridLen, fragmentCount(gridLen));
         }
         return;
       }
+      
+      bool ok = ld2450Manager.processConfigCommand(jsonStr);
+      sendConfigAck(fromNode, channel, ok, "LD2450");
+      return;
     }
+  }
+  
+  // Gateway configuration commands address the gateway ID
+  if (doc.containsKey("target") &&
+      ConfigManager::getGatewayID() == doc["target"].as<const char*>()) {
+    Serial.println("MESH: Gateway command detected");
     
-    // If not LD2450, ignore (could be for other devices)
-    Serial.println("UART-DEBUG: Message does not match LD2450 magic word - ignoring");
+    // Configuration readout is answered in fragments
+    if (doc.containsKey("CMD") && doc["CMD"].as<String>() == "get_config") {
+      static char reply[FRAG_MAX_MESSAGE];
+      size_t replyLen = ConfigManager::encodeConfigJson(reply, sizeof(reply));
+      if (replyLen == 0 || !meshFragments.send(fromNode, channel, (const uint8_t*)reply, replyLen)) {
+        Serial.println("MESH: Config readout busy or too long");
+        sendConfigAck(fromNode, channel, false, ConfigManager::getGatewayID().c_str());
+      }
+      return;
+    }
     
-  } else {
-    Serial.println("UART-DEBUG: No valid JSON found in message");
+    bool ok = ConfigManager::processConfigCommand(jsonStr);
+    sendConfigAck(fromNode, channel, ok, ConfigManager::getGatewayID().c_str());
+    return;
   }
-}
\ No newline at end of file
+  
+  // Not for us (could be for other devices)
+  Serial.println("MESH: Message does not match LD2450 magic word or gateway - ignoring");
+}
+
+MeshDelivery getMeshDelivery(uint32_t packetId) {
+  if (packetId == 0) return MESH_UNKNOWN;
+  if (findInFlight(packetId) >= 0) return MESH_PENDING;
+  for (const CompletedPacket& packet : completed) {
+    if (packet.id == packetId) return packet.delivered ? MESH_DELIVERED : MESH_FAILED;
+  }
+  return MESH_UNKNOWN;
+}
+
+const MeshStats& getMeshStats() {
+  return stats;
+}
@@ -2,39 +2,83 @@
 #define MESHTASTICCOMM_H
 
 #include <Arduino.h>
-#include <string>
+#include <stddef.h>
+#include <stdint.h>
 
 // Global serial interface for Meshtastic UART1
 extern HardwareSerial* MeshtasticSerial;
 
-// Message buffer
-extern std::string receivedChars;
-extern unsigned long lastCharTime;
+// Link and delivery statistics
+struct MeshStats {
+  bool connected;               // Radio answered the config handshake
+  uint32_t myNodeNum;
+  uint32_t queueFree;           // Free TX slots last reported by the radio
+  uint32_t queueMaxlen;
+  unsigned long sent;           // Packets handed to the radio
+  unsigned long acked;          // Delivery confirmed (Routing ACK)
+  unsigned long failed;         // NAK or rejected by the radio queue
+  unsigned long timedOut;       // No ACK within MESH_ACK_TIMEOUT_MS
+  unsigned long rxPackets;      // Packets received from the mesh
+  unsigned long rxFrameErrors;  // Malformed frames from the radio
+};
+
+// Delivery state of a sent packet
+enum MeshDelivery {
+  MESH_PENDING,      // Waiting for its Routing ACK
+  MESH_DELIVERED,    // ACKed, or handed to the radio without want_ack
+  MESH_FAILED,       // NAK, rejected by the radio queue or ACK timed out
+  MESH_UNKNOWN       // Not among the recently sent packets
+};
 
 /**
- * Initialize Meshtastic UART communication
- * Call this in setup() after UART1 initialization
+ * Initialize Meshtastic serial client API (framed ToRadio/FromRadio protobufs)
+ * Call this in setup() after UART1 initialization - starts the config handshake
  */
 void initMeshtasticComm();
 
 /**
- * Send payload via Meshtastic
- * @param payload JSON string to send
+ * Check whether the radio currently accepts another packet
+ * False while the handshake is pending, the radio queue is full or too
+ * many packets are still waiting for their ACK
+ */
+bool meshCanSend();
+
+/**
+ * Send a binary payload on the gateway's private port
+ * Destination, channel and want_ack come from ConfigManager
+ * @param data payload bytes (see MeshPayload.h)
+ * @param len payload length, at most MeshProto::MAX_DATA_PAYLOAD
+ * @return packet id, or 0 if the radio cannot take it right now
  */
-void sendPayloadViaMeshtastic(const String& payload);
+uint32_t sendMeshPayload(const uint8_t* data, size_t len);
 
 /**
- * Check for incoming Meshtastic commands
- * Character-based buffering with timeout processing
+ * Send a binary payload to a specific node on a specific channel
+ * @return packet id, or 0 if the radio cannot take it right now
+ */
+uint32_t sendMeshPayloadTo(uint32_t dest, uint8_t channel, const uint8_t* data, size_t len, bool wantAck);
+
+/**
+ * Poll the radio: decode incoming frames, track queue status and ACKs,
+ * expire unacknowledged packets and dispatch incoming commands
  * Call this every loop iteration
  */
 void checkForMeshtasticCommands();
 
 /**
- * Process complete JSON message from buffer
- * Detects config commands and calls appropriate manager
- * Called internally by checkForMeshtasticCommands()
+ * Process a JSON command received from the mesh
+ * Detects config commands and calls appropriate manager, replies to sender
+ * Called internally by checkForMeshtasticCommands(), and with reassembled
+ * messages of up to FRAG_MAX_MESSAGE bytes by the fragment layer
  */
-void processReceivedJSON();
+void processReceivedJSON(const char* data, size_t len, uint32_t fromNode, uint8_t channel);
+
+/**
+ * Delivery state of a packet id returned by sendMeshPayload()
+ * Outcomes are remembered for the last few completed packets
+ */
+MeshDelivery getMeshDelivery(uint32_t packetId);
+
+const MeshStats& getMeshStats();
 
-#endif // MESHTASTICCOMM_H
\ No newline at end of file
+#endif // MESHTASTICCOMM_H
@@ -0,0 +1,285 @@
+#include "MeshtasticProto.h"
+#include <string.h>
+
+namespace MeshProto {
+
+//========================= Writer =========================
+Writer::Writer(uint8_t* buffer, size_t cap)
+  : buf(buffer), capacity(cap), pos(0), overflow(false) {}
+
+void Writer::put(uint8_t b) {
+  if (pos >= capacity) {
+    overflow = true;
+    return;
+  }
+  buf[pos++] = b;
+}
+
+void Writer::varint(uint64_t value) {
+  while (value >= 0x80) {
+    put((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  put((uint8_t)value);
+}
+
+void Writer::tag(uint32_t field, WireType type) {
+  varint(((uint64_t)field << 3) | type);
+}
+
+void Writer::uint32Field(uint32_t field, uint32_t value) {
+  tag(field, WT_VARINT);
+  varint(value);
+}
+
+void Writer::boolField(uint32_t field, bool value) {
+  tag(field, WT_VARINT);
+  varint(value ? 1 : 0);
+}
+
+void Writer::fixed32Field(uint32_t field, uint32_t value) {
+  tag(field, WT_FIXED32);
+  put(value & 0xFF);
+  put((value >> 8) & 0xFF);
+  put((value >> 16) & 0xFF);
+  put((value >> 24) & 0xFF);
+}
+
+void Writer::bytesField(uint32_t field, const uint8_t* data, size_t len) {
+  tag(field, WT_LEN);
+  varint(len);
+  if (pos + len > capacity) {
+    overflow = true;
+    return;
+  }
+  if (len) memcpy(buf + pos, data, len);
+  pos += len;
+}
+
+//========================= Reader =========================
+Reader::Reader(const uint8_t* buffer, size_t length)
+  : buf(buffer), len(length), pos(0), error(false) {}
+
+bool Reader::next(uint32_t& field, WireType& type) {
+  if (error || pos >= len) return false;
+  uint64_t key = varint();
+  field = (uint32_t)(key >> 3);
+  type = (WireType)(key & 0x07);
+  return !error && field != 0;
+}
+
+uint64_t Reader::varint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos >= len) break;
+    uint8_t b = buf[pos++];
+    value |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return value;
+  }
+  error = true;
+  return 0;
+}
+
+uint32_t Reader::fixed32() {
+  if (pos + 4 > len) {
+    error = true;
+    return 0;
+  }
+  uint32_t value = (uint32_t)buf[pos] | ((uint32_t)buf[pos + 1] << 8) |
+                   ((uint32_t)buf[pos + 2] << 16) | ((uint32_t)buf[pos + 3] << 24);
+  pos += 4;
+  return value;
+}
+
+bool Reader::bytes(const uint8_t*& data, size_t& length) {
+  uint64_t n = varint();
+  if (error || n > len - pos) {
+    error = true;
+    return false;
+  }
+  data = buf + pos;
+  length = (size_t)n;
+  pos += length;
+  return true;
+}
+
+void Reader::skip(WireType type) {
+  const uint8_t* data;
+  size_t length;
+  switch (type) {
+    case WT_VARINT:  varint(); break;
+    case WT_FIXED64: if (pos + 8 > len) error = true; else pos += 8; break;
+    case WT_LEN:     bytes(data, length); break;
+    case WT_FIXED32: fixed32(); break;
+    default:         error = true; break;
+  }
+}
+
+//========================= ToRadio =========================
+size_t encodeToRadioPacket(const OutboundPacket& packet, uint8_t* out, size_t cap) {
+  // Nested messages are encoded inside-out into scratch buffers
+  static uint8_t dataBuf[MAX_DATA_PAYLOAD + 16];
+  static uint8_t packetBuf[MAX_DATA_PAYLOAD + 48];
+  
+  Writer data(dataBuf, sizeof(dataBuf));
+  data.uint32Field(DataField::PORTNUM, packet.port);
+  data.bytesField(DataField::PAYLOAD, packet.payload, packet.payloadLen);
+  if (!data.ok()) return 0;
+  
+  Writer mesh(packetBuf, sizeof(packetBuf));
+  mesh.fixed32Field(MeshPacketField::TO, packet.to);
+  if (packet.channel) mesh.uint32Field(MeshPacketField::CHANNEL, packet.channel);
+  mesh.bytesField(MeshPacketField::DECODED, dataBuf, data.size());
+  mesh.fixed32Field(MeshPacketField::ID, packet.id);
+  if (packet.hopLimit) mesh.uint32Field(MeshPacketField::HOP_LIMIT, packet.hopLimit);
+  if (packet.wantAck) mesh.boolField(MeshPacketField::WANT_ACK, true);
+  if (!mesh.ok()) return 0;
+  
+  Writer toRadio(out, cap);
+  toRadio.bytesField(ToRadioField::PACKET, packetBuf, mesh.size());
+  return toRadio.ok() ? toRadio.size() : 0;
+}
+
+size_t encodeToRadioWantConfig(uint32_t nonce, uint8_t* out, size_t cap) {
+  Writer toRadio(out, cap);
+  toRadio.uint32Field(ToRadioField::WANT_CONFIG_ID, nonce);
+  return toRadio.ok() ? toRadio.size() : 0;
+}
+
+size_t encodeToRadioHeartbeat(uint8_t* out, size_t cap) {
+  // Heartbeat is an empty message
+  Writer toRadio(out, cap);
+  toRadio.bytesField(ToRadioField::HEARTBEAT, nullptr, 0);
+  return toRadio.ok() ? toRadio.size() : 0;
+}
+
+//========================= FromRadio =========================
+static bool decodeData(const uint8_t* buf, size_t len, FromRadioMessage& out) {
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    if (field == DataField::PORTNUM && type == WT_VARINT) {
+      out.port = (uint16_t)r.varint();
+    } else if (field == DataField::PAYLOAD && type == WT_LEN) {
+      r.bytes(out.payload, out.payloadLen);
+    } else if (field == DataField::REQUEST_ID && type == WT_FIXED32) {
+      out.requestId = r.fixed32();
+    } else {
+      r.skip(type);
+    }
+  }
+  if (!r.ok()) return false;
+  
+  // Routing replies carry the ACK/NAK reason in their own payload
+  if (out.port == PORT_ROUTING && out.payload) {
+    Reader routing(out.payload, out.payloadLen);
+    out.routingError = 0;
+    while (routing.next(field, type)) {
+      if (field == RoutingField::ERROR_REASON && type == WT_VARINT) {
+        out.routingError = (int32_t)routing.varint();
+      } else {
+        routing.skip(type);
+      }
+    }
+  }
+  return true;
+}
+
+static bool decodeMeshPacket(const uint8_t* buf, size_t len, FromRadioMessage& out) {
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    const uint8_t* sub;
+    size_t subLen;
+    if (field == MeshPacketField::FROM && type == WT_FIXED32) {
+      out.from = r.fixed32();
+    } else if (field == MeshPacketField::TO && type == WT_FIXED32) {
+      out.to = r.fixed32();
+    } else if (field == MeshPacketField::CHANNEL && type == WT_VARINT) {
+      out.channel = (uint8_t)r.varint();
+    } else if (field == MeshPacketField::ID && type == WT_FIXED32) {
+      out.id = r.fixed32();
+    } else if (field == MeshPacketField::DECODED && type == WT_LEN) {
+      if (!r.bytes(sub, subLen) || !decodeData(sub, subLen, out)) return false;
+    } else {
+      r.skip(type);
+    }
+  }
+  return r.ok();
+}
+
+static bool decodeQueueStatus(const uint8_t* buf, size_t len, FromRadioMessage& out) {
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    if (type != WT_VARINT) {
+      r.skip(type);
+      continue;
+    }
+    uint32_t value = (uint32_t)r.varint();
+    switch (field) {
+      case QueueStatusField::RES:            out.queueRes = (int32_t)value; break;
+      case QueueStatusField::FREE:           out.queueFree = value; break;
+      case QueueStatusField::MAXLEN:         out.queueMaxlen = value; break;
+      case QueueStatusField::MESH_PACKET_ID: out.queuePacketId = value; break;
+      default: break;
+    }
+  }
+  return r.ok();
+}
+
+bool decodeFromRadio(const uint8_t* buf, size_t len, FromRadioMessage& out) {
+  memset(&out, 0, sizeof(out));
+  out.kind = FromRadioMessage::NONE;
+  out.routingError = -1;
+  
+  Reader r(buf, len);
+  uint32_t field;
+  WireType type;
+  while (r.next(field, type)) {
+    const uint8_t* sub;
+    size_t subLen;
+    
+    if (field == FromRadioField::PACKET && type == WT_LEN) {
+      if (!r.bytes(sub, subLen) || !decodeMeshPacket(sub, subLen, out)) return false;
+      out.kind = FromRadioMessage::PACKET;
+    } else if (field == FromRadioField::MY_INFO && type == WT_LEN) {
+      if (!r.bytes(sub, subLen)) return false;
+      Reader info(sub, subLen);
+      uint32_t f;
+      WireType t;
+      while (info.next(f, t)) {
+        if (f == MyNodeInfoField::MY_NODE_NUM && t == WT_VARINT) out.myNodeNum = (uint32_t)info.varint();
+        else info.skip(t);
+      }
+      out.kind = FromRadioMessage::MY_INFO;
+    } else if (field == FromRadioField::CONFIG_COMPLETE_ID && type == WT_VARINT) {
+      out.configCompleteId = (uint32_t)r.varint();
+      out.kind = FromRadioMessage::CONFIG_COMPLETE;
+    } else if (field == FromRadioField::REBOOTED && type == WT_VARINT) {
+      r.varint();
+      out.kind = FromRadioMessage::REBOOTED;
+    } else if (field == FromRadioField::QUEUE_STATUS && type == WT_LEN) {
+      if (!r.bytes(sub, subLen) || !decodeQueueStatus(sub, subLen, out)) return false;
+      out.kind = FromRadioMessage::QUEUE_STATUS;
+    } else {
+      r.skip(type);
+      if (field != FromRadioField::ID && out.kind == FromRadioMessage::NONE) {
+        out.kind = FromRadioMessage::OTHER;
+      }
+    }
+  }
+  return r.ok();
+}
+
+void writeFrameHeader(uint8_t* out, size_t len) {
+  out[0] = FRAME_START1;
+  out[1] = FRAME_START2;
+  out[2] = (uint8_t)((len >> 8) & 0xFF);
+  out[3] = (uint8_t)(len & 0xFF);
+}
+
+}  // namespace MeshProto
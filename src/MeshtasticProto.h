@@ -0,0 +1,183 @@
+#ifndef MESHTASTICPROTO_H
+#define MESHTASTICPROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal protobuf wire-format codec (nanopb-style, caller-provided static
+// buffers, no heap) for the subset of the Meshtastic serial client API this
+// gateway uses. Field numbers follow meshtastic/protobufs mesh.proto.
+// Plain C++ only, so it builds for the firmware and the native simulation.
+namespace MeshProto {
+
+//========================= Serial framing =========================
+// Each protobuf travels as: 0x94 0xC3 <len MSB> <len LSB> <payload>
+static constexpr uint8_t FRAME_START1 = 0x94;
+static constexpr uint8_t FRAME_START2 = 0xC3;
+static constexpr size_t FRAME_HEADER_SIZE = 4;
+static constexpr size_t MAX_FRAME_PAYLOAD = 512;
+
+// Largest Data.payload the mesh accepts (DATA_PAYLOAD_LEN)
+static constexpr size_t MAX_DATA_PAYLOAD = 233;
+
+static constexpr uint32_t BROADCAST_ADDR = 0xFFFFFFFF;
+
+//========================= Field numbers =========================
+enum PortNum : uint16_t {
+  PORT_TEXT_MESSAGE = 1,
+  PORT_ROUTING = 5,
+  PORT_PRIVATE = 256
+};
+
+namespace ToRadioField {
+  static constexpr uint32_t PACKET = 1;
+  static constexpr uint32_t WANT_CONFIG_ID = 3;
+  static constexpr uint32_t DISCONNECT = 4;
+  static constexpr uint32_t HEARTBEAT = 7;
+}
+
+namespace FromRadioField {
+  static constexpr uint32_t ID = 1;
+  static constexpr uint32_t PACKET = 2;
+  static constexpr uint32_t MY_INFO = 3;
+  static constexpr uint32_t CONFIG_COMPLETE_ID = 7;
+  static constexpr uint32_t REBOOTED = 8;
+  static constexpr uint32_t QUEUE_STATUS = 11;
+}
+
+namespace MeshPacketField {
+  static constexpr uint32_t FROM = 1;       // fixed32
+  static constexpr uint32_t TO = 2;         // fixed32
+  static constexpr uint32_t CHANNEL = 3;    // uint32
+  static constexpr uint32_t DECODED = 4;    // Data
+  static constexpr uint32_t ID = 6;         // fixed32
+  static constexpr uint32_t HOP_LIMIT = 9;  // uint32
+  static constexpr uint32_t WANT_ACK = 10;  // bool
+}
+
+namespace DataField {
+  static constexpr uint32_t PORTNUM = 1;     // enum
+  static constexpr uint32_t PAYLOAD = 2;     // bytes
+  static constexpr uint32_t REQUEST_ID = 6;  // fixed32
+}
+
+namespace QueueStatusField {
+  static constexpr uint32_t RES = 1;             // int32
+  static constexpr uint32_t FREE = 2;            // uint32
+  static constexpr uint32_t MAXLEN = 3;          // uint32
+  static constexpr uint32_t MESH_PACKET_ID = 4;  // uint32
+}
+
+namespace MyNodeInfoField {
+  static constexpr uint32_t MY_NODE_NUM = 1;
+}
+
+namespace RoutingField {
+  static constexpr uint32_t ERROR_REASON = 3;
+}
+
+//========================= Wire format =========================
+enum WireType : uint8_t {
+  WT_VARINT = 0,
+  WT_FIXED64 = 1,
+  WT_LEN = 2,
+  WT_FIXED32 = 5
+};
+
+class Writer {
+private:
+  uint8_t* buf;
+  size_t capacity;
+  size_t pos;
+  bool overflow;
+  
+  void put(uint8_t b);
+
+public:
+  Writer(uint8_t* buffer, size_t cap);
+  
+  void varint(uint64_t value);
+  void tag(uint32_t field, WireType type);
+  void uint32Field(uint32_t field, uint32_t value);
+  void boolField(uint32_t field, bool value);
+  void fixed32Field(uint32_t field, uint32_t value);
+  void bytesField(uint32_t field, const uint8_t* data, size_t len);
+  
+  size_t size() const { return pos; }
+  bool ok() const { return !overflow; }
+};
+
+class Reader {
+private:
+  const uint8_t* buf;
+  size_t len;
+  size_t pos;
+  bool error;
+
+public:
+  Reader(const uint8_t* buffer, size_t length);
+  
+  // Reads the next tag; false at end of buffer or on error
+  bool next(uint32_t& field, WireType& type);
+  
+  uint64_t varint();
+  uint32_t fixed32();
+  bool bytes(const uint8_t*& data, size_t& length);
+  void skip(WireType type);
+  
+  bool ok() const { return !error; }
+};
+
+//========================= Messages =========================
+struct OutboundPacket {
+  uint32_t id;
+  uint32_t to;
+  uint8_t channel;
+  uint16_t port;
+  const uint8_t* payload;
+  size_t payloadLen;
+  bool wantAck;
+  uint8_t hopLimit;  // 0 = radio default
+};
+
+// Encode a ToRadio message into out; returns encoded size, 0 on overflow
+size_t encodeToRadioPacket(const OutboundPacket& packet, uint8_t* out, size_t cap);
+size_t encodeToRadioWantConfig(uint32_t nonce, uint8_t* out, size_t cap);
+size_t encodeToRadioHeartbeat(uint8_t* out, size_t cap);
+
+struct FromRadioMessage {
+  enum Kind { NONE, PACKET, MY_INFO, CONFIG_COMPLETE, REBOOTED, QUEUE_STATUS, OTHER };
+  Kind kind;
+  
+  // PACKET - payload points into the decoded buffer
+  uint32_t from;
+  uint32_t to;
+  uint32_t id;
+  uint8_t channel;
+  uint16_t port;
+  const uint8_t* payload;
+  size_t payloadLen;
+  uint32_t requestId;    // Routing replies: id of the packet being acked
+  int32_t routingError;  // Routing replies: 0 = ACK, otherwise NAK reason; -1 = none
+  
+  // MY_INFO
+  uint32_t myNodeNum;
+  
+  // CONFIG_COMPLETE
+  uint32_t configCompleteId;
+  
+  // QUEUE_STATUS
+  int32_t queueRes;
+  uint32_t queueFree;
+  uint32_t queueMaxlen;
+  uint32_t queuePacketId;
+};
+
+bool decodeFromRadio(const uint8_t* buf, size_t len, FromRadioMessage& out);
+
+// Write the 4-byte serial frame header for a payload of len bytes
+void writeFrameHeader(uint8_t* out, size_t len);
+
+}  // namespace MeshProto
+
+#endif // MESHTASTICPROTO_H
@@ -0,0 +1,174 @@
+#include "OccupancyAggregator.h"
+#include "MeshPayload.h"
+
+// Global instance
+OccupancyAggregator occupancyAggregator;
+
+// Frame gaps longer than this are not counted as occupied time
+static const unsigned long MAX_FRAME_GAP_MS = 1000;
+
+// A target must move this far past the alert distance to leave the safety zone
+static const int SAFETY_HYSTERESIS_CM = 20;
+
+// Predicted safety zone entries this close in time raise the alert early;
+// the prediction is held a while so a noisy frame does not re-alert
+static const uint8_t PREDICT_HORIZON_DS = 15;
+static const unsigned long PREDICT_HOLD_MS = 3000;
+
+OccupancyAggregator::OccupancyAggregator() : lastFrameTime(0), alertMask(0) {
+  resetWindow(0);
+  for (TargetOccupancy& target : targets) {
+    target.inSafetyZone = false;
+    target.predictedUntil = 0;
+  }
+}
+
+void OccupancyAggregator::resetWindow(unsigned long now) {
+  for (TargetOccupancy& target : targets) {
+    target.occupiedMs = 0;
+    target.entries = 0;
+    target.minDistanceCm = UINT16_MAX;
+  }
+  
+  zoneOccupiedMs = 0;
+  personMs = 0;
+  safetyOccupiedMs = 0;
+  zoneEntries = 0;
+  alerts = 0;
+  maxSimultaneous = 0;
+  minDistanceCm = UINT16_MAX;
+  windowStartTime = now;
+}
+
+// Little-endian uint16 into a payload buffer
+static void putU16(uint8_t* out, size_t& pos, uint16_t value) {
+  out[pos++] = value & 0xFF;
+  out[pos++] = (value >> 8) & 0xFF;
+}
+
+uint16_t OccupancyAggregator::toDeciseconds(uint32_t ms) {
+  uint32_t ds = (ms + 50) / 100;
+  return ds > UINT16_MAX ? UINT16_MAX : (uint16_t)ds;
+}
+
+void OccupancyAggregator::onFrame(const TargetSnapshot& snapshot, const LD2450Config& config, unsigned long now) {
+  int alertDistanceCm = config.alertDistanceCm;
+  unsigned long dt = lastFrameTime != 0 ? now - lastFrameTime : 0;
+  if (dt > MAX_FRAME_GAP_MS) dt = MAX_FRAME_GAP_MS;
+  lastFrameTime = now;
+  
+  bool anySafety = false;
+  
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& info = snapshot[i];
+    TargetOccupancy& target = targets[i];
+    bool present = (info.state == PRESENT);
+    
+    if (present) {
+      target.occupiedMs += dt;
+      personMs += dt;
+      
+      if (info.stateChanged) {
+        target.entries++;
+        zoneEntries++;
+      }
+      
+      int dist = info.lastDistance;
+      if (dist > 0 && dist < target.minDistanceCm) target.minDistanceCm = dist;
+      if (dist > 0 && dist < minDistanceCm) minDistanceCm = dist;
+    }
+    
+    // Safety zone with exit hysteresis so jitter at the edge does not re-alert
+    bool inside;
+    if (!present || alertDistanceCm <= 0 || info.lastDistance <= 0) {
+      inside = false;
+    } else if (target.inSafetyZone) {
+      inside = info.lastDistance <= alertDistanceCm + SAFETY_HYSTERESIS_CM;
+    } else {
+      inside = info.lastDistance <= alertDistanceCm;
+    }
+    
+    bool predicted = false;
+    if (config.predictEnable && present && alertDistanceCm > 0) {
+      if (info.timeToZoneDs <= PREDICT_HORIZON_DS) {
+        target.predictedUntil = now + PREDICT_HOLD_MS;
+      }
+      predicted = (long)(target.predictedUntil - now) > 0;
+    }
+    
+    if ((inside || predicted) && !target.inSafetyZone) {
+      alerts++;
+      alertMask |= 1 << i;
+      if (inside) {
+        Serial.printf("Target %d entered safety zone (%d cm)\n", i + 1, info.lastDistance);
+      } else {
+        Serial.printf("Target %d approaching safety zone (%d cm, %.1f s)\n",
+          i + 1, info.lastDistance, info.timeToZoneDs / 10.0);
+      }
+    }
+    target.inSafetyZone = inside || predicted;
+    anySafety |= inside;
+  }
+  
+  if (snapshot.presentCount > 0) zoneOccupiedMs += dt;
+  if (anySafety) safetyOccupiedMs += dt;
+  if (snapshot.presentCount > maxSimultaneous) maxSimultaneous = snapshot.presentCount;
+}
+
+uint8_t OccupancyAggregator::takeAlerts() {
+  uint8_t mask = alertMask;
+  alertMask = 0;
+  return mask;
+}
+
+bool OccupancyAggregator::windowElapsed(unsigned long windowMs, unsigned long now) const {
+  return windowMs > 0 && now - windowStartTime >= windowMs;
+}
+
+size_t OccupancyAggregator::encodeSummary(uint8_t* out, size_t cap, const DeviceName& deviceName, unsigned long now) {
+  size_t nameLen = deviceName.length();
+  
+  size_t len = MESH_PAYLOAD_HEADER_SIZE + 16 + LD2450_MAX_TARGETS * 5 + 1 + nameLen;
+  if (len > cap) {
+    return 0;
+  }
+  
+  uint32_t windowMs = now - windowStartTime;
+  uint16_t windowS = (uint16_t)((windowMs + 500) / 1000);
+  
+  // Mean number of people in the zone, 8.8 fixed point
+  uint32_t meanOccupancy = windowMs > 0 ? (uint32_t)(((uint64_t)personMs << 8) / windowMs) : 0;
+  if (meanOccupancy > UINT16_MAX) meanOccupancy = UINT16_MAX;
+  
+  size_t pos = 0;
+  out[pos++] = MESH_PAYLOAD_VERSION;
+  out[pos++] = MSG_SUMMARY;
+  putU16(out, pos, windowS);
+  putU16(out, pos, toDeciseconds(zoneOccupiedMs));
+  putU16(out, pos, (uint16_t)meanOccupancy);
+  putU16(out, pos, zoneEntries);
+  putU16(out, pos, minDistanceCm);
+  putU16(out, pos, toDeciseconds(safetyOccupiedMs));
+  putU16(out, pos, alerts);
+  out[pos++] = maxSimultaneous;
+  out[pos++] = LD2450_MAX_TARGETS;
+  
+  for (const TargetOccupancy& target : targets) {
+    putU16(out, pos, toDeciseconds(target.occupiedMs));
+    out[pos++] = target.entries > UINT8_MAX ? UINT8_MAX : (uint8_t)target.entries;
+    putU16(out, pos, target.minDistanceCm);
+  }
+  
+  out[pos++] = (uint8_t)nameLen;
+  memcpy(out + pos, deviceName.c_str(), nameLen);
+  pos += nameLen;
+  
+  resetWindow(now);
+  return pos;
+}
+
+void OccupancyAggregator::printStatus(unsigned long now) const {
+  Serial.printf("Occupancy window: %lu s, occupied %lu s, entries %u, max %u, alerts %u\n",
+    (now - windowStartTime) / 1000, (unsigned long)(zoneOccupiedMs / 1000),
+    zoneEntries, maxSimultaneous, alerts);
+}
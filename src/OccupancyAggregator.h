@@ -0,0 +1,65 @@
+#ifndef OCCUPANCYAGGREGATOR_H
+#define OCCUPANCYAGGREGATOR_H
+
+#include <Arduino.h>
+#include "LD2450Manager.h"
+
+// Per-target accumulators for the current window
+struct TargetOccupancy {
+  uint32_t occupiedMs;       // Time in PRESENT state
+  uint16_t entries;          // ABSENT -> PRESENT transitions
+  uint16_t minDistanceCm;    // Closest approach (UINT16_MAX = none)
+  bool inSafetyZone;         // Currently within the alert distance (or predicted to be)
+  unsigned long predictedUntil; // Predicted entry keeps the alert latched until then
+};
+
+// Rolls the per-frame target state up into one summary per window.
+// Occupied time is integrated from the frame timestamps in milliseconds
+// and reported as 0.1 s fixed point; gaps between frames are capped so a
+// stalled sensor does not count as occupancy.
+class OccupancyAggregator {
+private:
+  TargetOccupancy targets[LD2450_MAX_TARGETS];
+  
+  // Zone accumulators (whole monitored area)
+  uint32_t zoneOccupiedMs;     // Time with at least one target PRESENT
+  uint32_t personMs;           // Sum of all targets' occupied time
+  uint32_t safetyOccupiedMs;   // Time with a target inside the alert distance
+  uint16_t zoneEntries;
+  uint16_t alerts;             // Safety zone entries
+  uint8_t maxSimultaneous;
+  uint16_t minDistanceCm;
+  
+  unsigned long windowStartTime;
+  unsigned long lastFrameTime;
+  uint8_t alertMask;          // Targets that entered the safety zone since takeAlerts()
+  
+  // Helper functions
+  void resetWindow(unsigned long now);
+  static uint16_t toDeciseconds(uint32_t ms);
+
+public:
+  OccupancyAggregator();
+  
+  // Feed one processed frame; alertDistanceCm = 0 disables safety alerts.
+  // With prediction enabled a target predicted to reach the safety zone
+  // within PREDICT_HORIZON_DS already counts as entering it
+  void onFrame(const TargetSnapshot& snapshot, const LD2450Config& config, unsigned long now);
+  
+  // Bit i set once per safety zone entry of target i+1
+  uint8_t takeAlerts();
+  
+  // True when the current window is at least windowMs long
+  bool windowElapsed(unsigned long windowMs, unsigned long now) const;
+  
+  // Encode the current window as MSG_SUMMARY (see MeshPayload.h) and start
+  // a new window. Returns the encoded length, 0 if cap is too small
+  size_t encodeSummary(uint8_t* out, size_t cap, const DeviceName& deviceName, unsigned long now);
+  
+  // Status
+  void printStatus(unsigned long now) const;
+};
+
+extern OccupancyAggregator occupancyAggregator;
+
+#endif // OCCUPANCYAGGREGATOR_H
@@ -0,0 +1,86 @@
+#include "OccupancyHeatmap.h"
+#include "MeshFragment.h"
+#include "MeshPayload.h"
+
+static_assert(HEATMAP_EXPORT_MAX <= FRAG_MAX_MESSAGE, "The heatmap export must fit in one fragmented message");
+
+// Global instance
+OccupancyHeatmap occupancyHeatmap;
+
+// All counters are halved this often (one hour half-life)
+static const unsigned long HEATMAP_DECAY_MS = 3600000;
+
+OccupancyHeatmap::OccupancyHeatmap()
+  : lastDecayTime(0) {
+  clear();
+}
+
+void OccupancyHeatmap::clear() {
+  memset(cells, 0, sizeof(cells));
+}
+
+void OccupancyHeatmap::decay() {
+  for (uint16_t& cell : cells) {
+    cell >>= 1;
+  }
+}
+
+void OccupancyHeatmap::onFrame(const TargetSnapshot& snapshot, unsigned long now) {
+  if (now - lastDecayTime >= HEATMAP_DECAY_MS) {
+    decay();
+    lastDecayTime = now;
+  }
+  
+  for (const TargetInfo& target : snapshot) {
+    // Only live detections of confirmed targets - no held positions, no noise
+    if (target.state != PRESENT || !target.valid) continue;
+    
+    int col = (target.lastX - HEATMAP_X_MIN_MM) / HEATMAP_CELL_MM;
+    int row = target.lastY / HEATMAP_CELL_MM;
+    if (target.lastX < HEATMAP_X_MIN_MM || col >= HEATMAP_COLS ||
+        target.lastY < 0 || row >= HEATMAP_ROWS) {
+      continue;
+    }
+    
+    uint16_t& cell = cells[row * HEATMAP_COLS + col];
+    if (cell < UINT16_MAX) cell++;
+  }
+}
+
+// Row-major token stream of varints - most cells are empty:
+//   (n << 1) | 0  run of n empty cells
+//   (v << 1) | 1  one cell with count v > 0
+size_t OccupancyHeatmap::compress(uint8_t* out, size_t cap) const {
+  size_t pos = 0;
+  int i = 0;
+  while (i < HEATMAP_CELLS) {
+    if (cells[i] == 0) {
+      int run = 0;
+      while (i < HEATMAP_CELLS && cells[i] == 0) {
+        run++;
+        i++;
+      }
+      payloadPutVarint(out, pos, cap, (uint32_t)run << 1);
+    } else {
+      payloadPutVarint(out, pos, cap, ((uint32_t)cells[i] << 1) | 1);
+      i++;
+    }
+  }
+  return pos;
+}
+
+size_t OccupancyHeatmap::encodeExport(uint8_t* out, size_t cap) const {
+  if (cap < HEATMAP_EXPORT_MAX) {
+    return 0;
+  }
+  
+  size_t pos = 0;
+  out[pos++] = MESH_PAYLOAD_VERSION;
+  out[pos++] = MSG_HEATMAP;
+  out[pos++] = HEATMAP_COLS;
+  out[pos++] = HEATMAP_ROWS;
+  out[pos++] = HEATMAP_CELL_MM / 10;
+  pos += compress(out + pos, cap - pos);
+  
+  return pos;
+}
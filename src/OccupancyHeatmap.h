@@ -0,0 +1,52 @@
+#ifndef OCCUPANCYHEATMAP_H
+#define OCCUPANCYHEATMAP_H
+
+#include <Arduino.h>
+#include "LD2450Manager.h"
+
+// Grid in the radar plane: 20 x 20 cells of 30 cm covering x -300..300 cm
+// and y 0..600 cm in front of the sensor. Row 0 is nearest to the sensor,
+// column 0 is at x = -300 cm.
+static constexpr int HEATMAP_COLS = 20;
+static constexpr int HEATMAP_ROWS = 20;
+static constexpr int HEATMAP_CELL_MM = 300;
+static constexpr int HEATMAP_X_MIN_MM = -(HEATMAP_COLS * HEATMAP_CELL_MM) / 2;
+static constexpr int HEATMAP_CELLS = HEATMAP_COLS * HEATMAP_ROWS;
+
+// Export message header: version, type, cols, rows, cell cm
+static constexpr size_t HEATMAP_HEADER_SIZE = 5;
+
+// Longest export: every cell a 3-byte varint
+static constexpr size_t HEATMAP_EXPORT_MAX = HEATMAP_HEADER_SIZE + HEATMAP_CELLS * 3;
+
+// Accumulates where confirmed targets are detected. Each frame adds one hit
+// per detected target to its cell; counters saturate at UINT16_MAX and are
+// halved every HEATMAP_DECAY_MS so old activity fades out.
+class OccupancyHeatmap {
+private:
+  uint16_t cells[HEATMAP_CELLS];
+  unsigned long lastDecayTime;
+  
+  // Helper functions
+  void decay();
+  size_t compress(uint8_t* out, size_t cap) const;
+
+public:
+  OccupancyHeatmap();
+  
+  // Feed one processed frame
+  void onFrame(const TargetSnapshot& snapshot, unsigned long now);
+  
+  void clear();
+  
+  // Encode the MSG_HEATMAP export message: header and compressed grid.
+  // It is sent as one fragmented message (MeshFragment.h).
+  // Returns the encoded length, 0 if cap is too small
+  size_t encodeExport(uint8_t* out, size_t cap) const;
+  
+  uint16_t getCell(int col, int row) const { return cells[row * HEATMAP_COLS + col]; }
+};
+
+extern OccupancyHeatmap occupancyHeatmap;
+
+#endif // OCCUPANCYHEATMAP_H
@@ -0,0 +1,37 @@
+#include "RssiDistance.h"
+#include "ConfigManager.h"
+#include <math.h>
+
+// Global instance
+RssiDistance rssiDistance;
+
+RssiDistance::RssiDistance() : rebuilds(0) {
+  for (uint16_t& entry : table) {
+    entry = 0;
+  }
+}
+
+float RssiDistance::modelMeters(int rssi, int txPower, float envFactor, float correction) {
+  return powf(10.0f, (txPower - rssi) / (10.0f * envFactor)) + correction;
+}
+
+void RssiDistance::rebuild() {
+  int txPower = ConfigManager::getTxPower();
+  float envFactor = ConfigManager::getEnvironmentalFactor();
+  float correction = ConfigManager::getDistanceCorrection();
+  
+  for (size_t i = 0; i < RSSI_TABLE_SIZE; i++) {
+    float cm = modelMeters(RSSI_TABLE_MIN + (int)i, txPower, envFactor, correction) * 100.0f + 0.5f;
+    if (cm <= 0) {
+      table[i] = 0;
+    } else if (cm >= RSSI_DISTANCE_MAX_CM) {
+      table[i] = RSSI_DISTANCE_MAX_CM;
+    } else {
+      table[i] = (uint16_t)cm;
+    }
+  }
+  rebuilds++;
+  
+  Serial.printf("RSSI table: tx %d dBm, N %.2f, corr %.2f m -> -60 dBm = %u cm, -80 dBm = %u cm\n",
+                txPower, envFactor, correction, toCentimeters(-60), toCentimeters(-80));
+}
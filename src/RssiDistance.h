@@ -0,0 +1,47 @@
+#ifndef RSSIDISTANCE_H
+#define RSSIDISTANCE_H
+
+#include <Arduino.h>
+
+// RSSI range covered by the table; readings outside are clamped
+static constexpr int RSSI_TABLE_MIN = -127;
+static constexpr int RSSI_TABLE_MAX = 0;
+static constexpr size_t RSSI_TABLE_SIZE = RSSI_TABLE_MAX - RSSI_TABLE_MIN + 1;
+
+// Largest representable distance (655.35 m); farther estimates saturate
+static constexpr uint16_t RSSI_DISTANCE_MAX_CM = UINT16_MAX;
+
+// RSSI to distance with the log-distance path loss model
+//   d = 10^((TX_POWER - RSSI) / (10 * N)) + DISTANCE_CORRECTION
+// precomputed for every integer RSSI. The table is rebuilt from
+// ConfigManager whenever tx_power, env_factor or distance_correction change,
+// so a conversion is one clamp and one indexed load instead of a powf().
+// Entries are rounded to the nearest centimetre, so they are within 0.5 cm
+// of modelMeters() wherever the model lies between 0 and 655.35 m.
+class RssiDistance {
+private:
+  uint16_t table[RSSI_TABLE_SIZE];   // Centimetres
+  unsigned long rebuilds;
+
+public:
+  RssiDistance();
+  
+  // Recompute from the current ConfigManager settings
+  void rebuild();
+  
+  // Model evaluated directly, in metres (for reference and calibration)
+  static float modelMeters(int rssi, int txPower, float envFactor, float correction);
+  
+  uint16_t toCentimeters(int rssi) const {
+    if (rssi < RSSI_TABLE_MIN) rssi = RSSI_TABLE_MIN;
+    if (rssi > RSSI_TABLE_MAX) rssi = RSSI_TABLE_MAX;
+    return table[rssi - RSSI_TABLE_MIN];
+  }
+  float toMeters(int rssi) const { return toCentimeters(rssi) * 0.01f; }
+  
+  unsigned long getRebuilds() const { return rebuilds; }
+};
+
+extern RssiDistance rssiDistance;
+
+#endif // RSSIDISTANCE_H
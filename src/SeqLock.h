@@ -0,0 +1,63 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Single-writer sequence lock for publishing plain structs to other tasks.
+//
+// The writer bumps the sequence to an odd value, copies the data and bumps
+// it back to even - it never blocks. Readers copy the data and retry if the
+// sequence was odd or changed during the copy (torn read).
+// T must be trivially copyable.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock payload must be trivially copyable");
+
+private:
+  std::atomic<uint32_t> sequence;
+  T data;
+
+public:
+  SeqLock() : sequence(0), data() {}
+  
+  // Writer side - only ever called from one task
+  void write(const T& value) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    memcpy(&data, &value, sizeof(T));
+    
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+  
+  // Reader side - safe from any task, retries until a consistent copy is made
+  // Returns the (even) sequence number of the copied version
+  uint32_t read(T& out) const {
+    while (true) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;  // Write in progress
+      }
+      
+      memcpy(&out, &data, sizeof(T));
+      
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint32_t after = sequence.load(std::memory_order_relaxed);
+      if (before == after) {
+        return before;
+      }
+    }
+  }
+  
+  // Number of completed writes (sequence / 2)
+  uint32_t version() const {
+    return sequence.load(std::memory_order_acquire) >> 1;
+  }
+};
+
+#endif // SEQLOCK_H
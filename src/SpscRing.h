@@ -0,0 +1,65 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Single-producer single-consumer ring for handing small records from a
+// callback task to loop() without locks.
+//
+// The producer owns head, the consumer owns tail; each only reads the
+// other's index. push() never blocks - when the ring is full the record is
+// rejected and the caller counts the drop. N must be a power of two and one
+// slot stays free to tell full from empty. T must be trivially copyable.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscRing records must be trivially copyable");
+
+private:
+  T slots[N];
+  std::atomic<uint32_t> head;   // Next slot to write (producer)
+  std::atomic<uint32_t> tail;   // Next slot to read (consumer)
+
+public:
+  SpscRing() : slots(), head(0), tail(0) {}
+  
+  // Producer side
+  bool push(const T& record) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t next = (h + 1) & (N - 1);
+    if (next == tail.load(std::memory_order_acquire)) {
+      return false;  // Full
+    }
+    slots[h] = record;
+    head.store(next, std::memory_order_release);
+    return true;
+  }
+  
+  // Consumer side - copies up to max records in arrival order, returns the count
+  size_t popBatch(T* out, size_t max) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (t != h && n < max) {
+      out[n++] = slots[t];
+      t = (t + 1) & (N - 1);
+    }
+    tail.store(t, std::memory_order_release);
+    return n;
+  }
+  
+  // Records waiting; exact on the consumer side, a snapshot elsewhere
+  size_t size() const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    return (h - t) & (N - 1);
+  }
+  
+  static constexpr size_t capacity() { return N - 1; }
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,190 @@
+#ifndef TELEMETRYPROTO_H
+#define TELEMETRYPROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LD2450Proto.h"
+#include "Crc16.h"
+
+// Header-only codec for the binary telemetry stream on the USB serial port:
+// one record per processed radar frame, CRC-checked and COBS-framed, so the
+// firmware and the host decoder (tools/telemetry_csv.cpp) share one
+// definition. Plain C++11 only, like LD2450Proto.h.
+namespace TelemetryProto {
+
+//========================= Record layout =========================
+// type(1) | version(1) | frame(4) | time ms(4) | parse us(2) | backlog(2) |
+// dropped(2) | target count(1) | count x target(15) | CRC-16(2)
+// All fields little-endian. On the wire every record is COBS-encoded and
+// enclosed in 0x00 delimiters, so text log lines in between never merge
+// with a record and fail its CRC on their own.
+static constexpr uint8_t RECORD_FRAME = 0x01;
+static constexpr uint8_t VERSION = 1;
+
+static constexpr size_t HEADER_SIZE = 17;
+static constexpr size_t TARGET_SIZE = 15;
+static constexpr size_t CRC_SIZE = 2;
+static constexpr size_t MAX_RECORD_SIZE = HEADER_SIZE + LD2450Proto::MAX_TARGETS * TARGET_SIZE + CRC_SIZE;
+
+// COBS adds one byte per 254, plus the two delimiters
+static constexpr size_t MAX_WIRE_SIZE = MAX_RECORD_SIZE + MAX_RECORD_SIZE / 254 + 1 + 2;
+
+static_assert(MAX_RECORD_SIZE == 64, "Frame records are 64 bytes with three targets");
+
+// Target flags
+static constexpr uint8_t FLAG_VALID = 0x01;     // Detected in this frame
+static constexpr uint8_t FLAG_CHANGED = 0x02;   // PRESENT <-> ABSENT in this frame
+static constexpr uint8_t FLAG_HOLDING = 0x04;   // PRESENT on its last position
+
+//========================= Decoded record =========================
+struct TargetSample {
+  int16_t x;              // mm, raw from the sensor
+  int16_t y;              // mm
+  int16_t speed;          // cm/s, positive = approaching
+  uint16_t resolution;    // mm, 0 = empty slot
+  uint16_t distanceCm;    // Distance the state machine used (held while PRESENT)
+  uint8_t state;          // TargetState: 0 absent, 1 debounce, 2 present
+  uint8_t flags;
+  uint8_t hitFrames;      // Consecutive detections, saturating at 255
+  uint8_t missFrames;     // Consecutive misses, saturating at 255
+  uint8_t timeToZoneDs;   // 0 = inside the safety zone, 255 = not approaching
+};
+
+struct FrameRecord {
+  uint32_t frame;         // Frames processed since boot
+  uint32_t timeMs;        // Uptime when the frame was processed
+  uint16_t parseUs;       // Decoding and state machine time for this frame
+  uint16_t backlog;       // Radar bytes still waiting in the UART
+  uint16_t dropped;       // Records dropped since boot (USB buffer full)
+  uint8_t count;
+  TargetSample targets[LD2450Proto::MAX_TARGETS];
+};
+
+//========================= Helpers =========================
+inline void putU16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+inline void putU32(uint8_t* p, uint32_t value) {
+  putU16(p, value & 0xFFFF);
+  putU16(p + 2, value >> 16);
+}
+
+inline uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+  return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+//========================= Record codec =========================
+// Returns the record length including the CRC
+inline size_t encodeRecord(const FrameRecord& in, uint8_t* out) {
+  uint8_t count = in.count <= LD2450Proto::MAX_TARGETS ? in.count : (uint8_t)LD2450Proto::MAX_TARGETS;
+  out[0] = RECORD_FRAME;
+  out[1] = VERSION;
+  putU32(out + 2, in.frame);
+  putU32(out + 6, in.timeMs);
+  putU16(out + 10, in.parseUs);
+  putU16(out + 12, in.backlog);
+  putU16(out + 14, in.dropped);
+  out[16] = count;
+  
+  size_t pos = HEADER_SIZE;
+  for (size_t i = 0; i < count; i++) {
+    const TargetSample& t = in.targets[i];
+    putU16(out + pos, (uint16_t)t.x);
+    putU16(out + pos + 2, (uint16_t)t.y);
+    putU16(out + pos + 4, (uint16_t)t.speed);
+    putU16(out + pos + 6, t.resolution);
+    putU16(out + pos + 8, t.distanceCm);
+    out[pos + 10] = t.state;
+    out[pos + 11] = t.flags;
+    out[pos + 12] = t.hitFrames;
+    out[pos + 13] = t.missFrames;
+    out[pos + 14] = t.timeToZoneDs;
+    pos += TARGET_SIZE;
+  }
+  putU16(out + pos, crc16(out, pos));
+  return pos + CRC_SIZE;
+}
+
+// False if the record is not a frame record of this version or is corrupt
+inline bool decodeRecord(const uint8_t* in, size_t len, FrameRecord& out) {
+  if (len < HEADER_SIZE + CRC_SIZE || in[0] != RECORD_FRAME || in[1] != VERSION) return false;
+  size_t count = in[16];
+  size_t body = HEADER_SIZE + count * TARGET_SIZE;
+  if (count > LD2450Proto::MAX_TARGETS || len != body + CRC_SIZE || crc16(in, body) != getU16(in + body)) {
+    return false;
+  }
+  
+  out.frame = getU32(in + 2);
+  out.timeMs = getU32(in + 6);
+  out.parseUs = getU16(in + 10);
+  out.backlog = getU16(in + 12);
+  out.dropped = getU16(in + 14);
+  out.count = (uint8_t)count;
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* p = in + HEADER_SIZE + i * TARGET_SIZE;
+    TargetSample& t = out.targets[i];
+    t.x = (int16_t)getU16(p);
+    t.y = (int16_t)getU16(p + 2);
+    t.speed = (int16_t)getU16(p + 4);
+    t.resolution = getU16(p + 6);
+    t.distanceCm = getU16(p + 8);
+    t.state = p[10];
+    t.flags = p[11];
+    t.hitFrames = p[12];
+    t.missFrames = p[13];
+    t.timeToZoneDs = p[14];
+  }
+  return true;
+}
+
+//========================= COBS =========================
+// Consistent overhead byte stuffing: the output contains no 0x00 bytes.
+// out needs len + len / 254 + 1 bytes. Returns the encoded length
+inline size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t codePos = 0;
+  size_t pos = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] != 0) {
+      out[pos++] = in[i];
+      code++;
+    }
+    if (in[i] == 0 || code == 0xFF) {
+      out[codePos] = code;
+      codePos = pos++;
+      code = 1;
+    }
+  }
+  out[codePos] = code;
+  return pos;
+}
+
+// Decode one frame without its delimiters into out (cap bytes).
+// Returns the decoded length, 0 if the frame is malformed or too long
+inline size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+  size_t pos = 0;
+  size_t i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) return 0;
+    for (uint8_t j = 1; j < code; j++) {
+      if (pos >= cap || in[i] == 0) return 0;
+      out[pos++] = in[i++];
+    }
+    if (code < 0xFF && i < len) {
+      if (pos >= cap) return 0;
+      out[pos++] = 0;
+    }
+  }
+  return pos;
+}
+
+}  // namespace TelemetryProto
+
+#endif // TELEMETRYPROTO_H
@@ -0,0 +1,62 @@
+#include "TelemetryStream.h"
+
+// Global instance
+TelemetryStream telemetryStream;
+
+// Helper functions
+static uint8_t saturate8(uint16_t value) {
+  return value < 0xFF ? (uint8_t)value : 0xFF;
+}
+
+static uint16_t saturate16(unsigned long value) {
+  return value < 0xFFFF ? (uint16_t)value : 0xFFFF;
+}
+
+TelemetryStream::TelemetryStream() : records(0), dropped(0) {
+}
+
+void TelemetryStream::onFrame(const LD2450Proto::Frame& raw, const TargetSnapshot& snapshot,
+                              unsigned long parseUs, size_t rxBacklog, unsigned long now) {
+  TelemetryProto::FrameRecord record;
+  record.frame = snapshot.frameCount;
+  record.timeMs = (uint32_t)now;
+  record.parseUs = saturate16(parseUs);
+  record.backlog = saturate16(rxBacklog);
+  record.dropped = saturate16(dropped);
+  record.count = LD2450_MAX_TARGETS;
+  
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const LD2450Proto::Target& in = raw.targets[i];
+    const TargetInfo& target = snapshot[i];
+    TelemetryProto::TargetSample& out = record.targets[i];
+    out.x = in.x;
+    out.y = in.y;
+    out.speed = in.speed;
+    out.resolution = in.resolution;
+    out.distanceCm = target.lastDistance > 0 ? (uint16_t)target.lastDistance : 0;
+    out.state = (uint8_t)target.state;
+    out.flags = (target.valid ? TelemetryProto::FLAG_VALID : 0) |
+                (target.stateChanged ? TelemetryProto::FLAG_CHANGED : 0) |
+                (target.holding ? TelemetryProto::FLAG_HOLDING : 0);
+    out.hitFrames = saturate8(target.hitFrames);
+    out.missFrames = saturate8(target.missFrames);
+    out.timeToZoneDs = target.timeToZoneDs;
+  }
+  
+  uint8_t encoded[TelemetryProto::MAX_RECORD_SIZE];
+  size_t len = TelemetryProto::encodeRecord(record, encoded);
+  
+  uint8_t wire[TelemetryProto::MAX_WIRE_SIZE];
+  size_t wireLen = 0;
+  wire[wireLen++] = 0;
+  wireLen += TelemetryProto::cobsEncode(encoded, len, wire + wireLen);
+  wire[wireLen++] = 0;
+  
+  // Never block the frame path on a slow or absent USB host
+  if ((size_t)Serial.availableForWrite() < wireLen) {
+    dropped++;
+    return;
+  }
+  Serial.write(wire, wireLen);
+  records++;
+}
@@ -0,0 +1,36 @@
+#ifndef TELEMETRYSTREAM_H
+#define TELEMETRYSTREAM_H
+
+#include <Arduino.h>
+#include "LD2450Manager.h"
+#include "TelemetryProto.h"
+
+// Binary per-frame telemetry on the USB serial port for commissioning.
+//
+// With the "telemetry" radar setting on, every processed radar frame is
+// written as one TelemetryProto record: the raw target values, the
+// presence state machine's view of each slot and the frame timing. The
+// record is built from plain integers, so it costs far less than the
+// printf() lines it replaces. A record that does not fit the serial
+// transmit buffer is dropped instead of blocking loop(); the count of
+// dropped records travels in the next one. tools/telemetry_csv.cpp turns
+// the stream into CSV.
+class TelemetryStream {
+private:
+  unsigned long records;
+  unsigned long dropped;
+
+public:
+  TelemetryStream();
+  
+  // Emit the record for the frame just processed
+  void onFrame(const LD2450Proto::Frame& raw, const TargetSnapshot& snapshot,
+               unsigned long parseUs, size_t rxBacklog, unsigned long now);
+  
+  unsigned long getRecords() const { return records; }
+  unsigned long getDropped() const { return dropped; }
+};
+
+extern TelemetryStream telemetryStream;
+
+#endif // TELEMETRYSTREAM_H
@@ -0,0 +1,147 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timing wheel for up to N timers identified by 0..N-1.
+//
+// Two levels of 64 buckets: level 0 holds timers due within 64 ticks, level
+// 1 those due within 4096 ticks; a level 1 bucket is cascaded into level 0
+// when its turn comes. Buckets are intrusive doubly linked lists over fixed
+// arrays, so schedule() and cancel() are O(1), nothing is allocated, and
+// advance() only touches the timers that are actually due (plus one cascade
+// per 64 ticks). Deadlines farther out are parked in the last reachable
+// bucket and re-filed when it cascades.
+// Plain C++11 only, so it builds for the firmware and the native simulation.
+template <size_t N, unsigned long TICK_MS>
+class TimingWheel {
+  static_assert(N > 0 && N < 0xFFFF, "TimingWheel ids must fit 16 bits");
+  static_assert(TICK_MS > 0, "TimingWheel needs a tick");
+
+private:
+  static constexpr size_t SLOT_BITS = 6;
+  static constexpr size_t SLOTS = 1 << SLOT_BITS;
+  static constexpr size_t SLOT_MASK = SLOTS - 1;
+  static constexpr uint32_t LEVEL1_SPAN = SLOTS * SLOTS;
+  static constexpr uint16_t NIL = 0xFFFF;
+  static constexpr uint8_t UNSCHEDULED = 0xFF;
+  
+  uint16_t heads[2 * SLOTS];   // Level 0 buckets, then level 1 buckets
+  uint16_t next[N];
+  uint16_t prev[N];
+  uint8_t bucketOf[N];
+  uint32_t deadline[N];        // Ticks
+  uint32_t currentTick;
+  uint32_t tickMs;             // millis() value of currentTick, wraps with it
+  size_t scheduled;
+  
+  void link(uint16_t id, uint8_t bucket) {
+    bucketOf[id] = bucket;
+    prev[id] = NIL;
+    next[id] = heads[bucket];
+    if (next[id] != NIL) prev[next[id]] = id;
+    heads[bucket] = id;
+  }
+  
+  void unlink(uint16_t id) {
+    uint8_t bucket = bucketOf[id];
+    if (prev[id] != NIL) {
+      next[prev[id]] = next[id];
+    } else {
+      heads[bucket] = next[id];
+    }
+    if (next[id] != NIL) prev[next[id]] = prev[id];
+    bucketOf[id] = UNSCHEDULED;
+  }
+  
+  // File a timer by its distance from the current tick
+  void place(uint16_t id) {
+    uint32_t delta = deadline[id] - currentTick;
+    if (delta < SLOTS) {
+      link(id, deadline[id] & SLOT_MASK);
+    } else if (delta < LEVEL1_SPAN) {
+      link(id, SLOTS + ((deadline[id] >> SLOT_BITS) & SLOT_MASK));
+    } else {
+      uint32_t parked = currentTick + LEVEL1_SPAN - 1;
+      link(id, SLOTS + ((parked >> SLOT_BITS) & SLOT_MASK));
+    }
+  }
+
+public:
+  explicit TimingWheel(unsigned long nowMs = 0) { reset(nowMs); }
+  
+  void reset(unsigned long nowMs) {
+    for (uint16_t& head : heads) {
+      head = NIL;
+    }
+    for (size_t i = 0; i < N; i++) {
+      bucketOf[i] = UNSCHEDULED;
+    }
+    currentTick = 0;
+    tickMs = (uint32_t)nowMs;
+    scheduled = 0;
+  }
+  
+  // (Re)arm timer id to fire at dueMs; a deadline in the past fires on the
+  // next advance()
+  void schedule(size_t id, unsigned long dueMs) {
+    if (id >= N) return;
+    if (bucketOf[id] != UNSCHEDULED) {
+      unlink((uint16_t)id);
+    } else {
+      scheduled++;
+    }
+    int32_t aheadMs = (int32_t)((uint32_t)dueMs - tickMs);
+    uint32_t ticks = aheadMs > 0 ? (uint32_t)((aheadMs + TICK_MS - 1) / TICK_MS) : 1;
+    deadline[id] = currentTick + ticks;
+    place((uint16_t)id);
+  }
+  
+  void cancel(size_t id) {
+    if (id >= N || bucketOf[id] == UNSCHEDULED) return;
+    unlink((uint16_t)id);
+    scheduled--;
+  }
+  
+  bool isScheduled(size_t id) const { return id < N && bucketOf[id] != UNSCHEDULED; }
+  size_t size() const { return scheduled; }
+  
+  // Run the clock up to nowMs and call fire(id) for every timer that came
+  // due, in deadline order. A timer is disarmed before its callback, which
+  // may schedule it again. Returns the number fired
+  template <typename F>
+  size_t advance(unsigned long nowMs, F fire) {
+    size_t fired = 0;
+    
+    while ((int32_t)((uint32_t)nowMs - tickMs) >= (int32_t)TICK_MS) {
+      currentTick++;
+      tickMs += TICK_MS;
+      
+      // Start of a level 1 period: re-file its bucket by remaining distance
+      if ((currentTick & SLOT_MASK) == 0) {
+        uint8_t bucket = SLOTS + ((currentTick >> SLOT_BITS) & SLOT_MASK);
+        uint16_t id = heads[bucket];
+        heads[bucket] = NIL;
+        while (id != NIL) {
+          uint16_t following = next[id];
+          bucketOf[id] = UNSCHEDULED;
+          place(id);
+          id = following;
+        }
+      }
+      
+      uint8_t bucket = currentTick & SLOT_MASK;
+      while (heads[bucket] != NIL) {
+        uint16_t id = heads[bucket];
+        unlink(id);
+        scheduled--;
+        fired++;
+        fire((size_t)id);
+      }
+    }
+    return fired;
+  }
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,251 @@
+#include "TrajectoryStreamer.h"
+#include "MeshPayload.h"
+
+// Global instance
+TrajectoryStreamer trajectoryStreamer;
+
+// Buffered points are sent at the latest after this long
+static const unsigned long TRACK_MAX_DELAY_MS = 30000;
+
+// Smallest payload worth sending on its own
+static const size_t TRACK_MIN_PAYLOAD = 16;
+
+// Worst case size of one encoded point (three 5-byte varints)
+static const size_t TRACK_MAX_POINT_SIZE = 15;
+
+TrajectoryStreamer::TrajectoryStreamer()
+  : tokens(0), lastRefillTime(0), droppedPoints(0), keyPoints(0), samples(0) {
+  for (TargetTrack& track : tracks) {
+    track.head = 0;
+    track.count = 0;
+    track.encoded = 0;
+    track.active = false;
+    track.hasPrevKey = false;
+  }
+}
+
+void TrajectoryStreamer::pushPoint(TargetTrack& track, const TrackPoint& point) {
+  if (track.count == TRACK_RING_SIZE) {
+    // Budget cannot keep up - drop the oldest point but keep the track start
+    uint8_t startFlag = track.ring[track.head].flags & TRACK_POINT_START;
+    track.head = (track.head + 1) % TRACK_RING_SIZE;
+    track.count--;
+    track.ring[track.head].flags |= startFlag;
+    droppedPoints++;
+  }
+  
+  track.ring[(track.head + track.count) % TRACK_RING_SIZE] = point;
+  track.count++;
+}
+
+void TrajectoryStreamer::takeKeyPoint(TargetTrack& track, const TrackPoint& point) {
+  track.prevKey = track.key;
+  track.hasPrevKey = !(point.flags & TRACK_POINT_START);
+  track.key = point;
+  pushPoint(track, point);
+  keyPoints++;
+}
+
+void TrajectoryStreamer::refill(uint16_t budgetBytesPerMin, unsigned long now) {
+  unsigned long dt = now - lastRefillTime;
+  lastRefillTime = now;
+  
+  // Bucket holds at most one minute of budget. After the budget was lowered
+  // the bucket can hold more than the new cap and is cut back to it
+  uint32_t cap = (uint32_t)budgetBytesPerMin * 1000;
+  uint32_t add = (uint32_t)((uint64_t)budgetBytesPerMin * dt / 60);
+  tokens = (tokens >= cap || cap - tokens < add) ? cap : tokens + add;
+}
+
+void TrajectoryStreamer::onFrame(const TargetSnapshot& snapshot, const LD2450Config& config, unsigned long now) {
+  if (config.trackBudgetBpm == 0) {
+    // Streaming off - forget everything so a later start is clean
+    for (TargetTrack& track : tracks) {
+      track.count = 0;
+      track.active = false;
+    }
+    tokens = 0;
+    lastRefillTime = now;
+    return;
+  }
+  
+  refill(config.trackBudgetBpm, now);
+  int32_t tolerance = config.trackToleranceCm;
+  
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    const TargetInfo& info = snapshot[i];
+    TargetTrack& track = tracks[i];
+    
+    if (info.state == PRESENT && info.valid) {
+      samples++;
+      TrackPoint point = { (uint32_t)now, (int16_t)(info.lastX / 10), (int16_t)(info.lastY / 10), 0 };
+      
+      if (!track.active) {
+        point.flags = TRACK_POINT_START;
+        track.active = true;
+        takeKeyPoint(track, point);
+      } else {
+        // Position extrapolated at constant velocity from the last two key points
+        int32_t px = track.key.x;
+        int32_t py = track.key.y;
+        if (track.hasPrevKey && track.key.time != track.prevKey.time) {
+          int32_t elapsed = (int32_t)(point.time - track.key.time);
+          int32_t span = (int32_t)(track.key.time - track.prevKey.time);
+          px += (int32_t)((int64_t)(track.key.x - track.prevKey.x) * elapsed / span);
+          py += (int32_t)((int64_t)(track.key.y - track.prevKey.y) * elapsed / span);
+        }
+        
+        int32_t dx = point.x - px;
+        int32_t dy = point.y - py;
+        if (dx * dx + dy * dy > tolerance * tolerance) {
+          takeKeyPoint(track, point);
+        }
+      }
+      track.lastSample = point;
+    } else if (track.active && info.state != PRESENT) {
+      // Track ended - close it on the last measured position
+      track.active = false;
+      int newest = (track.head + track.count - 1) % TRACK_RING_SIZE;
+      if (track.count > 0 && track.ring[newest].time == track.lastSample.time) {
+        track.ring[newest].flags |= TRACK_POINT_END;
+      } else {
+        TrackPoint end = track.lastSample;
+        end.flags = TRACK_POINT_END;
+        pushPoint(track, end);
+        keyPoints++;
+      }
+    }
+  }
+}
+
+int TrajectoryStreamer::pendingPoints() const {
+  int pending = 0;
+  for (const TargetTrack& track : tracks) {
+    pending += track.count;
+  }
+  return pending;
+}
+
+unsigned long TrajectoryStreamer::oldestPendingTime() const {
+  bool found = false;
+  unsigned long oldest = 0;
+  for (const TargetTrack& track : tracks) {
+    if (track.count == 0) continue;
+    unsigned long t = track.ring[track.head].time;
+    if (!found || (long)(t - oldest) < 0) {
+      oldest = t;
+      found = true;
+    }
+  }
+  return oldest;
+}
+
+bool TrajectoryStreamer::ready(uint16_t budgetBytesPerMin, unsigned long now) const {
+  if (budgetBytesPerMin == 0) {
+    return false;
+  }
+  
+  int pending = pendingPoints();
+  if (pending == 0) {
+    return false;
+  }
+  
+  // Wait until the budget allows a reasonably full payload, unless points
+  // have been buffered for too long
+  size_t available = tokens / 1000;
+  size_t estimate = MESH_PAYLOAD_HEADER_SIZE + 1 + pending * 4;
+  bool overdue = now - oldestPendingTime() >= TRACK_MAX_DELAY_MS;
+  return available >= TRACK_MIN_PAYLOAD && (overdue || estimate >= available);
+}
+
+// MSG_TRACK body: section count, then per section a header byte
+// (slot | start << 2 | end << 3), the point count and the points as varints.
+// Times are in 0.1 s: the first point gives its age at send time, later
+// points the time since the previous one. Positions are in cm: absolute for
+// the first point, deltas afterwards (zigzag).
+size_t TrajectoryStreamer::encodeTracks(uint8_t* out, size_t cap, unsigned long now) {
+  size_t limit = tokens / 1000;
+  if (limit > cap) limit = cap;
+  if (limit < MESH_PAYLOAD_HEADER_SIZE + 1 + 2 + TRACK_MAX_POINT_SIZE) {
+    return 0;
+  }
+  
+  size_t pos = 0;
+  out[pos++] = MESH_PAYLOAD_VERSION;
+  out[pos++] = MSG_TRACK;
+  size_t sectionCountPos = pos++;
+  uint8_t sections = 0;
+  uint32_t nowDs = now / 100;
+  
+  for (int i = 0; i < LD2450_MAX_TARGETS; i++) {
+    TargetTrack& track = tracks[i];
+    track.encoded = 0;
+    
+    int idx = 0;
+    while (idx < track.count && pos + 2 + TRACK_MAX_POINT_SIZE <= limit) {
+      // New section - header and count are filled in once it is complete
+      size_t headerPos = pos;
+      pos += 2;
+      uint8_t header = (uint8_t)i;
+      uint8_t points = 0;
+      const TrackPoint* prev = nullptr;
+      
+      while (idx < track.count) {
+        const TrackPoint& point = track.ring[(track.head + idx) % TRACK_RING_SIZE];
+        uint8_t tmp[TRACK_MAX_POINT_SIZE];
+        size_t len = 0;
+        uint32_t pointDs = point.time / 100;
+        if (!prev) {
+          payloadPutVarint(tmp, len, sizeof(tmp), nowDs - pointDs);
+          payloadPutVarint(tmp, len, sizeof(tmp), payloadZigZag(point.x));
+          payloadPutVarint(tmp, len, sizeof(tmp), payloadZigZag(point.y));
+        } else {
+          payloadPutVarint(tmp, len, sizeof(tmp), pointDs - prev->time / 100);
+          payloadPutVarint(tmp, len, sizeof(tmp), payloadZigZag(point.x - prev->x));
+          payloadPutVarint(tmp, len, sizeof(tmp), payloadZigZag(point.y - prev->y));
+        }
+        if (pos + len > limit) break;
+        
+        memcpy(out + pos, tmp, len);
+        pos += len;
+        if (points == 0 && (point.flags & TRACK_POINT_START)) header |= 0x04;
+        points++;
+        idx++;
+        prev = &point;
+        
+        if (point.flags & TRACK_POINT_END) {
+          header |= 0x08;
+          break;
+        }
+      }
+      
+      if (points == 0) {
+        pos = headerPos;
+        break;
+      }
+      out[headerPos] = header;
+      out[headerPos + 1] = points;
+      sections++;
+    }
+    track.encoded = idx;
+  }
+  
+  out[sectionCountPos] = sections;
+  return sections > 0 ? pos : 0;
+}
+
+void TrajectoryStreamer::commitSent(size_t len) {
+  for (TargetTrack& track : tracks) {
+    track.head = (track.head + track.encoded) % TRACK_RING_SIZE;
+    track.count -= track.encoded;
+    track.encoded = 0;
+  }
+  
+  uint32_t spent = (uint32_t)len * 1000;
+  tokens = tokens > spent ? tokens - spent : 0;
+}
+
+void TrajectoryStreamer::printStatus() const {
+  Serial.printf("Tracks: %lu samples, %lu key points, %d pending, %lu dropped, budget %lu B\n",
+    samples, keyPoints, pendingPoints(), droppedPoints, (unsigned long)(tokens / 1000));
+}
@@ -0,0 +1,83 @@
+#ifndef TRAJECTORYSTREAMER_H
+#define TRAJECTORYSTREAMER_H
+
+#include <Arduino.h>
+#include "LD2450Manager.h"
+
+// Unsent key points kept per target
+static constexpr int TRACK_RING_SIZE = 32;
+
+// Key point flags
+static constexpr uint8_t TRACK_POINT_START = 0x01;  // First point of a track (entry)
+static constexpr uint8_t TRACK_POINT_END = 0x02;    // Last point of a track (exit)
+
+struct TrackPoint {
+  uint32_t time;  // ms
+  int16_t x;      // cm
+  int16_t y;      // cm
+  uint8_t flags;
+};
+
+// Per-target simplification state and key point ring
+struct TargetTrack {
+  TrackPoint ring[TRACK_RING_SIZE];
+  uint8_t head;         // Oldest unsent point
+  uint8_t count;
+  uint8_t encoded;      // Points taken by the last encodeTracks()
+  
+  // Dead reckoning from the last two key points
+  bool active;
+  TrackPoint key;
+  TrackPoint prevKey;
+  bool hasPrevKey;
+  TrackPoint lastSample;
+};
+
+// Streams approximate walking paths within a byte budget.
+//
+// Each target's live positions are simplified online by dead reckoning: the
+// path is extrapolated at constant velocity from the last two key points and
+// a new key point is only taken when the measured position deviates by more
+// than the tolerance. Key points are buffered per target and sent as
+// delta-encoded MSG_TRACK payloads, paced by a token bucket refilled at the
+// configured bytes per minute. If the budget cannot keep up the oldest
+// buffered points are dropped.
+class TrajectoryStreamer {
+private:
+  TargetTrack tracks[LD2450_MAX_TARGETS];
+  uint32_t tokens;            // Payload bytes that may be sent now, x1000
+  unsigned long lastRefillTime;
+  unsigned long droppedPoints;
+  unsigned long keyPoints;
+  unsigned long samples;
+  
+  // Helper functions
+  void pushPoint(TargetTrack& track, const TrackPoint& point);
+  void takeKeyPoint(TargetTrack& track, const TrackPoint& point);
+  void refill(uint16_t budgetBytesPerMin, unsigned long now);
+  int pendingPoints() const;
+  unsigned long oldestPendingTime() const;
+
+public:
+  TrajectoryStreamer();
+  
+  // Feed one processed frame; budgetBytesPerMin = 0 turns streaming off
+  void onFrame(const TargetSnapshot& snapshot, const LD2450Config& config, unsigned long now);
+  
+  // True when enough points are buffered (or old enough) and the budget
+  // allows sending them
+  bool ready(uint16_t budgetBytesPerMin, unsigned long now) const;
+  
+  // Encode buffered key points as MSG_TRACK (see MeshPayload.h), limited by
+  // cap and the remaining budget. Call commitSent() once the radio accepted
+  // it. Returns the encoded length, 0 if nothing fits
+  size_t encodeTracks(uint8_t* out, size_t cap, unsigned long now);
+  void commitSent(size_t len);
+  
+  // Status
+  void printStatus() const;
+};
+
+extern TrajectoryStreamer trajectoryStreamer;
+
+#endif // TRAJECTORYSTREAMER_H
@@ -0,0 +1,46 @@
+#ifndef VERSIONED_H
+#define VERSIONED_H
+
+#include <atomic>
+#include <stddef.h>
+
+// Immutable, atomically swapped versions of a settings struct.
+//
+// The writer builds the next version in a spare slot and publishes it with
+// a single release store of the pointer; readers get the current version
+// with a single acquire load and never block or retry. A published version
+// is never written again until the slots have gone round, so a reader must
+// let go of its reference before SLOTS - 1 newer versions were published.
+// Settings only change on operator commands while readers hold a version for
+// one frame or one loop() pass, so a handful of slots is plenty.
+// Single writer; plain C++11, so it builds for the firmware and the simulation.
+template <typename T, size_t SLOTS = 4>
+class Versioned {
+  static_assert(SLOTS >= 2, "Versioned needs a spare slot");
+
+private:
+  T slots[SLOTS];
+  std::atomic<const T*> current;
+  size_t head;   // Slot of the published version
+
+public:
+  Versioned() : slots(), current(&slots[0]), head(0) {}
+  
+  // Reader side - safe from any task
+  const T& get() const { return *current.load(std::memory_order_acquire); }
+  
+  // Writer side: the next version, starting as a copy of the current one
+  T& prepare() {
+    size_t next = (head + 1) % SLOTS;
+    slots[next] = slots[head];
+    return slots[next];
+  }
+  
+  // Writer side: make the prepared version current
+  void publish() {
+    head = (head + 1) % SLOTS;
+    current.store(&slots[head], std::memory_order_release);
+  }
+};
+
+#endif // VERSIONED_H
@@ -1,113 +1,286 @@
 #include <Arduino.h>
 #include "LD2450Manager.h"
+#include "OccupancyAggregator.h"
+#include "OccupancyHeatmap.h"
+#include "TrajectoryStreamer.h"
+#include "LoadSupervisor.h"
+#include "BleScanner.h"
+#include "BeaconFusion.h"
+#include "EventJournal.h"
+#include "TelemetryStream.h"
+#include "MeshFragment.h"
 #include "MeshtasticComm.h"
 #include "ConfigManager.h"
 #include "DisplayManager.h"
+#include "Hal.h"
+#include "MeshtasticProto.h"
 
 // Display Manager Instance
 DisplayManager* displayManager = nullptr;
 
 void setup() {
+  // No wait for the USB serial console: after a brown-out or watchdog
+  // reset the safety zone must be monitored again as soon as possible
   Serial.begin(115200);
-  delay(1000);
   
   Serial.println("\n=====================================================");
   Serial.println("LD2450 mmWave Sensor - Mechaniker Tracking");
   Serial.println("=====================================================\n");
   
-  // Initialize Display Manager
-  displayManager = new DisplayManager(5, 6); // SDA=5, SCL=6
-  displayManager->init();
+  // Initialize LD2450 Sensor Manager first so frames are buffered while the
+  // rest starts up. Uses UART2 with Standalone Binary Protocol Parser
+  Serial.println("Initializing LD2450 Sensor...");
+  ld2450Manager.init();
   
-  // Initialize ConfigManager for Meshtastic config
+  // Initialize ConfigManager for Meshtastic config (loads NVS once)
   ConfigManager::init();
-  ConfigManager::loadFromNVS();
+  
+  // Event journal in flash, resumes draining what a previous boot left
+  eventJournal.init();
+  
+  // Continuous BLE scan in the background, uses the scan settings loaded above
+  bleScanner.init();
   
   // Initialize UART1 for Meshtastic (TX=GPIO43, RX=GPIO44, 115200 baud)
   Serial.println("Initializing UART1 for Meshtastic...");
-  Serial1.begin(115200, SERIAL_8N1, 44, 43);
+  Hal::meshUart().begin(115200, SERIAL_8N1, 44, 43);
   Serial.println("UART1 initialized (Meshtastic @ 115200 baud)");
   initMeshtasticComm();
   
-  // Initialize LD2450 Sensor Manager
-  // Uses UART2 with Standalone Binary Protocol Parser
-  Serial.println("Initializing LD2450 Sensor...");
-  ld2450Manager.init();
+  // Initialize Display Manager - the splash screen does not block
+  displayManager = new DisplayManager(5, 6); // SDA=5, SCL=6
+  displayManager->init();
   
   Serial.println("=====================================================");
-  Serial.println("System ready. Waiting for sensor data and commands...");
+  Serial.printf("System ready after %lu ms. Waiting for sensor data and commands...\n", Hal::millis());
   Serial.println("=====================================================\n");
 }
 
 void loop() {
+  loadSupervisor.beginIteration();
+  
   // Check for incoming Meshtastic configuration commands
   checkForMeshtasticCommands();
   
   // Read LD2450 sensor data
-  if (ld2450Manager.readSensor()) {
+  ld2450Manager.readSensor();
+  
+  // Apply queued BLE advertisements to the beacon table
+  bleScanner.process(Hal::millis());
+  
+  // One consistent view of all targets for this iteration
+  const TargetSnapshot& snapshot = ld2450Manager.getSnapshot();
+  
+  // State change flags belong to a frame - handle each frame only once
+  static uint32_t lastHandledFrame = 0;
+  bool newFrame = (snapshot.frameCount != lastHandledFrame);
+  lastHandledFrame = snapshot.frameCount;
+  
+  if (newFrame) {
     // Sensor returned data - check for state changes
-    for (int i = 0; i < 3; i++) {
-      if (ld2450Manager.hasTargetStateChanged(i)) {
+    for (int i = 0; i < TargetSnapshot::capacity(); i++) {
+      if (snapshot[i].stateChanged) {
         Serial.printf("Target %d state changed to: %s\n", 
           i + 1, 
-          ld2450Manager.isTargetPresent(i) ? "PRESENT" : "ABSENT");
+          snapshot[i].state == PRESENT ? "PRESENT" : "ABSENT");
+      }
+    }
+  }
+  
+  const ConfigSnapshot& config = ld2450Manager.getConfig();
+  bool summaryMode = config.summaryWindowS > 0;
+  
+  // Binary telemetry replaces the periodic text output on the USB port
+  if (newFrame && config.telemetryEnable) {
+    telemetryStream.onFrame(ld2450Manager.getLastFrame(), snapshot, ld2450Manager.getLastParseUs(),
+                            ld2450Manager.getRxBacklog(), Hal::millis());
+  }
+  bool textOutput = loadSupervisor.statusOutputAllowed() && !config.telemetryEnable;
+  
+  // Occupancy statistics and safety zone alerts are updated every frame
+  uint8_t alerts = 0;
+  if (newFrame) {
+    occupancyAggregator.onFrame(snapshot, config, Hal::millis());
+    occupancyHeatmap.onFrame(snapshot, Hal::millis());
+    trajectoryStreamer.onFrame(snapshot, config, Hal::millis());
+    beaconFusion.onFrame(snapshot, Hal::millis());
+    alerts = occupancyAggregator.takeAlerts();
+  }
+  
+  // In event mode every entry, exit and safety zone alert is journaled first
+  // and reaches the mesh in batches; only if the journal cannot take an event
+  // does the transition fall back to an immediate presence report
+  bool journalFailed = false;
+  if (newFrame && !summaryMode) {
+    for (int i = 0; i < TargetSnapshot::capacity(); i++) {
+      if (snapshot[i].stateChanged &&
+          !eventJournal.append(i, snapshot[i].state == PRESENT ? EVENT_ENTRY : EVENT_EXIT,
+                               snapshot[i].lastDistance, Hal::millis())) {
+        journalFailed = true;
+      }
+      if ((alerts >> i) & 1) {
+        eventJournal.append(i, EVENT_ALERT, snapshot[i].lastDistance, Hal::millis());
       }
     }
   }
   
-  // Send payload only when state changes (after debounce)
-  bool anyStateChanged = false;
-  for (int i = 0; i < 3; i++) {
-    if (ld2450Manager.hasTargetStateChanged(i)) {
-      anyStateChanged = true;
-      break;
+  // Presence reports carry the full state, so only the latest one matters:
+  // it waits for the radio to accept it and is resent if it was not delivered.
+  // Safety zone entries are always reported immediately.
+  static bool presencePending = false;
+  static uint32_t presencePacketId = 0;
+  if (newFrame && snapshot.anyStateChanged) {
+    if (textOutput) {
+      Serial.println(">>> State changed! Payload:");
+      Serial.println(ld2450Manager.generatePayload());
     }
+    if (journalFailed) presencePending = true;
+  }
+  if (alerts) {
+    presencePending = true;
   }
   
-  if (anyStateChanged) {
-    String payload = ld2450Manager.generatePayload();
-    
-    Serial.println(">>> State changed! Sending payload:");
-    Serial.println(payload);
-    Serial.printf("Payload size: %d bytes\n\n", payload.length());
+  if (presencePacketId != 0) {
+    MeshDelivery delivery = getMeshDelivery(presencePacketId);
+    if (delivery != MESH_PENDING) {
+      if (delivery != MESH_DELIVERED) presencePending = true;
+      presencePacketId = 0;
+    }
+  }
+  
+  if (presencePending && meshCanSend()) {
+    uint8_t payload[MeshProto::MAX_DATA_PAYLOAD];
+    size_t len = ld2450Manager.encodePresencePayload(payload, sizeof(payload));
     
     // Send via Meshtastic
-    Serial1.println(payload);
+    uint32_t id = len > 0 ? sendMeshPayload(payload, len) : 0;
+    if (id != 0) {
+      presencePacketId = id;
+      presencePending = false;
+    }
+  }
+  
+  // Everything below presence reports can wait while the loop is overloaded
+  bool deferrableMesh = loadSupervisor.deferrableMeshAllowed();
+  
+  // Close the occupancy window; the encoded summary is kept until the radio
+  // confirmed it and resent if it was not delivered. Meanwhile the next
+  // window keeps running, so nothing is lost while the mesh is down
+  static uint8_t summary[MeshProto::MAX_DATA_PAYLOAD];
+  static size_t summaryLen = 0;
+  static uint32_t summaryPacketId = 0;
+  if (summaryPacketId != 0) {
+    MeshDelivery delivery = getMeshDelivery(summaryPacketId);
+    if (delivery != MESH_PENDING) {
+      if (delivery == MESH_DELIVERED) summaryLen = 0;
+      summaryPacketId = 0;
+    }
+  }
+  if (summaryMode && summaryLen == 0 &&
+      occupancyAggregator.windowElapsed(config.summaryWindowS * 1000UL, Hal::millis())) {
+    summaryLen = occupancyAggregator.encodeSummary(summary, sizeof(summary), config.deviceName, Hal::millis());
+  }
+  
+  if (summaryLen > 0 && summaryPacketId == 0 && deferrableMesh && !presencePending && meshCanSend()) {
+    summaryPacketId = sendMeshPayload(summary, summaryLen);
+  }
+  
+  // Journaled events, one batch at a time: the next batch is only read once
+  // the radio confirmed the previous one, which is always sent with want_ack
+  static uint32_t journalPacketId = 0;
+  if (journalPacketId != 0) {
+    MeshDelivery delivery = getMeshDelivery(journalPacketId);
+    if (delivery != MESH_PENDING) {
+      eventJournal.batchDone(delivery == MESH_DELIVERED, Hal::millis());
+      journalPacketId = 0;
+    }
+  }
+  if (journalPacketId == 0 && eventJournal.drainDue(Hal::millis()) && deferrableMesh &&
+      !presencePending && meshCanSend()) {
+    uint8_t batch[MeshProto::MAX_DATA_PAYLOAD];
+    size_t len = eventJournal.encodeBatch(batch, sizeof(batch), Hal::millis());
+    if (len > 0) {
+      journalPacketId = sendMeshPayloadTo(ConfigManager::getMeshDest(), ConfigManager::getMeshChannel(),
+                                          batch, len, true);
+    }
+  }
+  
+  // Beacon identities: only the latest assignment matters, sent after changes
+  static bool identityPending = false;
+  if (beaconFusion.takeChange()) {
+    identityPending = true;
+  }
+  if (identityPending && deferrableMesh && !presencePending && meshCanSend()) {
+    uint8_t identity[MeshProto::MAX_DATA_PAYLOAD];
+    size_t len = beaconFusion.encodeIdentities(identity, sizeof(identity));
+    if (len > 0 && sendMeshPayload(identity, len)) {
+      identityPending = false;
+    }
+  }
+  
+  // Trajectory key points, paced by their own byte budget
+  if (trajectoryStreamer.ready(config.trackBudgetBpm, Hal::millis()) && deferrableMesh &&
+      !presencePending && meshCanSend()) {
+    uint8_t track[MeshProto::MAX_DATA_PAYLOAD];
+    size_t len = trajectoryStreamer.encodeTracks(track, sizeof(track), Hal::millis());
+    if (len > 0 && sendMeshPayload(track, len)) {
+      trajectoryStreamer.commitSent(len);
+    }
+  }
+  
+  // Replies longer than a packet (configuration readout, heatmap export), one
+  // fragment per free radio slot. The receiver acknowledges the whole
+  // message, so the fragments go without want_ack
+  if (meshFragments.sendPending() && deferrableMesh && !presencePending && meshCanSend()) {
+    uint8_t fragment[MeshProto::MAX_DATA_PAYLOAD];
+    size_t len = meshFragments.encodeNextFragment(fragment, sizeof(fragment));
+    if (len > 0 && sendMeshPayloadTo(meshFragments.getSendNode(), meshFragments.getSendChannel(),
+                                     fragment, len, false)) {
+      meshFragments.fragmentSent(Hal::millis());
+    }
   }
   
   // Print detailed status periodically
   static unsigned long lastStatusPrint = 0;
-  if (millis() - lastStatusPrint > 10000) {
+  if (Hal::millis() - lastStatusPrint > 10000 && textOutput) {
     ld2450Manager.printTargetStatus();
-    lastStatusPrint = millis();
+    occupancyAggregator.printStatus(Hal::millis());
+    if (config.trackBudgetBpm > 0) trajectoryStreamer.printStatus();
+    bleScanner.printStatus();
+    beaconFusion.printStatus();
+    eventJournal.printStatus();
+    meshFragments.printStatus();
+    
+    // Heap health: a shrinking largest block with steady free heap means
+    // fragmentation, so its lowest value since boot is reported as well
+    static uint32_t minLargestBlock = UINT32_MAX;
+    uint32_t largestBlock = ESP.getMaxAllocHeap();
+    if (largestBlock < minLargestBlock) minLargestBlock = largestBlock;
+    Serial.printf("Heap: %lu free, %lu min free, %lu largest block (min %lu)\n",
+      (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+      (unsigned long)largestBlock, (unsigned long)minLargestBlock);
+    loadSupervisor.printStatus();
+    lastStatusPrint = Hal::millis();
   }
   
   // Update display if available
   if (displayManager) {
-    // Get all target info
-    bool t1Present = ld2450Manager.isTargetPresent(0);
-    bool t2Present = ld2450Manager.isTargetPresent(1);
-    bool t3Present = ld2450Manager.isTargetPresent(2);
-    
-    // Get INDIVIDUAL distances for each target (in cm)
-    int t1DistCm = ld2450Manager.getTargetDistanceCm(0);
-    int t2DistCm = ld2450Manager.getTargetDistanceCm(1);
-    int t3DistCm = ld2450Manager.getTargetDistanceCm(2);
+    displayManager->setUpdateInterval(loadSupervisor.displayInterval(UPDATE_INTERVAL));
     
-    // Update display with all target info
-    displayManager->updateDisplay(
-      ld2450Manager.getConfig().deviceName,
-      t1Present, t1DistCm,
-      t2Present, t2DistCm,
-      t3Present, t3DistCm,
-      ld2450Manager.getClosestDistanceCm(),
-      ld2450Manager.getConfig().rangeMaxCm,
-      ld2450Manager.getConfig().filterEnable
-    );
+    // Update display with all target info; it switches itself on and off.
+    // Drawn from the published copy so it can move to its own task unchanged
+    static TargetSnapshot displaySnapshot;
+    ld2450Manager.readPublishedSnapshot(displaySnapshot);
+    displayManager->updateDisplay(config, displaySnapshot);
     
     displayManager->updateMeasurementTime();
-    displayManager->turnDisplayOn();
   }
   
-  delay(50);  // Small delay for responsiveness
+  // Radar frames or a full BLE batch still queued are handled on the next
+  // pass without sleeping
+  size_t rxBacklog = ld2450Manager.getRxBacklog();
+  loadSupervisor.endIteration(rxBacklog, ConfigManager::getLoopBudgetMs());
+  if (rxBacklog < LD2450Proto::FRAME_SIZE && bleScanner.getBacklog() < BLE_BATCH_MAX) {
+    Hal::delay(50);  // Small delay for responsiveness
+  }
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+// Microbenchmark: per-sample cost of the beacon filters on an RSSI stream,
+// with the moving average against a sum recomputed over the window on every
+// sample. Prints ns per sample; fails only if the averages disagree.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "Filters.h"
+
+static const size_t SAMPLES = 4096;
+static const int ROUNDS = 500;
+
+static std::vector<float> rssi;
+static volatile float sink;
+
+// Mean over the whole window on every sample, the textbook version
+class RecomputedAverage {
+private:
+  float samples[MOVING_AVERAGE_MAX_WINDOW];
+  size_t head;
+  size_t count;
+  size_t window;
+
+public:
+  explicit RecomputedAverage(size_t activeWindow) : head(0), count(0), window(activeWindow) {}
+  
+  float add(float sample) {
+    samples[head] = sample;
+    head = (head + 1) % window;
+    if (count < window) count++;
+    float sum = 0;
+    for (size_t i = 0; i < count; i++) {
+      sum += samples[i];
+    }
+    return sum / (float)count;
+  }
+};
+
+// Best of three runs, to keep scheduler noise out
+template <typename Sample>
+static double nsPerSample(Sample sample, float& last) {
+  double best = 0;
+  for (int run = 0; run < 3; run++) {
+    float total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+      for (size_t n = 0; n < SAMPLES; n++) {
+        last = sample(rssi[n]);
+        total += last;
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = total;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ((double)ROUNDS * SAMPLES);
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+static void report(const char* name, double ns) {
+  char line[96];
+  snprintf(line, sizeof(line), "%s: %.2f ns/sample", name, ns);
+  TEST_MESSAGE(line);
+}
+
+void setUp(void) {
+  if (!rssi.empty()) return;
+  
+  // -60..-90 dBm with occasional deep fades
+  uint32_t state = 0x4242;
+  rssi.resize(SAMPLES);
+  for (float& value : rssi) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    value = -60.0f - (float)(state % 31) - ((state >> 8) % 16 == 0 ? 15.0f : 0.0f);
+  }
+}
+
+void tearDown(void) {
+}
+
+void test_bench_kalman(void) {
+  KalmanFilter filter(-70);
+  float last = 0;
+  report("Kalman::update", nsPerSample([&](float m) { return filter.update(m, 0.01f, 0.5f); }, last));
+  
+  KalmanFilter configured(-70);
+  report("Kalman::update (configured noise)", nsPerSample([&](float m) { return configured.update(m); }, last));
+  TEST_ASSERT_TRUE(last < -60.0f && last > -105.0f);
+}
+
+void test_bench_moving_average(void) {
+  const size_t windows[] = { 5, MOVING_AVERAGE_MAX_WINDOW };
+  for (size_t window : windows) {
+    RecomputedAverage reference(window);
+    MovingAverageFilter filter(window);
+    float referenceLast = 0;
+    float filterLast = 0;
+    double referenceNs = nsPerSample([&](float m) { return reference.add(m); }, referenceLast);
+    double filterNs = nsPerSample([&](float m) { return filter.add(m); }, filterLast);
+    
+    char line[96];
+    snprintf(line, sizeof(line), "window %u recomputed: %.2f ns/sample", (unsigned)window, referenceNs);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "window %u MovingAverage::add: %.2f ns/sample (x%.2f)", (unsigned)window,
+             filterNs, filterNs > 0 ? referenceNs / filterNs : 0.0);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, referenceLast, filterLast);
+  }
+  
+  MovingAverageFilter configured;
+  float last = 0;
+  report("MovingAverage::addConfigured", nsPerSample([&](float m) { return configured.addConfigured(m); }, last));
+  TEST_ASSERT_EQUAL((size_t)ConfigManager::getWindowSize(), configured.getWindow());
+}
+
+void test_bench_moving_average_batch(void) {
+  MovingAverageFilter filter(MOVING_AVERAGE_MAX_WINDOW);
+  double best = 0;
+  float average = 0;
+  for (int run = 0; run < 3; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+      average = filter.addBatch(rssi.data(), SAMPLES);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = average;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ((double)ROUNDS * SAMPLES);
+    if (run == 0 || ns < best) best = ns;
+  }
+  report("MovingAverage::addBatch", best);
+  
+  float sum = 0;
+  for (size_t n = SAMPLES - MOVING_AVERAGE_MAX_WINDOW; n < SAMPLES; n++) {
+    sum += rssi[n];
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, sum / MOVING_AVERAGE_MAX_WINDOW, average);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_kalman);
+  RUN_TEST(test_bench_moving_average);
+  RUN_TEST(test_bench_moving_average_batch);
+  return UNITY_END();
+}
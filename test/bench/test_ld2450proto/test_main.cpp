@@ -0,0 +1,138 @@
+// Microbenchmark: LD2450Proto::decodeFrame against the branchy per-field
+// decoder it replaced, over a buffer of recorded-like frames with random
+// signs. Prints ns per frame; fails only if the two decoders disagree.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "LD2450Proto.h"
+
+using namespace LD2450Proto;
+
+static const size_t FRAMES = 4096;
+static const int ROUNDS = 200;
+
+static std::vector<uint8_t> frames;
+static volatile uint32_t sink;
+
+// The decoder before LD2450Proto: one branch on the sign bit per field
+static int16_t referenceDecode(uint8_t lowByte, uint8_t highByte) {
+  int16_t magnitude = ((highByte & 0x7F) << 8) | lowByte;
+  if ((highByte & 0x80) == 0) {
+    return -magnitude;
+  }
+  return magnitude;
+}
+
+static void referenceDecodeFrame(const uint8_t* buf, Frame& out) {
+  for (size_t i = 0; i < MAX_TARGETS; i++) {
+    const uint8_t* t = buf + 4 + i * 8;
+    out.targets[i].x = referenceDecode(t[0], t[1]);
+    out.targets[i].y = referenceDecode(t[2], t[3]);
+    out.targets[i].speed = referenceDecode(t[4], t[5]);
+    out.targets[i].resolution = t[6] | (t[7] << 8);
+  }
+}
+
+static uint32_t checksum(const Frame& frame) {
+  uint32_t sum = 0;
+  for (const Target& t : frame.targets) {
+    sum += (uint32_t)(t.x * 3 + t.y * 5 + t.speed * 7 + t.resolution);
+  }
+  return sum;
+}
+
+// Best of three runs, to keep scheduler noise out
+template <typename Decode>
+static double nsPerFrame(Decode decode, uint32_t& total) {
+  double best = 0;
+  for (int run = 0; run < 3; run++) {
+    Frame frame;
+    total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+      for (size_t n = 0; n < FRAMES; n++) {
+        decode(&frames[n * FRAME_SIZE], frame);
+        total += checksum(frame);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = total;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ((double)ROUNDS * FRAMES);
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+void setUp(void) {
+  if (!frames.empty()) return;
+  
+  // People within 6 m, both signs, random slot occupancy
+  uint32_t state = 0x2450;
+  auto next = [&state]() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  };
+  frames.resize(FRAMES * FRAME_SIZE);
+  for (size_t n = 0; n < FRAMES; n++) {
+    Frame frame;
+    for (Target& t : frame.targets) {
+      bool occupied = next() % 3 != 0;
+      t.x = (int16_t)(next() % 6001) - 3000;
+      t.y = (int16_t)(next() % 6001);
+      t.speed = (int16_t)(next() % 401) - 200;
+      t.resolution = occupied ? 320 : 0;
+    }
+    encodeFrame(frame, &frames[n * FRAME_SIZE]);
+  }
+}
+
+void tearDown(void) {
+}
+
+void test_bench_decode_frame(void) {
+  uint32_t reference;
+  uint32_t codec;
+  double referenceNs = nsPerFrame(referenceDecodeFrame, reference);
+  double codecNs = nsPerFrame(decodeFrame, codec);
+  
+  char line[96];
+  snprintf(line, sizeof(line), "branchy decode: %.2f ns/frame", referenceNs);
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "LD2450Proto::decodeFrame: %.2f ns/frame (x%.2f)", codecNs,
+           codecNs > 0 ? referenceNs / codecNs : 0.0);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL(reference, codec);
+}
+
+void test_bench_encode_frame(void) {
+  Frame frame;
+  uint8_t buf[FRAME_SIZE];
+  uint32_t total = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (size_t n = 0; n < FRAMES; n++) {
+      decodeFrame(&frames[n * FRAME_SIZE], frame);
+      encodeFrame(frame, buf);
+      total += buf[n % FRAME_SIZE];
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  sink = total;
+  
+  char line[96];
+  snprintf(line, sizeof(line), "decodeFrame + encodeFrame: %.2f ns/frame",
+           std::chrono::duration<double, std::nano>(elapsed).count() / ((double)ROUNDS * FRAMES));
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_MEMORY(&frames[(FRAMES - 1) * FRAME_SIZE], buf, FRAME_SIZE);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_decode_frame);
+  RUN_TEST(test_bench_encode_frame);
+  return UNITY_END();
+}
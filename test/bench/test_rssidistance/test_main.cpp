@@ -0,0 +1,87 @@
+// Microbenchmark: RSSI to distance through the precomputed table against
+// evaluating the path loss model with powf() per reading, over a stream of
+// beacon RSSI values. Prints ns per reading; fails only if the two disagree
+// by more than the table's rounding.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "ConfigManager.h"
+#include "RssiDistance.h"
+
+static const size_t READINGS = 4096;
+static const int ROUNDS = 500;
+
+static std::vector<int> rssi;
+static volatile float sink;
+
+// Best of three runs, to keep scheduler noise out
+template <typename Convert>
+static double nsPerReading(Convert convert) {
+  double best = 0;
+  for (int run = 0; run < 3; run++) {
+    float total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+      for (size_t n = 0; n < READINGS; n++) {
+        total += convert(rssi[n]);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = total;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ((double)ROUNDS * READINGS);
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+void setUp(void) {
+  if (!rssi.empty()) return;
+  
+  // -40..-100 dBm, what a scanner sees in a hall
+  uint32_t state = 0x7e57;
+  rssi.resize(READINGS);
+  for (int& value : rssi) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    value = -40 - (int)(state % 61);
+  }
+  rssiDistance.rebuild();
+}
+
+void tearDown(void) {
+}
+
+void test_bench_table_against_powf(void) {
+  int txPower = ConfigManager::getTxPower();
+  float envFactor = ConfigManager::getEnvironmentalFactor();
+  float correction = ConfigManager::getDistanceCorrection();
+  
+  double modelNs = nsPerReading([&](int r) {
+    return RssiDistance::modelMeters(r, txPower, envFactor, correction);
+  });
+  double tableNs = nsPerReading([](int r) { return rssiDistance.toMeters(r); });
+  
+  char line[96];
+  snprintf(line, sizeof(line), "powf model: %.2f ns/reading", modelNs);
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "RssiDistance::toMeters: %.2f ns/reading (x%.2f)", tableNs,
+           tableNs > 0 ? modelNs / tableNs : 0.0);
+  TEST_MESSAGE(line);
+  
+  // Strong readings model to below zero with a negative correction, the
+  // table stores those as 0
+  for (size_t n = 0; n < READINGS; n++) {
+    float modelCm = RssiDistance::modelMeters(rssi[n], txPower, envFactor, correction) * 100.0f;
+    if (modelCm < 0) modelCm = 0;
+    TEST_ASSERT_FLOAT_WITHIN(0.51f, modelCm, (float)rssiDistance.toCentimeters(rssi[n]));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_table_against_powf);
+  return UNITY_END();
+}
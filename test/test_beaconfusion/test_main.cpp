@@ -0,0 +1,93 @@
+// Beacon fusion: a radar slot that goes ABSENT forgets all of its distance
+// evidence, so the next person in that slot is not named from the previous
+// one's samples.
+
+#include <unity.h>
+#include "BeaconFusion.h"
+
+static const MacKey BEACON_A = 0x02b0de000001ULL;
+static const MacKey BEACON_B = 0x02b0de000002ULL;
+
+static BeaconFusion* fusion = nullptr;
+static unsigned long nowMs = 0;
+
+static void placeBeacon(MacKey mac, float meters, unsigned long lastSeen) {
+  DeviceInfo* device = deviceTable.findOrInsert(mac, true);
+  TEST_ASSERT_TRUE(device != nullptr);
+  device->filteredDistance = meters;
+  device->lastSeen = lastSeen;
+}
+
+// Slot 0 only, at distanceCm
+static void feedFrame(TargetState state, int distanceCm) {
+  TargetSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.targets[0].state = state;
+  snapshot.targets[0].valid = state != ABSENT;
+  snapshot.targets[0].lastDistance = distanceCm;
+  fusion->onFrame(snapshot, nowMs);
+  nowMs += 100;
+}
+
+void setUp(void) {
+  deviceTable.clear();
+  nowMs = 100000;
+  fusion = new BeaconFusion();
+}
+
+void tearDown(void) {
+  delete fusion;
+  fusion = nullptr;
+}
+
+void test_absent_slot_forgets_every_column(void) {
+  // Column 0 holds a beacon not heard for a while, column 1 one at 2 m
+  placeBeacon(BEACON_A, 5.0f, nowMs - FUSION_STALE_MS - 1000);
+  placeBeacon(BEACON_B, 2.0f, nowMs);
+  
+  // Someone at 2 m who never gets confirmed: evidence for column 1 only
+  for (size_t i = 0; i < FUSION_WINDOW; i++) {
+    deviceTable.find(BEACON_B)->lastSeen = nowMs;
+    feedFrame(DEBOUNCE, 200);
+  }
+  TEST_ASSERT_EQUAL(-1, fusion->getIdentity(0).candidate);
+  feedFrame(ABSENT, 0);
+  
+  // The next person in the slot has one frame of evidence, not enough to match
+  deviceTable.find(BEACON_B)->lastSeen = nowMs;
+  feedFrame(PRESENT, 200);
+  TEST_ASSERT_EQUAL(-1, fusion->getIdentity(0).candidate);
+  
+  // Matched once the slot has its own samples
+  for (size_t i = 1; i < FUSION_MIN_SAMPLES; i++) {
+    deviceTable.find(BEACON_B)->lastSeen = nowMs;
+    feedFrame(PRESENT, 200);
+  }
+  TEST_ASSERT_EQUAL(1, fusion->getIdentity(0).candidate);
+}
+
+void test_matched_target_loses_its_name_when_absent(void) {
+  placeBeacon(BEACON_A, 2.0f, nowMs);
+  for (size_t i = 0; i < FUSION_MIN_SAMPLES + FUSION_CONFIRM_FRAMES; i++) {
+    deviceTable.find(BEACON_A)->lastSeen = nowMs;
+    feedFrame(PRESENT, 200);
+  }
+  TEST_ASSERT_TRUE(fusion->getIdentity(0).beacon == BEACON_A);
+  fusion->takeChange();
+  
+  feedFrame(ABSENT, 0);
+  TEST_ASSERT_TRUE(fusion->getIdentity(0).beacon == MAC_KEY_NONE);
+  TEST_ASSERT_EQUAL(-1, fusion->getIdentity(0).candidate);
+  TEST_ASSERT_TRUE(fusion->takeChange());
+  
+  // Staying absent is not reported again
+  feedFrame(ABSENT, 0);
+  TEST_ASSERT_FALSE(fusion->takeChange());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_absent_slot_forgets_every_column);
+  RUN_TEST(test_matched_target_loses_its_name_when_absent);
+  return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// Beacon smoothing filters: known outputs for a fixed RSSI sequence, window
+// changes and ring wrap of the moving average, and the configured and batch
+// entry points against the explicit ones.
+
+#include <unity.h>
+#include "Filters.h"
+
+// An RSSI trace with one reflection spike (-90)
+static const float TRACE[] = { -72, -68, -75, -71, -69, -70, -90, -70 };
+static const size_t TRACE_LEN = sizeof(TRACE) / sizeof(TRACE[0]);
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_kalman_known_outputs(void) {
+  // Worked by hand from the update equations, q = 0.01, r = 0.5
+  const float estimates[] = { -71.3377f, -69.9763f, -71.4817f, -71.3650f,
+                              -70.8737f, -70.7116f, -73.9997f, -73.3598f };
+  const float errors[] = { 0.33444f, 0.20394f, 0.14983f, 0.12112f,
+                           0.10388f, 0.09275f, 0.08524f, 0.08000f };
+  KalmanFilter filter(-70);
+  for (size_t i = 0; i < TRACE_LEN; i++) {
+    float estimate = filter.update(TRACE[i], 0.01f, 0.5f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, estimates[i], estimate);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, errors[i], filter.getErrorCovariance());
+  }
+}
+
+void test_kalman_settles_to_steady_state_gain(void) {
+  // Error covariance converges to (sqrt(q^2 + 4qr) - q) / 2, whatever the input
+  KalmanFilter filter(0, 10);
+  for (int i = 0; i < 500; i++) {
+    filter.update((i % 2) ? -60.0f : -80.0f, 0.01f, 0.5f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.00001f, 0.0658872f, filter.getErrorCovariance());
+  
+  filter.reset(-65);
+  TEST_ASSERT_EQUAL_FLOAT(-65, filter.getEstimate());
+  TEST_ASSERT_EQUAL_FLOAT(1, filter.getErrorCovariance());
+}
+
+void test_kalman_configured_and_batch_match_explicit(void) {
+  KalmanFilter explicitNoise(-70);
+  KalmanFilter configured(-70);
+  KalmanFilter batch(-70);
+  for (size_t i = 0; i < TRACE_LEN; i++) {
+    explicitNoise.update(TRACE[i], ConfigManager::getProcessNoise(), ConfigManager::getMeasurementNoise());
+    configured.update(TRACE[i]);
+  }
+  batch.updateBatch(TRACE, TRACE_LEN);
+  TEST_ASSERT_EQUAL_FLOAT(explicitNoise.getEstimate(), configured.getEstimate());
+  TEST_ASSERT_EQUAL_FLOAT(explicitNoise.getEstimate(), batch.getEstimate());
+  TEST_ASSERT_EQUAL_FLOAT(explicitNoise.getErrorCovariance(), batch.getErrorCovariance());
+}
+
+void test_moving_average_known_outputs(void) {
+  // Window 3: fills up, then slides
+  const float averages[] = { -72.0f, -70.0f, -71.6667f, -71.3333f,
+                             -71.6667f, -70.0f, -76.3333f, -76.6667f };
+  MovingAverageFilter filter(3);
+  for (size_t i = 0; i < TRACE_LEN; i++) {
+    float average = filter.add(TRACE[i]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, averages[i], average);
+  }
+  TEST_ASSERT_EQUAL(3, filter.size());
+}
+
+void test_moving_average_wraps_the_ring(void) {
+  // Ring of 4, window 4: every add after the fourth overwrites the oldest
+  MovingAverage<int, 4> filter;
+  const int expected[] = { 1, 1, 2, 2, 3, 4, 5, 6, 7, 8 };
+  for (int i = 1; i <= 10; i++) {
+    int average = filter.add(i);
+    TEST_ASSERT_EQUAL(expected[i - 1], average);
+  }
+  
+  // Float ring, many wraps: the per-wrap resum keeps the sum exact
+  MovingAverage<float, 4> drift;
+  for (int i = 0; i < 100000; i++) {
+    drift.add(i % 2 ? 0.1f : 1000.0f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(500.05f, drift.average());
+}
+
+void test_moving_average_window_changes(void) {
+  MovingAverage<float, 8> filter(8);
+  for (int i = 1; i <= 6; i++) {
+    filter.add((float)i);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(3.5f, filter.average());
+  
+  // Shrinking keeps the newest samples
+  filter.setWindow(2);
+  TEST_ASSERT_EQUAL(2, filter.size());
+  TEST_ASSERT_EQUAL_FLOAT(5.5f, filter.average());
+  filter.add(7);
+  TEST_ASSERT_EQUAL_FLOAT(6.5f, filter.average());
+  
+  // Growing starts from what is still in the ring
+  filter.setWindow(5);
+  TEST_ASSERT_EQUAL(5, filter.size());
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, filter.average());
+  
+  // Out-of-range windows are clamped
+  filter.setWindow(0);
+  TEST_ASSERT_EQUAL(1, filter.getWindow());
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, filter.average());
+  filter.setWindow(100);
+  TEST_ASSERT_EQUAL(8, filter.getWindow());
+  TEST_ASSERT_EQUAL_FLOAT(4.0f, filter.average());
+  
+  filter.reset();
+  TEST_ASSERT_EQUAL(0, filter.size());
+  TEST_ASSERT_EQUAL_FLOAT(0, filter.average());
+}
+
+void test_moving_average_configured_and_batch_match_explicit(void) {
+  size_t window = (size_t)ConfigManager::getWindowSize();
+  MovingAverageFilter explicitWindow(window);
+  MovingAverageFilter configured;
+  MovingAverageFilter batch(window);
+  for (size_t i = 0; i < TRACE_LEN; i++) {
+    float expected = explicitWindow.add(TRACE[i]);
+    float average = configured.addConfigured(TRACE[i]);
+    TEST_ASSERT_EQUAL_FLOAT(expected, average);
+  }
+  TEST_ASSERT_EQUAL(window, configured.getWindow());
+  batch.addBatch(TRACE, TRACE_LEN);
+  TEST_ASSERT_EQUAL_FLOAT(explicitWindow.average(), batch.average());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_kalman_known_outputs);
+  RUN_TEST(test_kalman_settles_to_steady_state_gain);
+  RUN_TEST(test_kalman_configured_and_batch_match_explicit);
+  RUN_TEST(test_moving_average_known_outputs);
+  RUN_TEST(test_moving_average_wraps_the_ring);
+  RUN_TEST(test_moving_average_window_changes);
+  RUN_TEST(test_moving_average_configured_and_batch_match_explicit);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// Heatmap export: the worst-case grid still fits in one fragmented message
+// and comes back intact through the fragment codec.
+
+#include <unity.h>
+#include <vector>
+#include "Crc16.h"
+#include "MeshFragment.h"
+#include "MeshPayload.h"
+#include "OccupancyHeatmap.h"
+
+// Cell counts from 8192 up need 3-byte varints
+static const int HITS_PER_CELL = 8192;
+
+static OccupancyHeatmap* heatmap = nullptr;
+
+static TargetInfo targetAt(int col, int row) {
+  TargetInfo target;
+  memset(&target, 0, sizeof(target));
+  target.state = PRESENT;
+  target.valid = true;
+  target.lastX = HEATMAP_X_MIN_MM + col * HEATMAP_CELL_MM + HEATMAP_CELL_MM / 2;
+  target.lastY = row * HEATMAP_CELL_MM + HEATMAP_CELL_MM / 2;
+  return target;
+}
+
+// Every cell gets HITS_PER_CELL plus its index, so no two cells are equal
+static void fillEveryCell() {
+  TargetSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  for (int cell = 0; cell < HEATMAP_CELLS; cell++) {
+    snapshot.targets[0] = targetAt(cell % HEATMAP_COLS, cell / HEATMAP_COLS);
+    for (int i = 0; i < HITS_PER_CELL + cell; i++) {
+      heatmap->onFrame(snapshot, 0);
+    }
+  }
+}
+
+static std::vector<uint16_t> decodeGrid(const uint8_t* message, size_t len) {
+  std::vector<uint16_t> cells;
+  size_t pos = HEATMAP_HEADER_SIZE;
+  while (pos < len) {
+    uint32_t value = 0;
+    for (int shift = 0; pos < len; shift += 7) {
+      uint8_t b = message[pos++];
+      value |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    if (value & 1) {
+      cells.push_back((uint16_t)(value >> 1));
+    } else {
+      cells.insert(cells.end(), value >> 1, 0);
+    }
+  }
+  return cells;
+}
+
+void setUp(void) {
+  heatmap = new OccupancyHeatmap();
+}
+
+void tearDown(void) {
+  delete heatmap;
+  heatmap = nullptr;
+}
+
+void test_empty_grid_is_one_run(void) {
+  uint8_t message[HEATMAP_EXPORT_MAX];
+  size_t len = heatmap->encodeExport(message, sizeof(message));
+  
+  TEST_ASSERT_EQUAL(HEATMAP_HEADER_SIZE + 2, len);
+  TEST_ASSERT_EQUAL_UINT8(MESH_PAYLOAD_VERSION, message[0]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_HEATMAP, message[1]);
+  TEST_ASSERT_EQUAL_UINT8(HEATMAP_COLS, message[2]);
+  TEST_ASSERT_EQUAL_UINT8(HEATMAP_ROWS, message[3]);
+  TEST_ASSERT_EQUAL_UINT8(HEATMAP_CELL_MM / 10, message[4]);
+  TEST_ASSERT_EQUAL(HEATMAP_CELLS, decodeGrid(message, len).size());
+}
+
+void test_export_needs_worst_case_buffer(void) {
+  uint8_t message[HEATMAP_EXPORT_MAX];
+  TEST_ASSERT_EQUAL(0, heatmap->encodeExport(message, sizeof(message) - 1));
+}
+
+void test_full_grid_fits_one_fragmented_message(void) {
+  fillEveryCell();
+  
+  static uint8_t message[HEATMAP_EXPORT_MAX];
+  size_t len = heatmap->encodeExport(message, sizeof(message));
+  TEST_ASSERT_EQUAL(HEATMAP_EXPORT_MAX, len);
+  TEST_ASSERT_LESS_OR_EQUAL(FRAG_MAX_MESSAGE, len);
+  TEST_ASSERT_LESS_OR_EQUAL(FRAG_MAX_COUNT, fragmentCount(len));
+  
+  // Split, then reassemble from the fragments in reverse order
+  uint16_t crc = crc16(message, len);
+  std::vector<uint8_t> rebuilt(len, 0);
+  for (int index = fragmentCount(len) - 1; index >= 0; index--) {
+    uint8_t packet[MeshProto::MAX_DATA_PAYLOAD];
+    size_t packetLen = encodeFragment(packet, sizeof(packet), 7, (uint8_t)index, message, len, crc);
+    TEST_ASSERT_GREATER_THAN(0, packetLen);
+    
+    FragmentHeader header;
+    const uint8_t* slice;
+    size_t sliceLen;
+    TEST_ASSERT_TRUE(decodeFragment(packet, packetLen, header, slice, sliceLen));
+    TEST_ASSERT_EQUAL(len, header.length);
+    memcpy(rebuilt.data() + (size_t)header.index * FRAG_DATA_SIZE, slice, sliceLen);
+  }
+  TEST_ASSERT_EQUAL_UINT16(crc, crc16(rebuilt.data(), rebuilt.size()));
+  
+  std::vector<uint16_t> cells = decodeGrid(rebuilt.data(), rebuilt.size());
+  TEST_ASSERT_EQUAL(HEATMAP_CELLS, cells.size());
+  for (int cell = 0; cell < HEATMAP_CELLS; cell++) {
+    TEST_ASSERT_EQUAL_UINT16(heatmap->getCell(cell % HEATMAP_COLS, cell / HEATMAP_COLS), cells[cell]);
+    TEST_ASSERT_EQUAL_UINT16(HITS_PER_CELL + cell, cells[cell]);
+  }
+}
+
+void test_full_grid_is_accepted_for_sending(void) {
+  fillEveryCell();
+  
+  static uint8_t message[HEATMAP_EXPORT_MAX];
+  size_t len = heatmap->encodeExport(message, sizeof(message));
+  MeshFragments fragments;
+  TEST_ASSERT_TRUE(fragments.send(0x1234, 0, message, len));
+  TEST_ASSERT_TRUE(fragments.sendPending());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_grid_is_one_run);
+  RUN_TEST(test_export_needs_worst_case_buffer);
+  RUN_TEST(test_full_grid_fits_one_fragmented_message);
+  RUN_TEST(test_full_grid_is_accepted_for_sending);
+  return UNITY_END();
+}
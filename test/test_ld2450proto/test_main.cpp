@@ -0,0 +1,143 @@
+// LD2450 frame codec: exhaustive sign-magnitude round trips over all 16-bit
+// values, and frame round trips for every slot layout.
+
+#include <unity.h>
+#include "LD2450Proto.h"
+
+using namespace LD2450Proto;
+
+// Deterministic pseudo-random values (xorshift32)
+static uint32_t rngState = 0x2450;
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+void setUp(void) {
+  rngState = 0x2450;
+}
+
+void tearDown(void) {
+}
+
+void test_every_value_survives_encode_decode(void) {
+  for (int32_t value = -32767; value <= 32767; value++) {
+    uint16_t raw = encodeSignMagnitude((int16_t)value);
+    TEST_ASSERT_EQUAL_INT16(value, decodeSignMagnitude(raw));
+    TEST_ASSERT_EQUAL(value >= 0, (raw & 0x8000) != 0);
+    TEST_ASSERT_EQUAL(value < 0 ? -value : value, raw & 0x7FFF);
+  }
+}
+
+void test_most_negative_value_saturates(void) {
+  TEST_ASSERT_EQUAL_UINT16(0x7FFF, encodeSignMagnitude(-32768));
+  TEST_ASSERT_EQUAL_INT16(-32767, decodeSignMagnitude(encodeSignMagnitude(-32768)));
+}
+
+void test_every_raw_word_survives_decode_encode(void) {
+  for (uint32_t raw = 0; raw <= 0xFFFF; raw++) {
+    int16_t value = decodeSignMagnitude((uint16_t)raw);
+    int32_t magnitude = raw & 0x7FFF;
+    TEST_ASSERT_EQUAL_INT16((raw & 0x8000) ? magnitude : -magnitude, value);
+    
+    // Negative zero (0x0000) is the only word that comes back different
+    uint16_t expected = raw == 0x0000 ? 0x8000 : (uint16_t)raw;
+    TEST_ASSERT_EQUAL_UINT16(expected, encodeSignMagnitude(value));
+  }
+}
+
+void test_known_frame_decodes(void) {
+  // Sensor datasheet example: target 1 at x = -782 mm, y = 1713 mm,
+  // speed -16 cm/s, resolution 320 mm; targets 2 and 3 empty
+  const uint8_t buf[FRAME_SIZE] = {
+    0xAA, 0xFF, 0x03, 0x00,
+    0x0E, 0x03, 0xB1, 0x86, 0x10, 0x00, 0x40, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x55, 0xCC
+  };
+  TEST_ASSERT_TRUE(isFrame(buf));
+  
+  Frame frame;
+  decodeFrame(buf, frame);
+  TEST_ASSERT_EQUAL_INT16(-782, frame.targets[0].x);
+  TEST_ASSERT_EQUAL_INT16(1713, frame.targets[0].y);
+  TEST_ASSERT_EQUAL_INT16(-16, frame.targets[0].speed);
+  TEST_ASSERT_EQUAL_UINT16(320, frame.targets[0].resolution);
+  for (size_t i = 1; i < MAX_TARGETS; i++) {
+    TEST_ASSERT_EQUAL_UINT16(0, frame.targets[i].resolution);
+  }
+  
+  uint8_t encoded[FRAME_SIZE];
+  encodeFrame(frame, encoded);
+  TEST_ASSERT_EQUAL_MEMORY(buf, encoded, FRAME_SIZE);
+}
+
+void test_random_frames_round_trip(void) {
+  for (int n = 0; n < 100000; n++) {
+    // Every combination of occupied and empty slots comes up
+    Frame in;
+    for (size_t i = 0; i < MAX_TARGETS; i++) {
+      bool occupied = (n >> i) & 1;
+      in.targets[i].x = occupied ? (int16_t)(nextRandom() % 65535 - 32767) : 0;
+      in.targets[i].y = occupied ? (int16_t)(nextRandom() % 65535 - 32767) : 0;
+      in.targets[i].speed = occupied ? (int16_t)(nextRandom() % 65535 - 32767) : 0;
+      in.targets[i].resolution = occupied ? (uint16_t)(nextRandom() % 65535 + 1) : 0;
+    }
+    
+    uint8_t buf[FRAME_SIZE];
+    encodeFrame(in, buf);
+    TEST_ASSERT_TRUE(isFrame(buf));
+    
+    Frame out;
+    decodeFrame(buf, out);
+    for (size_t i = 0; i < MAX_TARGETS; i++) {
+      TEST_ASSERT_EQUAL_INT16(in.targets[i].x, out.targets[i].x);
+      TEST_ASSERT_EQUAL_INT16(in.targets[i].y, out.targets[i].y);
+      TEST_ASSERT_EQUAL_INT16(in.targets[i].speed, out.targets[i].speed);
+      TEST_ASSERT_EQUAL_UINT16(in.targets[i].resolution, out.targets[i].resolution);
+    }
+  }
+}
+
+void test_empty_slot_is_zero_bytes(void) {
+  Frame in;
+  memset(&in, 0, sizeof(in));
+  in.targets[1].x = 100;  // Ignored: resolution 0 marks the slot empty
+  
+  uint8_t buf[FRAME_SIZE];
+  encodeFrame(in, buf);
+  for (size_t i = TARGETS_OFFSET; i < FOOTER_OFFSET; i++) {
+    TEST_ASSERT_EQUAL_UINT8(0, buf[i]);
+  }
+}
+
+void test_corrupt_framing_is_rejected(void) {
+  Frame in;
+  memset(&in, 0, sizeof(in));
+  uint8_t buf[FRAME_SIZE];
+  encodeFrame(in, buf);
+  
+  const size_t framing[] = { 0, 1, 2, 3, FOOTER_OFFSET, FOOTER_OFFSET + 1 };
+  for (size_t pos : framing) {
+    uint8_t corrupt[FRAME_SIZE];
+    memcpy(corrupt, buf, FRAME_SIZE);
+    corrupt[pos] ^= 0x01;
+    TEST_ASSERT_FALSE(isFrame(corrupt));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_value_survives_encode_decode);
+  RUN_TEST(test_most_negative_value_saturates);
+  RUN_TEST(test_every_raw_word_survives_decode_encode);
+  RUN_TEST(test_known_frame_decodes);
+  RUN_TEST(test_random_frames_round_trip);
+  RUN_TEST(test_empty_slot_is_zero_bytes);
+  RUN_TEST(test_corrupt_framing_is_rejected);
+  return UNITY_END();
+}
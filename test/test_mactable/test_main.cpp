@@ -0,0 +1,171 @@
+// Beacon table: hash spread for address patterns seen in the field, lookups
+// under churn, and the entries reserved for whitelisted beacons.
+
+#include <unity.h>
+#include "MacTable.h"
+
+static const size_t CAPACITY = 256;
+static const size_t WHITELIST = 32;
+
+struct Entry {
+  int value = 0;
+};
+
+typedef MacIndex<macSlotsFor(CAPACITY)> Index;
+
+static const MacKey VENDOR = 0x02b0de000000ULL;
+
+// Longest distance of a stored key from its home slot
+static size_t longestProbe(const Index& index) {
+  size_t longest = 0;
+  for (size_t slot = 0; slot < Index::slots(); slot++) {
+    MacKey key = index.keyAt(slot);
+    if (key == MAC_KEY_NONE) continue;
+    size_t distance = (slot - Index::home(key)) & (Index::slots() - 1);
+    if (distance > longest) longest = distance;
+  }
+  return longest;
+}
+
+static void checkSpread(MacKey stride) {
+  static Index index;
+  index.clear();
+  for (size_t i = 0; i < CAPACITY; i++) {
+    index.insert(VENDOR + 1 + i * stride, (uint16_t)i);
+  }
+  for (size_t i = 0; i < CAPACITY; i++) {
+    uint16_t value;
+    TEST_ASSERT_TRUE(index.find(VENDOR + 1 + i * stride, value));
+    TEST_ASSERT_EQUAL(i, value);
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(32, longestProbe(index));
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_sequential_addresses_spread(void) {
+  checkSpread(1);
+}
+
+void test_addresses_differing_in_upper_octets_spread(void) {
+  // Same low bits, different fourth or third octet: all of these used to
+  // share one home slot
+  checkSpread(1ULL << 16);
+  checkSpread(1ULL << 24);
+  checkSpread(1ULL << 32);
+}
+
+void test_lookups_survive_churn(void) {
+  static MacTable<Entry, CAPACITY> table;
+  table.clear();
+  
+  // Keep the table full while addresses come and go
+  uint32_t state = 0x41;
+  for (int round = 0; round < 20000; round++) {
+    state = state * 1103515245u + 12345u;
+    MacKey key = VENDOR + 1 + ((state >> 8) % 1024) * 0x10001ULL;
+    Entry* entry = table.find(key);
+    if (entry) {
+      TEST_ASSERT_EQUAL((int)(key & 0xFFFFFF), entry->value);
+      TEST_ASSERT_TRUE(table.remove(key));
+    } else {
+      entry = table.findOrInsert(key, false);
+      if (entry) entry->value = (int)(key & 0xFFFFFF);
+    }
+  }
+  size_t found = 0;
+  table.forEach([&](MacKey key, Entry& entry) {
+    TEST_ASSERT_EQUAL((int)(key & 0xFFFFFF), entry.value);
+    TEST_ASSERT_TRUE(table.find(key) == &entry);
+    found++;
+  });
+  TEST_ASSERT_EQUAL(table.size(), found);
+}
+
+void test_crowd_cannot_take_whitelisted_entries(void) {
+  static MacTable<Entry, CAPACITY> table;
+  MacSet<WHITELIST> whitelist;
+  table.clear();
+  for (size_t i = 0; i < WHITELIST; i++) {
+    whitelist.add(VENDOR + 0x100000 + i);
+  }
+  table.applyWhitelist(whitelist);
+  TEST_ASSERT_EQUAL(WHITELIST, table.reserved());
+  
+  // A busy site: far more advertisers than entries
+  size_t inserted = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    if (table.findOrInsert(0x5a0000000000ULL + i, false)) inserted++;
+  }
+  TEST_ASSERT_EQUAL(CAPACITY - WHITELIST, inserted);
+  TEST_ASSERT_EQUAL(1000 - inserted, table.getInsertFailures());
+  
+  // Every whitelisted beacon still gets its entry
+  whitelist.forEach([&](MacKey key) {
+    Entry* entry = table.findOrInsert(key, true);
+    TEST_ASSERT_TRUE(entry != nullptr);
+    TEST_ASSERT_TRUE(table.isWhitelisted(entry));
+  });
+  TEST_ASSERT_EQUAL(CAPACITY, table.size());
+  TEST_ASSERT_EQUAL(0, table.reserved());
+  TEST_ASSERT_EQUAL(0, table.getEvictions());
+}
+
+void test_whitelisted_beacon_evicts_after_whitelist_grows(void) {
+  static MacTable<Entry, CAPACITY> table;
+  MacSet<WHITELIST> whitelist;
+  table.clear();
+  table.applyWhitelist(whitelist);
+  
+  // No whitelist yet: the crowd fills every entry
+  for (size_t i = 0; i < CAPACITY; i++) {
+    TEST_ASSERT_TRUE(table.findOrInsert(0x5a0000000000ULL + i, false) != nullptr);
+  }
+  TEST_ASSERT_TRUE(table.findOrInsert(0x5a0000001000ULL, false) == nullptr);
+  
+  MacKey beacon = VENDOR + 0x100000;
+  whitelist.add(beacon);
+  table.applyWhitelist(whitelist);
+  Entry* entry = table.findOrInsert(beacon, true);
+  TEST_ASSERT_TRUE(entry != nullptr);
+  TEST_ASSERT_TRUE(table.isWhitelisted(entry));
+  TEST_ASSERT_EQUAL(1, table.getEvictions());
+  TEST_ASSERT_EQUAL(CAPACITY, table.size());
+}
+
+void test_whitelist_change_updates_reservation(void) {
+  static MacTable<Entry, CAPACITY> table;
+  MacSet<WHITELIST> whitelist;
+  table.clear();
+  MacKey beacon = VENDOR + 0x100000;
+  whitelist.add(beacon);
+  whitelist.add(beacon + 1);
+  table.applyWhitelist(whitelist);
+  TEST_ASSERT_EQUAL(2, table.reserved());
+  
+  // A tracked address that joins the whitelist stops needing a reservation
+  table.findOrInsert(beacon, false);
+  table.applyWhitelist(whitelist);
+  TEST_ASSERT_TRUE(table.isWhitelisted(table.find(beacon)));
+  TEST_ASSERT_EQUAL(1, table.reserved());
+  
+  whitelist.clear();
+  table.applyWhitelist(whitelist);
+  TEST_ASSERT_FALSE(table.isWhitelisted(table.find(beacon)));
+  TEST_ASSERT_EQUAL(0, table.reserved());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sequential_addresses_spread);
+  RUN_TEST(test_addresses_differing_in_upper_octets_spread);
+  RUN_TEST(test_lookups_survive_churn);
+  RUN_TEST(test_crowd_cannot_take_whitelisted_entries);
+  RUN_TEST(test_whitelisted_beacon_evicts_after_whitelist_grows);
+  RUN_TEST(test_whitelist_change_updates_reservation);
+  return UNITY_END();
+}
@@ -0,0 +1,147 @@
+// Exit hold of the presence engine: a PRESENT target needs exitFrames missed
+// frames and exitMs since its last detection to leave, and still leaves on
+// time when the radar stops sending frames altogether.
+
+#include <unity.h>
+#include "LD2450Manager.h"
+#include "LD2450Proto.h"
+#include "SimPlatform.h"
+
+static const unsigned long TICK_MS = LD2450Proto::FRAME_INTERVAL_MS;
+
+static LD2450Manager* manager = nullptr;
+
+// One radar frame, target 1 at 1 m straight ahead or no target at all
+static void feedFrame(bool detected) {
+  LD2450Proto::Frame frame;
+  memset(&frame, 0, sizeof(frame));
+  if (detected) {
+    frame.targets[0].y = 1000;
+    frame.targets[0].resolution = 320;
+  }
+  uint8_t buf[LD2450Proto::FRAME_SIZE];
+  LD2450Proto::encodeFrame(frame, buf);
+  Serial2.injectRx(buf, sizeof(buf));
+  manager->readSensor();
+  Sim::advanceMs(TICK_MS);
+}
+
+static void makePresent() {
+  for (int i = 0; i < 40; i++) {
+    feedFrame(true);
+  }
+  TEST_ASSERT_EQUAL(PRESENT, manager->getSnapshot()[0].state);
+}
+
+static void configureExit(unsigned long exitMs, int exitFrames) {
+  manager->setExitMs(exitMs);
+  manager->setExitFrames(exitFrames);
+  manager->publishConfig();
+}
+
+void setUp(void) {
+  while (Serial2.available()) Serial2.read();
+  manager = new LD2450Manager();
+  manager->init();
+}
+
+void tearDown(void) {
+  delete manager;
+  manager = nullptr;
+}
+
+void test_exit_after_exit_ms_of_missed_frames(void) {
+  configureExit(1500, 10);
+  makePresent();
+  
+  for (int i = 1; i < 15; i++) {
+    feedFrame(false);
+    TEST_ASSERT_EQUAL(PRESENT, manager->getSnapshot()[0].state);
+    TEST_ASSERT_TRUE(manager->getSnapshot()[0].holding);
+  }
+  feedFrame(false);
+  TEST_ASSERT_EQUAL(ABSENT, manager->getSnapshot()[0].state);
+  TEST_ASSERT_TRUE(manager->getSnapshot()[0].stateChanged);
+}
+
+void test_exit_needs_exit_frames_as_well(void) {
+  configureExit(0, 10);
+  makePresent();
+  
+  for (int i = 1; i < 10; i++) {
+    feedFrame(false);
+    TEST_ASSERT_EQUAL(PRESENT, manager->getSnapshot()[0].state);
+  }
+  feedFrame(false);
+  TEST_ASSERT_EQUAL(ABSENT, manager->getSnapshot()[0].state);
+}
+
+void test_detection_during_hold_keeps_target_present(void) {
+  configureExit(1500, 10);
+  makePresent();
+  
+  for (int i = 0; i < 12; i++) {
+    feedFrame(false);
+  }
+  feedFrame(true);
+  for (int i = 0; i < 12; i++) {
+    feedFrame(false);
+  }
+  const TargetInfo& target = manager->getSnapshot()[0];
+  TEST_ASSERT_EQUAL(PRESENT, target.state);
+  TEST_ASSERT_EQUAL(1, target.absorbedDropouts);
+}
+
+void test_exit_when_radar_goes_silent(void) {
+  configureExit(1500, 10);
+  makePresent();
+  
+  // The radar stops mid-detection; readSensor() keeps being called every loop
+  uint32_t framesBefore = manager->getSnapshot().frameCount;
+  unsigned long lastSeen = manager->getSnapshot()[0].lastSeenTime;
+  while (Sim::nowMs() - lastSeen < 1500) {
+    manager->readSensor();
+    TEST_ASSERT_EQUAL(PRESENT, manager->getSnapshot()[0].state);
+    Sim::advanceMs(10);
+  }
+  manager->readSensor();
+  
+  const TargetSnapshot& snapshot = manager->getSnapshot();
+  TEST_ASSERT_EQUAL(ABSENT, snapshot[0].state);
+  TEST_ASSERT_TRUE(snapshot[0].stateChanged);
+  TEST_ASSERT_TRUE(snapshot.anyStateChanged);
+  TEST_ASSERT_EQUAL(0, snapshot.presentCount);
+  TEST_ASSERT_EQUAL_UINT32(framesBefore + 1, snapshot.frameCount);
+  
+  // Published to other tasks, and reported only once
+  TargetSnapshot published;
+  manager->readPublishedSnapshot(published);
+  TEST_ASSERT_EQUAL(ABSENT, published[0].state);
+  Sim::advanceMs(5000);
+  manager->readSensor();
+  TEST_ASSERT_EQUAL_UINT32(framesBefore + 1, manager->getSnapshot().frameCount);
+}
+
+void test_silent_radar_still_needs_exit_frames(void) {
+  configureExit(0, 10);
+  makePresent();
+  
+  unsigned long lastFrame = Sim::nowMs() - TICK_MS;
+  while (Sim::nowMs() - lastFrame < 10 * TICK_MS) {
+    manager->readSensor();
+    TEST_ASSERT_EQUAL(PRESENT, manager->getSnapshot()[0].state);
+    Sim::advanceMs(10);
+  }
+  manager->readSensor();
+  TEST_ASSERT_EQUAL(ABSENT, manager->getSnapshot()[0].state);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_exit_after_exit_ms_of_missed_frames);
+  RUN_TEST(test_exit_needs_exit_frames_as_well);
+  RUN_TEST(test_detection_during_hold_keeps_target_present);
+  RUN_TEST(test_exit_when_radar_goes_silent);
+  RUN_TEST(test_silent_radar_still_needs_exit_frames);
+  return UNITY_END();
+}
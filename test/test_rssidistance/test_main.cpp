@@ -0,0 +1,102 @@
+// RSSI distance table: every entry within 0.5 cm of modelMeters() over the
+// whole RSSI range, for the default and extreme path loss settings, and
+// rebuilt when a config command changes them.
+
+#include <unity.h>
+#include <math.h>
+#include "ConfigManager.h"
+#include "RssiDistance.h"
+
+// Rounding to the nearest centimetre, plus float error of the model itself
+static const float MAX_ERROR_CM = 0.5f + 0.01f;
+
+static void configure(int txPower, float envFactor, float correction) {
+  char json[128];
+  snprintf(json, sizeof(json),
+           "{\"target\":\"%s\",\"tx_power\":%d,\"env_factor\":%.2f,\"distance_correction\":%.2f}",
+           ConfigManager::getGatewayID().c_str(), txPower, envFactor, correction);
+  TEST_ASSERT_TRUE(ConfigManager::processConfigCommand(String(json)));
+}
+
+// Every RSSI the table covers, plus readings outside that are clamped
+static void checkTable() {
+  int txPower = ConfigManager::getTxPower();
+  float envFactor = ConfigManager::getEnvironmentalFactor();
+  float correction = ConfigManager::getDistanceCorrection();
+  for (int rssi = RSSI_TABLE_MIN; rssi <= RSSI_TABLE_MAX; rssi++) {
+    float modelCm = RssiDistance::modelMeters(rssi, txPower, envFactor, correction) * 100.0f;
+    uint16_t cm = rssiDistance.toCentimeters(rssi);
+    if (modelCm <= 0) {
+      TEST_ASSERT_EQUAL_UINT16(0, cm);
+    } else if (modelCm >= RSSI_DISTANCE_MAX_CM) {
+      TEST_ASSERT_EQUAL_UINT16(RSSI_DISTANCE_MAX_CM, cm);
+    } else {
+      TEST_ASSERT_FLOAT_WITHIN(MAX_ERROR_CM, modelCm, (float)cm);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(cm * 0.01f, rssiDistance.toMeters(rssi));
+  }
+  TEST_ASSERT_EQUAL_UINT16(rssiDistance.toCentimeters(RSSI_TABLE_MIN), rssiDistance.toCentimeters(-200));
+  TEST_ASSERT_EQUAL_UINT16(rssiDistance.toCentimeters(RSSI_TABLE_MAX), rssiDistance.toCentimeters(20));
+}
+
+void setUp(void) {
+  rssiDistance.rebuild();
+}
+
+void tearDown(void) {
+}
+
+void test_default_settings_within_half_a_centimetre(void) {
+  checkTable();
+}
+
+void test_extreme_settings_within_half_a_centimetre(void) {
+  const int txPowers[] = { -100, -59, 20 };
+  const float envFactors[] = { 1.5f, 2.7f, 4.0f };
+  const float corrections[] = { -2.0f, 0.0f, 2.0f };
+  for (int txPower : txPowers) {
+    for (float envFactor : envFactors) {
+      for (float correction : corrections) {
+        configure(txPower, envFactor, correction);
+        checkTable();
+      }
+    }
+  }
+}
+
+void test_table_is_monotonic(void) {
+  // Weaker signal never reads as closer
+  configure(-59, 2.7f, -0.5f);
+  for (int rssi = RSSI_TABLE_MIN; rssi < RSSI_TABLE_MAX; rssi++) {
+    TEST_ASSERT_TRUE(rssiDistance.toCentimeters(rssi) >= rssiDistance.toCentimeters(rssi + 1));
+  }
+  // 1 m at the calibrated power, less the correction
+  TEST_ASSERT_EQUAL_UINT16(50, rssiDistance.toCentimeters(-59));
+}
+
+void test_config_change_rebuilds_once(void) {
+  configure(-59, 2.7f, -0.5f);
+  unsigned long before = rssiDistance.getRebuilds();
+  uint16_t cm = rssiDistance.toCentimeters(-80);
+  
+  // All three settings in one command cost one rebuild
+  configure(-65, 3.0f, 0.0f);
+  TEST_ASSERT_EQUAL(before + 1, rssiDistance.getRebuilds());
+  TEST_ASSERT_TRUE(rssiDistance.toCentimeters(-80) != cm);
+  checkTable();
+  
+  // Out-of-range values are refused and leave the table alone
+  char json[96];
+  snprintf(json, sizeof(json), "{\"target\":\"%s\",\"env_factor\":9.0}", ConfigManager::getGatewayID().c_str());
+  ConfigManager::processConfigCommand(String(json));
+  TEST_ASSERT_EQUAL(before + 1, rssiDistance.getRebuilds());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_default_settings_within_half_a_centimetre);
+  RUN_TEST(test_extreme_settings_within_half_a_centimetre);
+  RUN_TEST(test_table_is_monotonic);
+  RUN_TEST(test_config_change_rebuilds_once);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+// SeqLock under contention: one writer publishing TargetSnapshots as fast as
+// it can while several readers copy them. Every field of a published
+// snapshot is derived from its frame number, so a torn copy shows up as a
+// field that disagrees with frameCount.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "LD2450Manager.h"
+#include "SeqLock.h"
+
+static const uint32_t WRITES = 5000000;
+static const int READERS = 3;
+
+static void fillSnapshot(TargetSnapshot& snapshot, uint32_t frame) {
+  memset(&snapshot, 0, sizeof(snapshot));
+  for (int i = 0; i < TargetSnapshot::capacity(); i++) {
+    TargetInfo& t = snapshot.targets[i];
+    t.stateChangeTime = frame + i;
+    t.lastX = (int)frame * 3 + i;
+    t.lastY = -(int)frame + i;
+    t.lastDistance = (int)(frame % 601);
+    t.hitFrames = (uint16_t)frame;
+    t.missFrames = (uint16_t)~frame;
+    t.lastSeenTime = frame;
+    t.flaps = frame ^ 0x5A5A5A5Au;
+  }
+  snapshot.closestDistanceCm = (int)(frame % 601);
+  snapshot.presentCount = (int)(frame % 4);
+  snapshot.frameCount = frame;
+}
+
+static bool isConsistent(const TargetSnapshot& snapshot) {
+  TargetSnapshot expected;
+  fillSnapshot(expected, snapshot.frameCount);
+  return memcmp(&expected, &snapshot, sizeof(snapshot)) == 0;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_read_returns_last_write(void) {
+  SeqLock<TargetSnapshot> lock;
+  TargetSnapshot in;
+  TargetSnapshot out;
+  fillSnapshot(in, 42);
+  lock.write(in);
+  
+  TEST_ASSERT_EQUAL_UINT32(2, lock.read(out));
+  TEST_ASSERT_EQUAL_UINT32(1, lock.version());
+  TEST_ASSERT_EQUAL_MEMORY(&in, &out, sizeof(in));
+}
+
+void test_concurrent_readers_never_see_torn_snapshot(void) {
+  SeqLock<TargetSnapshot> lock;
+  std::atomic<bool> done(false);
+  std::atomic<unsigned long> torn(0);
+  std::atomic<unsigned long> backwards(0);
+  std::vector<unsigned long> reads(READERS, 0);
+  
+  TargetSnapshot first;
+  fillSnapshot(first, 0);
+  lock.write(first);
+  
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&, r]() {
+      TargetSnapshot copy;
+      uint32_t lastSeq = 0;
+      do {
+        uint32_t seq = lock.read(copy);
+        if (!isConsistent(copy) || seq != (copy.frameCount + 1) * 2) torn++;
+        if (seq < lastSeq) backwards++;
+        lastSeq = seq;
+        reads[r]++;
+      } while (!done.load(std::memory_order_acquire));
+    });
+  }
+  
+  std::thread writer([&]() {
+    TargetSnapshot snapshot;
+    for (uint32_t frame = 1; frame < WRITES; frame++) {
+      fillSnapshot(snapshot, frame);
+      lock.write(snapshot);
+    }
+    done.store(true, std::memory_order_release);
+  });
+  
+  writer.join();
+  for (std::thread& t : readers) t.join();
+  
+  TEST_ASSERT_EQUAL_UINT32(WRITES, lock.version());
+  TEST_ASSERT_EQUAL(0, torn.load());
+  TEST_ASSERT_EQUAL(0, backwards.load());
+  for (int r = 0; r < READERS; r++) {
+    TEST_ASSERT_GREATER_THAN(0, reads[r]);
+  }
+  
+  TargetSnapshot last;
+  lock.read(last);
+  TEST_ASSERT_EQUAL_UINT32(WRITES - 1, last.frameCount);
+  TEST_ASSERT_TRUE(isConsistent(last));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_returns_last_write);
+  RUN_TEST(test_concurrent_readers_never_see_torn_snapshot);
+  return UNITY_END();
+}
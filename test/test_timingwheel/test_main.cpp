@@ -0,0 +1,219 @@
+// Beacon expiry wheel: level 1 cascades, deadlines parked beyond level 1 and
+// the 32-bit millis() wrap, then a randomized run checking that every timer
+// fires exactly once, never early and within one tick.
+
+#include <unity.h>
+#include "TimingWheel.h"
+
+static const size_t TIMERS = 200;
+static const unsigned long TICK_MS = 100;
+
+typedef TimingWheel<TIMERS, TICK_MS> Wheel;
+
+// Level 1 reaches 64 * 64 ticks
+static const uint32_t LEVEL1_MS = 64 * 64 * TICK_MS;
+
+// One minute before millis() wraps
+static const uint32_t NEAR_WRAP = 0xFFFFFFFFu - 60000;
+
+// Deterministic pseudo-random values (xorshift32)
+static uint32_t rngState = 0x7133;
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+// What the test expects of each timer
+struct Expected {
+  bool armed;
+  uint32_t dueMs;     // Not before
+  uint32_t latestMs;  // Must have fired by the first advance() at or after
+};
+
+static Wheel* wheel = nullptr;
+static Expected expected[TIMERS];
+static uint32_t nowMs = 0;
+static size_t armed = 0;
+static size_t fires = 0;
+
+static bool notBefore(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) >= 0;
+}
+
+static void arm(size_t id, uint32_t dueMs) {
+  if (!expected[id].armed) armed++;
+  expected[id].armed = true;
+  expected[id].dueMs = dueMs;
+  // A deadline in the past fires on the next tick
+  expected[id].latestMs = (notBefore(dueMs, nowMs) ? dueMs : nowMs) + TICK_MS;
+  wheel->schedule(id, dueMs);
+}
+
+static void disarm(size_t id) {
+  if (expected[id].armed) armed--;
+  expected[id].armed = false;
+  wheel->cancel(id);
+}
+
+// Advance to `to`; onFire() runs inside the wheel callback and may re-arm
+// the timer that just fired
+template <typename OnFire>
+static void advanceTo(uint32_t to, OnFire onFire) {
+  uint32_t previousMs = nowMs;
+  nowMs = to;
+  wheel->advance(nowMs, [&](size_t id) {
+    TEST_ASSERT_TRUE(id < TIMERS);
+    Expected& e = expected[id];
+    TEST_ASSERT_TRUE(e.armed);
+    TEST_ASSERT_TRUE(notBefore(nowMs, e.dueMs));
+    TEST_ASSERT_FALSE(notBefore(previousMs, e.latestMs));
+    TEST_ASSERT_FALSE(wheel->isScheduled(id));
+    e.armed = false;
+    armed--;
+    fires++;
+    onFire(id);
+  });
+  TEST_ASSERT_EQUAL(armed, wheel->size());
+}
+
+static void advanceTo(uint32_t to) {
+  advanceTo(to, [](size_t) {});
+}
+
+// Step in small increments, as loop() does, until `to`
+static void stepTo(uint32_t to, uint32_t stepMs) {
+  while ((int32_t)(to - nowMs) > 0) {
+    uint32_t step = (int32_t)(to - nowMs) < (int32_t)stepMs ? to - nowMs : stepMs;
+    advanceTo(nowMs + step);
+  }
+}
+
+static void startAt(uint32_t startMs) {
+  delete wheel;
+  wheel = new Wheel(startMs);
+  nowMs = startMs;
+  armed = 0;
+  fires = 0;
+  for (Expected& e : expected) {
+    e.armed = false;
+  }
+}
+
+void setUp(void) {
+  rngState = 0x7133;
+  startAt(0);
+}
+
+void tearDown(void) {
+  delete wheel;
+  wheel = nullptr;
+}
+
+void test_level0_timer_fires_on_its_tick(void) {
+  arm(0, nowMs + 250);
+  stepTo(nowMs + 200, 10);
+  TEST_ASSERT_TRUE(wheel->isScheduled(0));
+  stepTo(nowMs + 100, 10);
+  TEST_ASSERT_EQUAL(1, fires);
+}
+
+void test_level1_timers_cascade(void) {
+  // One timer in every level 1 bucket, off tick boundaries
+  for (size_t i = 0; i < 64; i++) {
+    arm(i, nowMs + 6400 + (uint32_t)i * 6400 + 37);
+  }
+  stepTo(nowMs + LEVEL1_MS + 6400, 50);
+  TEST_ASSERT_EQUAL(64, fires);
+  TEST_ASSERT_EQUAL(0, wheel->size());
+}
+
+void test_far_deadlines_are_parked(void) {
+  // Beyond level 1: parked, re-filed and still on time
+  arm(0, nowMs + LEVEL1_MS + 1234);
+  arm(1, nowMs + 3 * LEVEL1_MS + 99);
+  arm(2, nowMs + 10 * LEVEL1_MS);
+  stepTo(nowMs + 11 * LEVEL1_MS, 100);
+  TEST_ASSERT_EQUAL(3, fires);
+}
+
+void test_past_deadline_fires_on_next_tick(void) {
+  stepTo(nowMs + 1000, 100);
+  arm(0, nowMs - 500);
+  advanceTo(nowMs + TICK_MS);
+  TEST_ASSERT_EQUAL(1, fires);
+}
+
+void test_clock_wraps(void) {
+  startAt(NEAR_WRAP);
+  arm(0, NEAR_WRAP + 59000);                  // Before the wrap
+  arm(1, NEAR_WRAP + 61000);                  // Just after
+  arm(2, NEAR_WRAP + 2 * LEVEL1_MS);          // Parked across the wrap
+  stepTo(NEAR_WRAP + 2 * LEVEL1_MS + TICK_MS, 20);
+  TEST_ASSERT_EQUAL(3, fires);
+}
+
+void test_large_jump_fires_everything_due(void) {
+  for (size_t i = 0; i < TIMERS; i++) {
+    arm(i, nowMs + (uint32_t)(i * 997) % (2 * LEVEL1_MS));
+  }
+  // One advance() across several cascades, as after a long blocking call
+  advanceTo(nowMs + 2 * LEVEL1_MS + TICK_MS);
+  TEST_ASSERT_EQUAL(TIMERS, fires);
+}
+
+void test_randomized_schedule_cancel_advance(void) {
+  startAt(NEAR_WRAP - LEVEL1_MS);
+  for (long op = 0; op < 2000000; op++) {
+    uint32_t r = nextRandom();
+    size_t id = (r >> 8) % TIMERS;
+    switch (r % 8) {
+      case 0:
+      case 1:
+      case 2: {
+        // Mostly beacon-like timeouts, some beyond level 1, a few overdue
+        uint32_t kind = (r >> 16) % 16;
+        uint32_t delay = nextRandom() % (kind == 0 ? 3 * LEVEL1_MS : kind < 4 ? LEVEL1_MS : 60000);
+        arm(id, kind == 15 ? nowMs - delay % 5000 : nowMs + delay);
+        break;
+      }
+      case 3:
+        disarm(id);
+        break;
+      case 4:
+        // Jump, as after a slow loop pass
+        advanceTo(nowMs + nextRandom() % 20000);
+        break;
+      case 5:
+        // Periodic timers re-arm from their callback
+        advanceTo(nowMs + nextRandom() % 300, [](size_t fired) {
+          if (fired % 4 == 0) arm(fired, nowMs + 1000 + fired);
+        });
+        break;
+      default:
+        advanceTo(nowMs + nextRandom() % 50);
+        break;
+    }
+    TEST_ASSERT_EQUAL(expected[id].armed, wheel->isScheduled(id));
+  }
+  
+  // Run out every remaining deadline
+  stepTo(nowMs + 3 * LEVEL1_MS + TICK_MS, 1000);
+  TEST_ASSERT_EQUAL(0, armed);
+  TEST_ASSERT_EQUAL(0, wheel->size());
+  TEST_ASSERT_GREATER_THAN(100000, fires);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_level0_timer_fires_on_its_tick);
+  RUN_TEST(test_level1_timers_cascade);
+  RUN_TEST(test_far_deadlines_are_parked);
+  RUN_TEST(test_past_deadline_fires_on_next_tick);
+  RUN_TEST(test_clock_wraps);
+  RUN_TEST(test_large_jump_fires_everything_due);
+  RUN_TEST(test_randomized_schedule_cancel_advance);
+  return UNITY_END();
+}
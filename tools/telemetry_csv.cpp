@@ -0,0 +1,107 @@
+// Host decoder for the gateway's binary USB telemetry (TelemetryProto.h):
+// reads the COBS-framed stream from a capture file, a serial device or
+// stdin and writes one CSV row per target and frame to stdout. Text log
+// lines and corrupt records are skipped; a summary goes to stderr.
+//
+//   g++ -std=c++11 -O2 -Isrc tools/telemetry_csv.cpp -o telemetry_csv
+//   stty -F /dev/ttyACM0 115200 raw && ./telemetry_csv /dev/ttyACM0 > run.csv
+//
+// Stop a live capture with Ctrl-C; rows are flushed as they arrive when the
+// input is a terminal device.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "TelemetryProto.h"
+
+namespace {
+
+const char* const STATE_NAMES[] = {"absent", "debounce", "present"};
+
+struct DecodeStats {
+  unsigned long records;
+  unsigned long rejected;     // Text lines and corrupt records
+  unsigned long lostFrames;   // Gaps in the frame counter
+  unsigned long dropped;      // Dropped on the device, from the last record
+};
+
+void writeRecord(const TelemetryProto::FrameRecord& record) {
+  for (int i = 0; i < record.count; i++) {
+    const TelemetryProto::TargetSample& t = record.targets[i];
+    printf("%lu,%lu,%u,%u,%d,%d,%d,%d,%u,%u,%s,%d,%d,%d,%u,%u,%u\n",
+           (unsigned long)record.frame, (unsigned long)record.timeMs, record.parseUs, record.backlog,
+           i + 1, t.x, t.y, t.speed, t.resolution, t.distanceCm,
+           t.state < 3 ? STATE_NAMES[t.state] : "?",
+           (t.flags & TelemetryProto::FLAG_VALID) ? 1 : 0,
+           (t.flags & TelemetryProto::FLAG_CHANGED) ? 1 : 0,
+           (t.flags & TelemetryProto::FLAG_HOLDING) ? 1 : 0,
+           t.hitFrames, t.missFrames, t.timeToZoneDs);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 2 || (argc == 2 && strcmp(argv[1], "-h") == 0)) {
+    fprintf(stderr, "usage: %s [CAPTURE_FILE | SERIAL_DEVICE | -]\n", argv[0]);
+    return 1;
+  }
+  
+  FILE* in = stdin;
+  if (argc == 2 && strcmp(argv[1], "-") != 0) {
+    in = fopen(argv[1], "rb");
+    if (!in) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  bool live = isatty(fileno(in));
+  
+  printf("frame,time_ms,parse_us,backlog,target,x_mm,y_mm,speed_cms,resolution,distance_cm,"
+         "state,valid,changed,holding,hit_frames,miss_frames,ttz_ds\n");
+  
+  DecodeStats stats = {0, 0, 0, 0};
+  uint32_t lastFrame = 0;
+  
+  // Longer frames are text or garbage; they are counted and skipped
+  uint8_t frame[TelemetryProto::MAX_WIRE_SIZE];
+  size_t frameLen = 0;
+  bool overflow = false;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (c != 0) {
+      if (frameLen < sizeof(frame)) {
+        frame[frameLen++] = (uint8_t)c;
+      } else {
+        overflow = true;
+      }
+      continue;
+    }
+    
+    // Delimiter: decode what came before it
+    if (frameLen > 0 || overflow) {
+      uint8_t raw[TelemetryProto::MAX_RECORD_SIZE];
+      size_t rawLen = overflow ? 0 : TelemetryProto::cobsDecode(frame, frameLen, raw, sizeof(raw));
+      TelemetryProto::FrameRecord record;
+      if (rawLen > 0 && TelemetryProto::decodeRecord(raw, rawLen, record)) {
+        if (stats.records > 0 && record.frame > lastFrame + 1) {
+          stats.lostFrames += record.frame - lastFrame - 1;
+        }
+        lastFrame = record.frame;
+        stats.dropped = record.dropped;
+        stats.records++;
+        writeRecord(record);
+        if (live) fflush(stdout);
+      } else {
+        stats.rejected++;
+      }
+    }
+    frameLen = 0;
+    overflow = false;
+  }
+  
+  if (in != stdin) fclose(in);
+  fprintf(stderr, "%lu records, %lu frames missing (%lu dropped on the device), %lu non-record frames skipped\n",
+          stats.records, stats.lostFrames, stats.dropped, stats.rejected);
+  return 0;
+}